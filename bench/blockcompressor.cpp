@@ -0,0 +1,338 @@
+// Throughput of BlockCompressor per format and quality, in MB of RGBA8 input
+// per second over all threads and per core, and its PSNR next to the PSNR
+// of a slow reference encoder. The reference searches single channels
+// exhaustively between the block minimum and maximum widened by 16, and
+// BC1 colors over every pair of quantized block colors and bounding box
+// corners, followed by moving single endpoint channels by one while that
+// lowers the error. Without arguments a synthetic image with gradients,
+// waves, hard edges and noise is used.
+//
+//     gtl_bench_blockcompressor [<raw RGBA8 file> <width> <height>]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <vector>
+
+#include "gtl/ogl/blockcompressor.h"
+
+using namespace gtl::ogl;
+
+namespace {
+
+typedef BlockCompressor::Format Format;
+typedef BlockCompressor::Quality Quality;
+
+std::vector<std::uint8_t> makeImage(int width, int height)
+{
+	std::vector<std::uint8_t> pixels(static_cast<std::size_t>(width) * height * 4);
+	std::uint32_t seed = 1;
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x) {
+			int color[4] = {
+				x * 255 / std::max(width - 1, 1),
+				static_cast<int>(128.0 + 100.0 * std::sin(x * 0.05) * std::cos(y * 0.07)),
+				((x / 32 + y / 32) % 2) ? 220 : 30,
+				y * 255 / std::max(height - 1, 1)
+			};
+			for (int c = 0; c < 4; ++c) {
+				seed = seed * 1664525u + 1013904223u;
+				int noise = static_cast<int>(seed >> 28) - 8;
+				pixels[(static_cast<std::size_t>(y) * width + x) * 4 + c] = static_cast<std::uint8_t>(std::min(std::max(color[c] + noise, 0), 255));
+			}
+		}
+	}
+	return pixels;
+}
+
+void getBlock(const std::vector<std::uint8_t> &pixels, int width, int height, int bx, int by, std::uint8_t *block)
+{
+	for (int y = 0; y < 4; ++y) {
+		for (int x = 0; x < 4; ++x) {
+			int sx = std::min(bx + x, width - 1);
+			int sy = std::min(by + y, height - 1);
+			std::copy(&pixels[(static_cast<std::size_t>(sy) * width + sx) * 4], &pixels[(static_cast<std::size_t>(sy) * width + sx) * 4] + 4, block + (y * 4 + x) * 4);
+		}
+	}
+}
+
+// Same palette as BlockCompressor::decompress() uses.
+void getSinglePalette(int v0, int v1, int *palette)
+{
+	palette[0] = v0;
+	palette[1] = v1;
+	if (v0 > v1) {
+		for (int i = 1; i < 7; ++i) {
+			palette[i + 1] = ((7 - i) * v0 + i * v1 + 3) / 7;
+		}
+	} else {
+		for (int i = 1; i < 5; ++i) {
+			palette[i + 1] = ((5 - i) * v0 + i * v1 + 2) / 5;
+		}
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+int getSingleError(const int *values, int v0, int v1, int limit, std::uint64_t *indices)
+{
+	int palette[8];
+	getSinglePalette(v0, v1, palette);
+	int error = 0;
+	for (int i = 0; i < 16 && error < limit; ++i) {
+		int best = std::numeric_limits<int>::max();
+		int bestIndex = 0;
+		for (int k = 0; k < 8; ++k) {
+			int d = values[i] - palette[k];
+			if (d * d < best) {
+				best = d * d;
+				bestIndex = k;
+			}
+		}
+		error += best;
+		if (indices != nullptr) {
+			*indices |= static_cast<std::uint64_t>(bestIndex) << (3 * i);
+		}
+	}
+	return error;
+}
+
+void encodeSingle(const std::uint8_t *block, int channel, std::uint8_t *output)
+{
+	int values[16];
+	int low = 255;
+	int high = 0;
+	for (int i = 0; i < 16; ++i) {
+		values[i] = block[i * 4 + channel];
+		low = std::min(low, values[i]);
+		high = std::max(high, values[i]);
+	}
+	low = std::max(low - 16, 0);
+	high = std::min(high + 16, 255);
+
+	int best = std::numeric_limits<int>::max();
+	int best0 = 0;
+	int best1 = 0;
+	for (int v0 = low; v0 <= high && best != 0; ++v0) {
+		for (int v1 = low; v1 <= high; ++v1) {
+			int error = getSingleError(values, v0, v1, best, nullptr);
+			if (error < best) {
+				best = error;
+				best0 = v0;
+				best1 = v1;
+			}
+		}
+	}
+	std::uint64_t indices = 0;
+	getSingleError(values, best0, best1, std::numeric_limits<int>::max(), &indices);
+	output[0] = static_cast<std::uint8_t>(best0);
+	output[1] = static_cast<std::uint8_t>(best1);
+	for (int i = 0; i < 6; ++i) {
+		output[2 + i] = static_cast<std::uint8_t>(indices >> (8 * i));
+	}
+}
+
+std::uint16_t pack565(const int *q)
+{
+	return static_cast<std::uint16_t>((q[0] << 11) | (q[1] << 5) | q[2]);
+}
+
+// Same palette as BlockCompressor::decompress() uses; c0 > c1 selects four
+// colors.
+void getColorPalette(std::uint16_t c0, std::uint16_t c1, int *palette)
+{
+	int a[3] = { (c0 >> 11) & 31, (c0 >> 5) & 63, c0 & 31 };
+	int b[3] = { (c1 >> 11) & 31, (c1 >> 5) & 63, c1 & 31 };
+	a[0] = (a[0] << 3) | (a[0] >> 2); a[1] = (a[1] << 2) | (a[1] >> 4); a[2] = (a[2] << 3) | (a[2] >> 2);
+	b[0] = (b[0] << 3) | (b[0] >> 2); b[1] = (b[1] << 2) | (b[1] >> 4); b[2] = (b[2] << 3) | (b[2] >> 2);
+	for (int c = 0; c < 3; ++c) {
+		palette[0 + c] = a[c];
+		palette[3 + c] = b[c];
+		if (c0 > c1) {
+			palette[6 + c] = (2 * a[c] + b[c]) / 3;
+			palette[9 + c] = (a[c] + 2 * b[c]) / 3;
+		} else {
+			palette[6 + c] = (a[c] + b[c]) / 2;
+			palette[9 + c] = 0;
+		}
+	}
+}
+
+// Endpoints are ordered so that BC1 decodes four colors unless they are
+// equal; BC3 always decodes four colors, which gives the same palette then.
+int getColorError(const std::uint8_t *block, const int *q0, const int *q1, std::uint16_t &c0, std::uint16_t &c1, std::uint32_t *indices)
+{
+	c0 = pack565(q0);
+	c1 = pack565(q1);
+	if (c0 < c1) {
+		std::swap(c0, c1);
+	}
+	int palette[12];
+	getColorPalette(c0, c1, palette);
+	int error = 0;
+	for (int i = 0; i < 16; ++i) {
+		int best = std::numeric_limits<int>::max();
+		int bestIndex = 0;
+		for (int k = 0; k < 4; ++k) {
+			int d = 0;
+			for (int c = 0; c < 3; ++c) {
+				int v = block[i * 4 + c] - palette[k * 3 + c];
+				d += v * v;
+			}
+			if (d < best) {
+				best = d;
+				bestIndex = k;
+			}
+		}
+		error += best;
+		if (indices != nullptr) {
+			*indices |= static_cast<std::uint32_t>(bestIndex) << (2 * i);
+		}
+	}
+	return error;
+}
+
+void encodeColor(const std::uint8_t *block, std::uint8_t *output)
+{
+	static const int maxima[3] = { 31, 63, 31 };
+	std::vector<std::vector<int>> candidates;
+	int low[3] = { 255, 255, 255 };
+	int high[3] = { 0, 0, 0 };
+	for (int i = 0; i < 16; ++i) {
+		std::vector<int> q(3);
+		for (int c = 0; c < 3; ++c) {
+			q[c] = (block[i * 4 + c] * maxima[c] + 127) / 255;
+			low[c] = std::min(low[c], q[c]);
+			high[c] = std::max(high[c], q[c]);
+		}
+		candidates.push_back(q);
+	}
+	candidates.push_back(std::vector<int>(low, low + 3));
+	candidates.push_back(std::vector<int>(high, high + 3));
+
+	int best = std::numeric_limits<int>::max();
+	int q[2][3] = {};
+	std::uint16_t c0, c1;
+	for (std::size_t i = 0; i < candidates.size(); ++i) {
+		for (std::size_t j = i; j < candidates.size(); ++j) {
+			int error = getColorError(block, candidates[i].data(), candidates[j].data(), c0, c1, nullptr);
+			if (error < best) {
+				best = error;
+				std::copy(candidates[i].begin(), candidates[i].end(), q[0]);
+				std::copy(candidates[j].begin(), candidates[j].end(), q[1]);
+			}
+		}
+	}
+
+	for (bool improved = true; improved && best != 0; ) {
+		improved = false;
+		for (int e = 0; e < 2; ++e) {
+			for (int c = 0; c < 3; ++c) {
+				for (int step = -1; step <= 1; step += 2) {
+					int old = q[e][c];
+					q[e][c] = std::min(std::max(old + step, 0), maxima[c]);
+					int error = getColorError(block, q[0], q[1], c0, c1, nullptr);
+					if (error < best) {
+						best = error;
+						improved = true;
+					} else {
+						q[e][c] = old;
+					}
+				}
+			}
+		}
+	}
+
+	std::uint32_t indices = 0;
+	getColorError(block, q[0], q[1], c0, c1, &indices);
+	output[0] = static_cast<std::uint8_t>(c0);
+	output[1] = static_cast<std::uint8_t>(c0 >> 8);
+	output[2] = static_cast<std::uint8_t>(c1);
+	output[3] = static_cast<std::uint8_t>(c1 >> 8);
+	for (int i = 0; i < 4; ++i) {
+		output[4 + i] = static_cast<std::uint8_t>(indices >> (8 * i));
+	}
+}
+
+void encodeReference(Format format, const std::vector<std::uint8_t> &pixels, int width, int height, std::vector<std::uint8_t> &blocks)
+{
+	std::size_t blockSize = BlockCompressor::getBlockSize(format);
+	blocks.resize(BlockCompressor::getCompressedSize(format, width, height));
+	std::uint8_t *output = blocks.data();
+	for (int by = 0; by < height; by += 4) {
+		for (int bx = 0; bx < width; bx += 4, output += blockSize) {
+			std::uint8_t block[64];
+			getBlock(pixels, width, height, bx, by, block);
+			switch (format) {
+			case Format::BC1:
+				encodeColor(block, output);
+				break;
+			case Format::BC3:
+				encodeSingle(block, 3, output);
+				encodeColor(block, output + 8);
+				break;
+			case Format::BC4:
+				encodeSingle(block, 0, output);
+				break;
+			case Format::BC5:
+				encodeSingle(block, 0, output);
+				encodeSingle(block, 1, output + 8);
+				break;
+			}
+		}
+	}
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	int width = 512;
+	int height = 512;
+	std::vector<std::uint8_t> pixels;
+	if (argc >= 4) {
+		width = std::atoi(argv[2]);
+		height = std::atoi(argv[3]);
+		pixels.resize(static_cast<std::size_t>(std::max(width, 0)) * std::max(height, 0) * 4);
+		std::ifstream stream(argv[1], std::ios::binary);
+		if (width <= 0 || height <= 0 || !stream.read(reinterpret_cast<char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()))) {
+			std::fprintf(stderr, "Cannot read %dx%d RGBA8 pixels from %s\n", width, height, argv[1]);
+			return 1;
+		}
+	} else if (argc == 1) {
+		pixels = makeImage(width, height);
+	} else {
+		std::fprintf(stderr, "Usage: %s [<raw RGBA8 file> <width> <height>]\n", argv[0]);
+		return 1;
+	}
+
+	BlockCompressor compressor;
+	std::printf("%dx%d RGBA8, %u threads\n", width, height, std::thread::hardware_concurrency());
+	std::printf("%-6s %-8s %10s %12s %10s %10s\n", "format", "quality", "MB/s", "MB/s/core", "PSNR", "ref PSNR");
+	const Format formats[] = { Format::BC1, Format::BC3, Format::BC4, Format::BC5 };
+	const char *formatNames[] = { "BC1", "BC3", "BC4", "BC5" };
+	const Quality qualities[] = { Quality::FAST, Quality::NORMAL, Quality::HIGH };
+	const char *qualityNames[] = { "FAST", "NORMAL", "HIGH" };
+	std::vector<std::uint8_t> blocks;
+	for (int f = 0; f < 4; ++f) {
+		encodeReference(formats[f], pixels, width, height, blocks);
+		double reference = BlockCompressor::getPsnr(formats[f], pixels.data(), width, height, 0, blocks.data());
+		for (int q = 0; q < 3; ++q) {
+			compressor.resetStats();
+			auto start = std::chrono::steady_clock::now();
+			do {
+				compressor.compress(formats[f], qualities[q], pixels.data(), width, height, 0, blocks);
+			} while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(300));
+			const BlockCompressor::Stats &stats = compressor.getStats();
+			double psnr = BlockCompressor::getPsnr(formats[f], pixels.data(), width, height, 0, blocks.data());
+			std::printf("%-6s %-8s %10.1f %12.1f %10.2f %10.2f\n", formatNames[f], qualityNames[q],
+				stats.getThroughput(), stats.getThroughputPerCore(), psnr, reference);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,154 @@
+// Compares two ways to hand the images of a KTX2 or DDS file to the driver:
+// straight from the mapping of TextureFile, and from a std::vector which the
+// whole file was read into first. There is no context, so the copy which
+// the driver makes of client memory in setSubImage() is stood in for by a
+// memcpy of every image into a reused buffer. Each path runs in a process
+// of its own, so the peak RSS reported by getrusage() belongs to it alone.
+//
+//     gtl_bench_textureloader <file> [repeats]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "gtl/ogl/textureloader.h"
+
+using namespace gtl::ogl;
+
+namespace {
+
+struct Result {
+	double milliseconds;
+	double peakMegabytes;
+};
+
+volatile std::uint8_t sink;
+
+void upload(const TextureFile &file, const std::uint8_t *data, std::vector<std::uint8_t> &scratch)
+{
+	for (const TextureFile::Image &image : file.getImages()) {
+		if (scratch.size() < image.size) {
+			scratch.resize(image.size);
+		}
+		std::memcpy(scratch.data(), data + image.offset, image.size);
+		sink = scratch[image.size - 1];
+	}
+}
+
+bool loadMapped(const char *path, std::vector<std::uint8_t> &scratch)
+{
+	TextureFile file(path);
+	if (!file) {
+		return false;
+	}
+	upload(file, static_cast<const std::uint8_t*>(file.getData()), scratch);
+	return true;
+}
+
+bool loadVector(const char *path, std::vector<std::uint8_t> &scratch)
+{
+	std::ifstream stream(path, std::ios::binary | std::ios::ate);
+	if (!stream) {
+		return false;
+	}
+	std::vector<std::uint8_t> data(static_cast<std::size_t>(stream.tellg()));
+	stream.seekg(0);
+	if (!stream.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()))) {
+		return false;
+	}
+	// TextureFile only reads the headers here; the images come from the vector.
+	TextureFile file(path);
+	if (!file) {
+		return false;
+	}
+	upload(file, data.data(), scratch);
+	return true;
+}
+
+bool run(const char *path, bool mapped, int repeats, Result &result)
+{
+	int pipes[2];
+	if (pipe(pipes) != 0) {
+		return false;
+	}
+	pid_t pid = fork();
+	if (pid < 0) {
+		return false;
+	}
+	if (pid == 0) {
+		close(pipes[0]);
+		std::vector<std::uint8_t> scratch;
+		// The first load brings the file into the page cache.
+		bool ok = mapped ? loadMapped(path, scratch) : loadVector(path, scratch);
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; ok && i < repeats; ++i) {
+			ok = mapped ? loadMapped(path, scratch) : loadVector(path, scratch);
+		}
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		double milliseconds = ok ? elapsed.count() / repeats : -1.0;
+		ssize_t written = write(pipes[1], &milliseconds, sizeof(milliseconds));
+		_exit((ok && written == sizeof(milliseconds)) ? 0 : 1);
+	}
+
+	close(pipes[1]);
+	double milliseconds = -1.0;
+	ssize_t bytes = read(pipes[0], &milliseconds, sizeof(milliseconds));
+	close(pipes[0]);
+	int status;
+	struct rusage usage;
+	if (wait4(pid, &status, 0, &usage) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0 || bytes != sizeof(milliseconds)) {
+		return false;
+	}
+	result.milliseconds = milliseconds;
+#ifdef __APPLE__
+	result.peakMegabytes = usage.ru_maxrss / 1.0e6;
+#else
+	result.peakMegabytes = usage.ru_maxrss * 1024 / 1.0e6;
+#endif
+	return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	if (argc < 2) {
+		std::fprintf(stderr, "Usage: %s <file> [repeats]\n", argv[0]);
+		return 1;
+	}
+	const char *path = argv[1];
+	int repeats = (argc > 2) ? std::max(std::atoi(argv[2]), 1) : 10;
+
+	double megabytes;
+	{
+		TextureFile file(path);
+		if (!file) {
+			std::fprintf(stderr, "%s\n", file.getError().c_str());
+			return 1;
+		}
+		megabytes = file.getSize() / 1.0e6;
+		std::printf("%s: %.1f MB, %zu images, %d repeats\n", path, megabytes, file.getImages().size(), repeats);
+	}
+
+	std::printf("%-8s %10s %10s %14s\n", "path", "ms/load", "MB/s", "peak RSS MB");
+	for (bool mapped : { true, false }) {
+		Result result;
+		if (!run(path, mapped, repeats, result)) {
+			std::fprintf(stderr, "Loading %s failed\n", path);
+			return 1;
+		}
+		std::printf("%-8s %10.2f %10.1f %14.1f\n", mapped ? "mapped" : "vector",
+			result.milliseconds, megabytes / (result.milliseconds / 1000.0), result.peakMegabytes);
+	}
+	return 0;
+}
@@ -0,0 +1,46 @@
+# Compiles GLSL shaders to SPIR-V for OpenGL at build time.
+#
+#   gtl_add_spirv_shaders(<target>
+#       SOURCES <file>...
+#       [OUTPUT_DIRECTORY <dir>]
+#       [OPTIONS <option>...])
+#
+# Adds the custom target <target>, which compiles every source with
+# glslangValidator into <dir>/<name>.spv (default: the current binary
+# directory). The shader stage is taken from the file extension (.vert,
+# .tesc, .tese, .geom, .frag, .comp). The modules are loaded with
+# gtl::ogl::SpirvModule or gtl::ogl::ShaderLoader.
+
+include(CMakeParseArguments)
+
+find_program(GLSLANG_VALIDATOR_EXECUTABLE
+	NAMES glslangValidator
+	HINTS "$ENV{VULKAN_SDK}/bin")
+
+function(gtl_add_spirv_shaders TARGET)
+	cmake_parse_arguments(SPIRV "" "OUTPUT_DIRECTORY" "SOURCES;OPTIONS" ${ARGN})
+
+	if(NOT GLSLANG_VALIDATOR_EXECUTABLE)
+		message(FATAL_ERROR "glslangValidator is required to compile shaders to SPIR-V")
+	endif()
+	if(NOT SPIRV_OUTPUT_DIRECTORY)
+		set(SPIRV_OUTPUT_DIRECTORY "${CMAKE_CURRENT_BINARY_DIR}")
+	endif()
+
+	set(OUTPUTS "")
+	foreach(SOURCE ${SPIRV_SOURCES})
+		get_filename_component(SOURCE_PATH "${SOURCE}" ABSOLUTE)
+		get_filename_component(SOURCE_NAME "${SOURCE}" NAME)
+		set(OUTPUT "${SPIRV_OUTPUT_DIRECTORY}/${SOURCE_NAME}.spv")
+		add_custom_command(
+			OUTPUT "${OUTPUT}"
+			COMMAND "${CMAKE_COMMAND}" -E make_directory "${SPIRV_OUTPUT_DIRECTORY}"
+			COMMAND "${GLSLANG_VALIDATOR_EXECUTABLE}" -G ${SPIRV_OPTIONS} -o "${OUTPUT}" "${SOURCE_PATH}"
+			DEPENDS "${SOURCE_PATH}"
+			COMMENT "Compiling ${SOURCE_NAME} to SPIR-V"
+			VERBATIM)
+		list(APPEND OUTPUTS "${OUTPUT}")
+	endforeach()
+
+	add_custom_target("${TARGET}" ALL DEPENDS ${OUTPUTS})
+endfunction()
@@ -0,0 +1,660 @@
+#ifndef GTL_OGL_BLOCKCOMPRESSOR_H
+#define GTL_OGL_BLOCKCOMPRESSOR_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GTL_OGL_BLOCKCOMPRESSOR_SSE2
+#include <emmintrin.h>
+#endif
+
+#include <GL/glew.h>
+
+#include "gtl/ogl/texture.h"
+
+
+namespace gtl {
+namespace ogl {
+
+// CPU encoder for the BC1, BC3, BC4 and BC5 block compression formats. The
+// input is always RGBA8; BC1 encodes RGB, BC3 RGBA, BC4 red and BC5 red and
+// green. Rows of blocks are split over threads. FAST fits the endpoints to
+// the bounding box, NORMAL to the principal axis of the block, and HIGH
+// additionally refines them by least squares and searches around the
+// single channel endpoints. Partial blocks at the right and bottom edge
+// repeat the last column and row.
+class BlockCompressor final
+{
+public:
+	enum class Format {
+		BC1,
+		BC3,
+		BC4,
+		BC5
+	};
+
+	enum class Quality {
+		FAST,
+		NORMAL,
+		HIGH
+	};
+
+	struct Stats {
+		std::uint64_t blocks;
+		std::uint64_t inputBytes;
+		std::uint64_t outputBytes;
+		std::chrono::nanoseconds elapsed;
+		// Sum of the time spent on every thread.
+		std::chrono::nanoseconds threadTime;
+
+		// In MB of input per second.
+		double getThroughput() const noexcept;
+		double getThroughputPerCore() const noexcept;
+	};
+
+	explicit BlockCompressor(unsigned threadCount = std::thread::hardware_concurrency());
+
+	// stride is the distance between rows in bytes; 0 means tightly packed.
+	void compress(Format format, Quality quality, const void *pixels, GLsizei width, GLsizei height, std::size_t stride, std::vector<std::uint8_t> &blocks);
+	void upload(Texture &texture, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, Format format, Quality quality, const void *pixels, std::size_t stride = 0);
+	void upload(Texture &texture, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, Format format, Quality quality, const void *pixels, std::size_t stride = 0);
+
+	const Stats &getStats() const noexcept;
+	void resetStats() noexcept;
+
+	static void decompress(Format format, const std::uint8_t *blocks, GLsizei width, GLsizei height, void *pixels, std::size_t stride = 0);
+	// PSNR in dB over the channels stored by the format.
+	static double getPsnr(Format format, const void *pixels, GLsizei width, GLsizei height, std::size_t stride, const std::uint8_t *blocks);
+
+	static GLenum getInternalFormat(Format format) noexcept;
+	static std::size_t getBlockSize(Format format) noexcept;
+	static std::size_t getCompressedSize(Format format, GLsizei width, GLsizei height) noexcept;
+
+private:
+	BlockCompressor(const BlockCompressor &) = delete;
+	BlockCompressor &operator=(const BlockCompressor &) = delete;
+
+	static void compressRows(Format format, Quality quality, const std::uint8_t *pixels, GLsizei width, GLsizei height, std::size_t stride, GLsizei firstRow, GLsizei lastRow, std::uint8_t *output);
+	static void encodeColor(const std::uint8_t *block, Quality quality, std::uint8_t *output);
+	static void encodeSingle(const std::uint8_t *block, std::size_t channel, Quality quality, std::uint8_t *output);
+	static void decodeColor(const std::uint8_t *input, bool fourColors, std::uint8_t *block);
+	static void decodeSingle(const std::uint8_t *input, std::size_t channel, std::uint8_t *block);
+
+	static std::uint16_t quantize(const float *color);
+	static void expand(std::uint16_t color, int *rgb);
+	static void getColorPalette(std::uint16_t c0, std::uint16_t c1, bool fourColors, std::uint8_t *palette);
+	static std::uint32_t selectColors(const std::uint8_t *block, const std::uint8_t *palette, std::uint32_t &indices);
+	static void getSinglePalette(int v0, int v1, int *palette);
+	static std::uint32_t selectSingle(const int *values, int v0, int v1, std::uint64_t &indices);
+
+	unsigned mThreadCount;
+	std::vector<std::uint8_t> mScratch;
+	Stats mStats;
+
+};
+
+
+inline double BlockCompressor::Stats::getThroughput() const noexcept
+{
+	return (elapsed.count() == 0) ? 0.0 : inputBytes / 1.0e6 / std::chrono::duration<double>(elapsed).count();
+}
+
+inline double BlockCompressor::Stats::getThroughputPerCore() const noexcept
+{
+	return (threadTime.count() == 0) ? 0.0 : inputBytes / 1.0e6 / std::chrono::duration<double>(threadTime).count();
+}
+
+inline BlockCompressor::BlockCompressor(unsigned threadCount) :
+	mThreadCount(std::max(threadCount, 1u)),
+	mStats()
+{
+}
+
+inline void BlockCompressor::compress(Format format, Quality quality, const void *pixels, GLsizei width, GLsizei height, std::size_t stride, std::vector<std::uint8_t> &blocks)
+{
+	auto start = std::chrono::steady_clock::now();
+	if (stride == 0) {
+		stride = width * 4;
+	}
+	blocks.resize(getCompressedSize(format, width, height));
+	const std::uint8_t *source = static_cast<const std::uint8_t*>(pixels);
+	GLsizei rows = (height + 3) / 4;
+
+	// Small images are not worth starting threads for.
+	GLsizei threadCount = std::min<GLsizei>(mThreadCount, std::max<GLsizei>(rows * ((width + 3) / 4) / 256, 1));
+	std::vector<std::chrono::nanoseconds> times(threadCount);
+	auto run = [&](GLsizei thread) {
+		auto threadStart = std::chrono::steady_clock::now();
+		compressRows(format, quality, source, width, height, stride, rows * thread / threadCount, rows * (thread + 1) / threadCount, blocks.data());
+		times[thread] = std::chrono::steady_clock::now() - threadStart;
+	};
+	std::vector<std::thread> threads;
+	for (GLsizei thread = 1; thread < threadCount; ++thread) {
+		threads.emplace_back(run, thread);
+	}
+	run(0);
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+
+	mStats.blocks += blocks.size() / getBlockSize(format);
+	mStats.inputBytes += static_cast<std::uint64_t>(width) * height * 4;
+	mStats.outputBytes += blocks.size();
+	mStats.elapsed += std::chrono::steady_clock::now() - start;
+	for (std::chrono::nanoseconds time : times) {
+		mStats.threadTime += time;
+	}
+}
+
+inline void BlockCompressor::upload(Texture &texture, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, Format format, Quality quality, const void *pixels, std::size_t stride)
+{
+	compress(format, quality, pixels, width, height, stride, mScratch);
+	texture.setCompressedSubImage(level, xoffset, yoffset, width, height, getInternalFormat(format), static_cast<GLsizei>(mScratch.size()), mScratch.data());
+}
+
+inline void BlockCompressor::upload(Texture &texture, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, Format format, Quality quality, const void *pixels, std::size_t stride)
+{
+	compress(format, quality, pixels, width, height, stride, mScratch);
+	texture.setCompressedSubImage(level, xoffset, yoffset, zoffset, width, height, 1, getInternalFormat(format), static_cast<GLsizei>(mScratch.size()), mScratch.data());
+}
+
+inline const BlockCompressor::Stats &BlockCompressor::getStats() const noexcept
+{
+	return mStats;
+}
+
+inline void BlockCompressor::resetStats() noexcept
+{
+	mStats = Stats();
+}
+
+inline void BlockCompressor::decompress(Format format, const std::uint8_t *blocks, GLsizei width, GLsizei height, void *pixels, std::size_t stride)
+{
+	if (stride == 0) {
+		stride = width * 4;
+	}
+	std::uint8_t *target = static_cast<std::uint8_t*>(pixels);
+	std::size_t blockSize = getBlockSize(format);
+	for (GLsizei by = 0; by < height; by += 4) {
+		for (GLsizei bx = 0; bx < width; bx += 4, blocks += blockSize) {
+			std::uint8_t block[64];
+			for (int i = 0; i < 16; ++i) {
+				block[i * 4 + 0] = 0;
+				block[i * 4 + 1] = 0;
+				block[i * 4 + 2] = 0;
+				block[i * 4 + 3] = 255;
+			}
+			switch (format) {
+			case Format::BC1:
+				decodeColor(blocks, false, block);
+				break;
+			case Format::BC3:
+				decodeSingle(blocks, 3, block);
+				decodeColor(blocks + 8, true, block);
+				break;
+			case Format::BC4:
+				decodeSingle(blocks, 0, block);
+				break;
+			case Format::BC5:
+				decodeSingle(blocks, 0, block);
+				decodeSingle(blocks + 8, 1, block);
+				break;
+			}
+			for (GLsizei y = 0; y < 4 && by + y < height; ++y) {
+				for (GLsizei x = 0; x < 4 && bx + x < width; ++x) {
+					std::copy(block + (y * 4 + x) * 4, block + (y * 4 + x + 1) * 4, target + (by + y) * stride + (bx + x) * 4);
+				}
+			}
+		}
+	}
+}
+
+inline double BlockCompressor::getPsnr(Format format, const void *pixels, GLsizei width, GLsizei height, std::size_t stride, const std::uint8_t *blocks)
+{
+	if (stride == 0) {
+		stride = width * 4;
+	}
+	std::vector<std::uint8_t> decoded(static_cast<std::size_t>(width) * height * 4);
+	decompress(format, blocks, width, height, decoded.data(), 0);
+
+	std::size_t channels = (format == Format::BC1) ? 3 : (format == Format::BC3) ? 4 : (format == Format::BC4) ? 1 : 2;
+	const std::uint8_t *source = static_cast<const std::uint8_t*>(pixels);
+	double sum = 0.0;
+	for (GLsizei y = 0; y < height; ++y) {
+		for (GLsizei x = 0; x < width; ++x) {
+			for (std::size_t c = 0; c < channels; ++c) {
+				double d = static_cast<double>(source[y * stride + x * 4 + c]) - decoded[(y * width + x) * 4 + c];
+				sum += d * d;
+			}
+		}
+	}
+	double mse = sum / (static_cast<double>(width) * height * channels);
+	return (mse == 0.0) ? std::numeric_limits<double>::infinity() : 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+inline GLenum BlockCompressor::getInternalFormat(Format format) noexcept
+{
+	switch (format) {
+	case Format::BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	case Format::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case Format::BC4: return GL_COMPRESSED_RED_RGTC1;
+	case Format::BC5: return GL_COMPRESSED_RG_RGTC2;
+	}
+	return GL_NONE;
+}
+
+inline std::size_t BlockCompressor::getBlockSize(Format format) noexcept
+{
+	return (format == Format::BC1 || format == Format::BC4) ? 8 : 16;
+}
+
+inline std::size_t BlockCompressor::getCompressedSize(Format format, GLsizei width, GLsizei height) noexcept
+{
+	return static_cast<std::size_t>((width + 3) / 4) * ((height + 3) / 4) * getBlockSize(format);
+}
+
+inline void BlockCompressor::compressRows(Format format, Quality quality, const std::uint8_t *pixels, GLsizei width, GLsizei height, std::size_t stride, GLsizei firstRow, GLsizei lastRow, std::uint8_t *output)
+{
+	GLsizei columns = (width + 3) / 4;
+	std::size_t blockSize = getBlockSize(format);
+	output += static_cast<std::size_t>(firstRow) * columns * blockSize;
+	for (GLsizei row = firstRow; row < lastRow; ++row) {
+		for (GLsizei column = 0; column < columns; ++column, output += blockSize) {
+			alignas(16) std::uint8_t block[64];
+			for (GLsizei y = 0; y < 4; ++y) {
+				const std::uint8_t *line = pixels + std::min(row * 4 + y, height - 1) * stride;
+				for (GLsizei x = 0; x < 4; ++x) {
+					const std::uint8_t *pixel = line + std::min(column * 4 + x, width - 1) * 4;
+					std::copy(pixel, pixel + 4, block + (y * 4 + x) * 4);
+				}
+			}
+			switch (format) {
+			case Format::BC1:
+				encodeColor(block, quality, output);
+				break;
+			case Format::BC3:
+				encodeSingle(block, 3, quality, output);
+				encodeColor(block, quality, output + 8);
+				break;
+			case Format::BC4:
+				encodeSingle(block, 0, quality, output);
+				break;
+			case Format::BC5:
+				encodeSingle(block, 0, quality, output);
+				encodeSingle(block, 1, quality, output + 8);
+				break;
+			}
+		}
+	}
+}
+
+inline void BlockCompressor::encodeColor(const std::uint8_t *block, Quality quality, std::uint8_t *output)
+{
+	float minColor[3] = { 255.0f, 255.0f, 255.0f };
+	float maxColor[3] = { 0.0f, 0.0f, 0.0f };
+	float mean[3] = { 0.0f, 0.0f, 0.0f };
+	for (int i = 0; i < 16; ++i) {
+		for (int c = 0; c < 3; ++c) {
+			float value = block[i * 4 + c];
+			minColor[c] = std::min(minColor[c], value);
+			maxColor[c] = std::max(maxColor[c], value);
+			mean[c] += value / 16.0f;
+		}
+	}
+
+	float start[3];
+	float end[3];
+	std::copy(maxColor, maxColor + 3, start);
+	std::copy(minColor, minColor + 3, end);
+	if (quality != Quality::FAST) {
+		// Principal axis by power iteration on the covariance matrix.
+		float cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < 16; ++i) {
+			float r = block[i * 4 + 0] - mean[0];
+			float g = block[i * 4 + 1] - mean[1];
+			float b = block[i * 4 + 2] - mean[2];
+			cov[0] += r * r;
+			cov[1] += r * g;
+			cov[2] += r * b;
+			cov[3] += g * g;
+			cov[4] += g * b;
+			cov[5] += b * b;
+		}
+		float axis[3] = { maxColor[0] - minColor[0], maxColor[1] - minColor[1], maxColor[2] - minColor[2] };
+		for (int iteration = 0; iteration < 8; ++iteration) {
+			float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+			float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+			float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+			float length = std::max(std::max(std::fabs(x), std::fabs(y)), std::fabs(z));
+			if (length < 1e-6f) {
+				break;
+			}
+			axis[0] = x / length;
+			axis[1] = y / length;
+			axis[2] = z / length;
+		}
+		float lengthSquared = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+		if (lengthSquared > 1e-6f) {
+			float minT = std::numeric_limits<float>::max();
+			float maxT = -std::numeric_limits<float>::max();
+			for (int i = 0; i < 16; ++i) {
+				float t = ((block[i * 4 + 0] - mean[0]) * axis[0] + (block[i * 4 + 1] - mean[1]) * axis[1] + (block[i * 4 + 2] - mean[2]) * axis[2]) / lengthSquared;
+				minT = std::min(minT, t);
+				maxT = std::max(maxT, t);
+			}
+			for (int c = 0; c < 3; ++c) {
+				start[c] = std::min(std::max(mean[c] + axis[c] * maxT, 0.0f), 255.0f);
+				end[c] = std::min(std::max(mean[c] + axis[c] * minT, 0.0f), 255.0f);
+			}
+		}
+	}
+	// Moving the endpoints inwards reduces the error of the interpolated colors.
+	for (int c = 0; c < 3; ++c) {
+		float inset = (start[c] - end[c]) / 16.0f;
+		start[c] -= inset;
+		end[c] += inset;
+	}
+
+	std::uint16_t c0 = quantize(start);
+	std::uint16_t c1 = quantize(end);
+	std::uint8_t palette[16];
+	std::uint32_t indices;
+	getColorPalette(c0, c1, true, palette);
+	std::uint32_t error = selectColors(block, palette, indices);
+
+	for (int iteration = 0; quality == Quality::HIGH && iteration < 2 && error > 0; ++iteration) {
+		// Least squares fit of both endpoints to the selected indices.
+		static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+		float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+		float ax[3] = { 0.0f, 0.0f, 0.0f };
+		float bx[3] = { 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < 16; ++i) {
+			float a = weights[(indices >> (2 * i)) & 3];
+			float b = 1.0f - a;
+			aa += a * a;
+			bb += b * b;
+			ab += a * b;
+			for (int c = 0; c < 3; ++c) {
+				ax[c] += a * block[i * 4 + c];
+				bx[c] += b * block[i * 4 + c];
+			}
+		}
+		float determinant = aa * bb - ab * ab;
+		if (std::fabs(determinant) < 1e-6f) {
+			break;
+		}
+		for (int c = 0; c < 3; ++c) {
+			start[c] = std::min(std::max((ax[c] * bb - bx[c] * ab) / determinant, 0.0f), 255.0f);
+			end[c] = std::min(std::max((bx[c] * aa - ax[c] * ab) / determinant, 0.0f), 255.0f);
+		}
+		std::uint16_t r0 = quantize(start);
+		std::uint16_t r1 = quantize(end);
+		std::uint8_t refinedPalette[16];
+		std::uint32_t refinedIndices;
+		getColorPalette(r0, r1, true, refinedPalette);
+		std::uint32_t refinedError = selectColors(block, refinedPalette, refinedIndices);
+		if (refinedError >= error) {
+			break;
+		}
+		c0 = r0;
+		c1 = r1;
+		indices = refinedIndices;
+		error = refinedError;
+	}
+
+	// c0 > c1 selects the four color mode; swapping the endpoints swaps the
+	// indices 0 and 1 as well as 2 and 3.
+	if (c0 < c1) {
+		std::swap(c0, c1);
+		indices ^= 0x55555555u;
+	} else if (c0 == c1) {
+		indices = 0;
+	}
+	output[0] = static_cast<std::uint8_t>(c0);
+	output[1] = static_cast<std::uint8_t>(c0 >> 8);
+	output[2] = static_cast<std::uint8_t>(c1);
+	output[3] = static_cast<std::uint8_t>(c1 >> 8);
+	for (int i = 0; i < 4; ++i) {
+		output[4 + i] = static_cast<std::uint8_t>(indices >> (8 * i));
+	}
+}
+
+inline void BlockCompressor::encodeSingle(const std::uint8_t *block, std::size_t channel, Quality quality, std::uint8_t *output)
+{
+	int values[16];
+	int minValue = 255, maxValue = 0;
+	int minInner = 255, maxInner = 0;
+	bool extremes = false;
+	for (int i = 0; i < 16; ++i) {
+		values[i] = block[i * 4 + channel];
+		minValue = std::min(minValue, values[i]);
+		maxValue = std::max(maxValue, values[i]);
+		if (values[i] == 0 || values[i] == 255) {
+			extremes = true;
+		} else {
+			minInner = std::min(minInner, values[i]);
+			maxInner = std::max(maxInner, values[i]);
+		}
+	}
+
+	// v0 > v1 interpolates eight values, v0 <= v1 six values plus 0 and 255.
+	int v0 = maxValue;
+	int v1 = minValue;
+	std::uint64_t indices;
+	std::uint32_t error = selectSingle(values, v0, v1, indices);
+	if (quality != Quality::FAST && extremes && minInner <= maxInner) {
+		std::uint64_t candidateIndices;
+		std::uint32_t candidateError = selectSingle(values, minInner, maxInner, candidateIndices);
+		if (candidateError < error) {
+			v0 = minInner;
+			v1 = maxInner;
+			indices = candidateIndices;
+			error = candidateError;
+		}
+	}
+	if (quality == Quality::HIGH && error > 0) {
+		int base0 = v0;
+		int base1 = v1;
+		for (int d0 = -2; d0 <= 2; ++d0) {
+			for (int d1 = -2; d1 <= 2; ++d1) {
+				int c0 = std::min(std::max(base0 + d0, 0), 255);
+				int c1 = std::min(std::max(base1 + d1, 0), 255);
+				// Stay in the mode of the starting point.
+				if ((c0 > c1) != (base0 > base1)) {
+					continue;
+				}
+				std::uint64_t candidateIndices;
+				std::uint32_t candidateError = selectSingle(values, c0, c1, candidateIndices);
+				if (candidateError < error) {
+					v0 = c0;
+					v1 = c1;
+					indices = candidateIndices;
+					error = candidateError;
+				}
+			}
+		}
+	}
+
+	output[0] = static_cast<std::uint8_t>(v0);
+	output[1] = static_cast<std::uint8_t>(v1);
+	for (int i = 0; i < 6; ++i) {
+		output[2 + i] = static_cast<std::uint8_t>(indices >> (8 * i));
+	}
+}
+
+inline void BlockCompressor::decodeColor(const std::uint8_t *input, bool fourColors, std::uint8_t *block)
+{
+	std::uint16_t c0 = static_cast<std::uint16_t>(input[0] | (input[1] << 8));
+	std::uint16_t c1 = static_cast<std::uint16_t>(input[2] | (input[3] << 8));
+	std::uint8_t palette[16];
+	getColorPalette(c0, c1, fourColors || c0 > c1, palette);
+	std::uint32_t indices = input[4] | (input[5] << 8) | (input[6] << 16) | (static_cast<std::uint32_t>(input[7]) << 24);
+	for (int i = 0; i < 16; ++i) {
+		const std::uint8_t *color = palette + ((indices >> (2 * i)) & 3) * 4;
+		std::copy(color, color + 3, block + i * 4);
+	}
+}
+
+inline void BlockCompressor::decodeSingle(const std::uint8_t *input, std::size_t channel, std::uint8_t *block)
+{
+	int palette[8];
+	getSinglePalette(input[0], input[1], palette);
+	std::uint64_t indices = 0;
+	for (int i = 0; i < 6; ++i) {
+		indices |= static_cast<std::uint64_t>(input[2 + i]) << (8 * i);
+	}
+	for (int i = 0; i < 16; ++i) {
+		block[i * 4 + channel] = static_cast<std::uint8_t>(palette[(indices >> (3 * i)) & 7]);
+	}
+}
+
+inline std::uint16_t BlockCompressor::quantize(const float *color)
+{
+	int r = static_cast<int>(color[0] * 31.0f / 255.0f + 0.5f);
+	int g = static_cast<int>(color[1] * 63.0f / 255.0f + 0.5f);
+	int b = static_cast<int>(color[2] * 31.0f / 255.0f + 0.5f);
+	return static_cast<std::uint16_t>((r << 11) | (g << 5) | b);
+}
+
+inline void BlockCompressor::expand(std::uint16_t color, int *rgb)
+{
+	int r = (color >> 11) & 31;
+	int g = (color >> 5) & 63;
+	int b = color & 31;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+inline void BlockCompressor::getColorPalette(std::uint16_t c0, std::uint16_t c1, bool fourColors, std::uint8_t *palette)
+{
+	int a[3];
+	int b[3];
+	expand(c0, a);
+	expand(c1, b);
+	for (int c = 0; c < 3; ++c) {
+		palette[0 + c] = static_cast<std::uint8_t>(a[c]);
+		palette[4 + c] = static_cast<std::uint8_t>(b[c]);
+		if (fourColors) {
+			palette[8 + c] = static_cast<std::uint8_t>((2 * a[c] + b[c]) / 3);
+			palette[12 + c] = static_cast<std::uint8_t>((a[c] + 2 * b[c]) / 3);
+		} else {
+			palette[8 + c] = static_cast<std::uint8_t>((a[c] + b[c]) / 2);
+			palette[12 + c] = 0;
+		}
+	}
+	palette[3] = palette[7] = palette[11] = palette[15] = 0;
+}
+
+inline std::uint32_t BlockCompressor::selectColors(const std::uint8_t *block, const std::uint8_t *palette, std::uint32_t &indices)
+{
+	std::uint32_t error = 0;
+	indices = 0;
+#ifdef GTL_OGL_BLOCKCOMPRESSOR_SSE2
+	// Four pixels at a time: squared distances to every palette color with
+	// 16 bit differences, then the index of the smallest one.
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+	__m128i colors[4];
+	for (int k = 0; k < 4; ++k) {
+		__m128i color = _mm_cvtsi32_si128(palette[k * 4] | (palette[k * 4 + 1] << 8) | (palette[k * 4 + 2] << 16));
+		colors[k] = _mm_unpacklo_epi8(_mm_shuffle_epi32(color, 0), zero);
+	}
+	for (int group = 0; group < 4; ++group) {
+		__m128i pixels = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + group * 16)), rgbMask);
+		__m128i low = _mm_unpacklo_epi8(pixels, zero);
+		__m128i high = _mm_unpackhi_epi8(pixels, zero);
+		__m128i best = _mm_set1_epi32(0x7FFFFFFF);
+		__m128i bestIndex = zero;
+		for (int k = 0; k < 4; ++k) {
+			__m128i dl = _mm_sub_epi16(low, colors[k]);
+			__m128i dh = _mm_sub_epi16(high, colors[k]);
+			__m128 sl = _mm_castsi128_ps(_mm_madd_epi16(dl, dl));
+			__m128 sh = _mm_castsi128_ps(_mm_madd_epi16(dh, dh));
+			__m128i distance = _mm_add_epi32(
+				_mm_castps_si128(_mm_shuffle_ps(sl, sh, _MM_SHUFFLE(2, 0, 2, 0))),
+				_mm_castps_si128(_mm_shuffle_ps(sl, sh, _MM_SHUFFLE(3, 1, 3, 1))));
+			__m128i less = _mm_cmplt_epi32(distance, best);
+			best = _mm_or_si128(_mm_and_si128(less, distance), _mm_andnot_si128(less, best));
+			bestIndex = _mm_or_si128(_mm_and_si128(less, _mm_set1_epi32(k)), _mm_andnot_si128(less, bestIndex));
+		}
+		alignas(16) std::uint32_t distances[4];
+		alignas(16) std::uint32_t selected[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(distances), best);
+		_mm_store_si128(reinterpret_cast<__m128i*>(selected), bestIndex);
+		for (int i = 0; i < 4; ++i) {
+			error += distances[i];
+			indices |= selected[i] << (2 * (group * 4 + i));
+		}
+	}
+#else
+	for (int i = 0; i < 16; ++i) {
+		std::uint32_t best = std::numeric_limits<std::uint32_t>::max();
+		std::uint32_t bestIndex = 0;
+		for (std::uint32_t k = 0; k < 4; ++k) {
+			std::uint32_t distance = 0;
+			for (int c = 0; c < 3; ++c) {
+				int d = block[i * 4 + c] - palette[k * 4 + c];
+				distance += d * d;
+			}
+			if (distance < best) {
+				best = distance;
+				bestIndex = k;
+			}
+		}
+		error += best;
+		indices |= bestIndex << (2 * i);
+	}
+#endif
+	return error;
+}
+
+inline void BlockCompressor::getSinglePalette(int v0, int v1, int *palette)
+{
+	palette[0] = v0;
+	palette[1] = v1;
+	if (v0 > v1) {
+		for (int i = 1; i < 7; ++i) {
+			palette[i + 1] = ((7 - i) * v0 + i * v1 + 3) / 7;
+		}
+	} else {
+		for (int i = 1; i < 5; ++i) {
+			palette[i + 1] = ((5 - i) * v0 + i * v1 + 2) / 5;
+		}
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+inline std::uint32_t BlockCompressor::selectSingle(const int *values, int v0, int v1, std::uint64_t &indices)
+{
+	int palette[8];
+	getSinglePalette(v0, v1, palette);
+	std::uint32_t error = 0;
+	indices = 0;
+	for (int i = 0; i < 16; ++i) {
+		int best = std::numeric_limits<int>::max();
+		std::uint64_t bestIndex = 0;
+		for (int k = 0; k < 8; ++k) {
+			int d = values[i] - palette[k];
+			if (d * d < best) {
+				best = d * d;
+				bestIndex = k;
+			}
+		}
+		error += best;
+		indices |= bestIndex << (3 * i);
+	}
+	return error;
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_BLOCKCOMPRESSOR_H
@@ -0,0 +1,396 @@
+#ifndef GTL_OGL_BLOCKLAYOUT_H
+#define GTL_OGL_BLOCKLAYOUT_H
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "gtl/ogl/buffer.h"
+#include "gtl/ogl/program.h"
+#include "gtl/ogl/shaderexception.h"
+
+
+namespace gtl {
+namespace ogl {
+
+enum class Packing {
+	STD140,
+	STD430
+};
+
+// Describes how a C++ type maps to a GLSL type. Vectors have one column,
+// matrices are column-major like GLSL.
+template <class T>
+struct BlockMemberType
+{
+	static_assert(sizeof(T) == 0, "Type is not supported in uniform or storage blocks");
+};
+
+template <class C, unsigned Rows, unsigned Columns>
+struct BlockMemberTypeBase
+{
+	typedef C Component;
+	static const unsigned rows = Rows;
+	static const unsigned columns = Columns;
+};
+
+template <> struct BlockMemberType<GLfloat> : BlockMemberTypeBase<GLfloat, 1, 1> {};
+template <> struct BlockMemberType<GLint> : BlockMemberTypeBase<GLint, 1, 1> {};
+template <> struct BlockMemberType<GLuint> : BlockMemberTypeBase<GLuint, 1, 1> {};
+template <> struct BlockMemberType<glm::vec2> : BlockMemberTypeBase<GLfloat, 2, 1> {};
+template <> struct BlockMemberType<glm::vec3> : BlockMemberTypeBase<GLfloat, 3, 1> {};
+template <> struct BlockMemberType<glm::vec4> : BlockMemberTypeBase<GLfloat, 4, 1> {};
+template <> struct BlockMemberType<glm::ivec2> : BlockMemberTypeBase<GLint, 2, 1> {};
+template <> struct BlockMemberType<glm::ivec3> : BlockMemberTypeBase<GLint, 3, 1> {};
+template <> struct BlockMemberType<glm::ivec4> : BlockMemberTypeBase<GLint, 4, 1> {};
+template <> struct BlockMemberType<glm::uvec2> : BlockMemberTypeBase<GLuint, 2, 1> {};
+template <> struct BlockMemberType<glm::uvec3> : BlockMemberTypeBase<GLuint, 3, 1> {};
+template <> struct BlockMemberType<glm::uvec4> : BlockMemberTypeBase<GLuint, 4, 1> {};
+template <> struct BlockMemberType<glm::mat2> : BlockMemberTypeBase<GLfloat, 2, 2> {};
+template <> struct BlockMemberType<glm::mat3> : BlockMemberTypeBase<GLfloat, 3, 3> {};
+template <> struct BlockMemberType<glm::mat4> : BlockMemberTypeBase<GLfloat, 4, 4> {};
+
+namespace detail {
+
+constexpr std::size_t alignUp(std::size_t value, std::size_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+constexpr std::size_t maxOf(std::size_t a, std::size_t b)
+{
+	return (a > b) ? a : b;
+}
+
+// Base alignment and size of a vector with the given number of components.
+constexpr std::size_t vectorAlignment(std::size_t componentSize, unsigned rows)
+{
+	return componentSize * ((rows == 3) ? 4 : rows);
+}
+
+// Offset, alignment and size of a member according to the packing rules of
+// section 7.6.2.2 of the OpenGL 4.5 specification.
+template <Packing P, class T>
+struct MemberLayout
+{
+	typedef BlockMemberType<T> Type;
+	typedef typename Type::Component Component;
+
+	static const std::size_t vectorAlign = vectorAlignment(sizeof(Component), Type::rows);
+	static const bool isMatrix = (Type::columns > 1);
+	static const std::size_t columnStride = (P == Packing::STD140) ? alignUp(vectorAlign, 16) : vectorAlign;
+	static const std::size_t alignment = isMatrix ? columnStride : vectorAlign;
+	static const std::size_t size = isMatrix ? columnStride * Type::columns : sizeof(Component) * Type::rows;
+
+	static void write(char *dst, const T &value)
+	{
+		const Component *src = reinterpret_cast<const Component*>(&value);
+		for (unsigned c = 0; c < Type::columns; ++c) {
+			std::memcpy(dst + c * columnStride, src + c * Type::rows, sizeof(Component) * Type::rows);
+		}
+	}
+};
+
+template <Packing P, class T, std::size_t N>
+struct MemberLayout<P, std::array<T, N>>
+{
+	typedef MemberLayout<P, T> Element;
+
+	static const std::size_t alignment = (P == Packing::STD140) ? alignUp(Element::alignment, 16) : Element::alignment;
+	static const std::size_t stride = alignUp(Element::size, alignment);
+	static const std::size_t size = stride * N;
+
+	static void write(char *dst, const std::array<T, N> &value)
+	{
+		for (std::size_t i = 0; i < N; ++i) {
+			Element::write(dst + i * stride, value[i]);
+		}
+	}
+};
+
+template <Packing P, std::size_t Offset, class... Ts>
+struct Members;
+
+template <Packing P, std::size_t Offset>
+struct Members<P, Offset>
+{
+	static const std::size_t end = Offset;
+	static const std::size_t alignment = 1;
+
+	static void write(char *)
+	{
+	}
+
+	static void getOffsets(std::size_t *)
+	{
+	}
+};
+
+template <Packing P, std::size_t Offset, class T, class... Ts>
+struct Members<P, Offset, T, Ts...>
+{
+	typedef MemberLayout<P, T> Layout;
+	static const std::size_t offset = alignUp(Offset, Layout::alignment);
+	typedef Members<P, offset + Layout::size, Ts...> Next;
+
+	static const std::size_t end = Next::end;
+	static const std::size_t alignment = maxOf(Layout::alignment, Next::alignment);
+
+	static void write(char *dst, const T &value, const Ts &... values)
+	{
+		Layout::write(dst + offset, value);
+		Next::write(dst, values...);
+	}
+
+	static void getOffsets(std::size_t *offsets)
+	{
+		*offsets = offset;
+		Next::getOffsets(offsets + 1);
+	}
+};
+
+template <std::size_t I, class M>
+struct MemberAt
+{
+	typedef typename MemberAt<I - 1, typename M::Next>::Type Type;
+};
+
+template <class M>
+struct MemberAt<0, M>
+{
+	typedef M Type;
+};
+
+} // namespace detail
+
+// Computes the memory layout of a uniform or shader storage block at
+// compile time. The members are given in declaration order:
+//
+//     typedef BlockLayout<Packing::STD140, glm::mat4, glm::vec3, GLfloat> Transform;
+//     static_assert(Transform::offset<2>() == 76, "");
+template <Packing P, class... Ts>
+class BlockLayout final
+{
+public:
+	typedef detail::Members<P, 0, Ts...> Members;
+
+	static const Packing packing = P;
+	static const std::size_t memberCount = sizeof...(Ts);
+	static const std::size_t alignment = (P == Packing::STD140)
+		? detail::alignUp(Members::alignment, 16) : Members::alignment;
+	static const std::size_t size = detail::alignUp(Members::end, alignment);
+
+	template <std::size_t I>
+	static constexpr std::size_t offset()
+	{
+		return detail::MemberAt<I, Members>::Type::offset;
+	}
+
+	static void pack(void *dst, const Ts &... values);
+	static void check(const Program &program, Buffer::Target target, const std::string &blockName, const std::vector<std::string> &memberNames);
+
+private:
+	BlockLayout() = delete;
+
+};
+
+// Buffer holding an array of blocks, each starting at a multiple of the given
+// alignment (e.g. GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT). The buffer is mapped
+// persistently, so set() writes directly into it without any GL call.
+template <class Block>
+class TypedBuffer final
+{
+public:
+	TypedBuffer() noexcept;
+	TypedBuffer(GLsizei count, GLsizeiptr alignment = 256);
+
+	TypedBuffer(TypedBuffer &&other) noexcept;
+	TypedBuffer &operator = (TypedBuffer &&other) noexcept;
+	explicit operator bool () const noexcept;
+
+	void create(GLsizei count, GLsizeiptr alignment = 256);
+	void reset() noexcept;
+
+	const Buffer &getBuffer() const noexcept;
+	GLsizei getCount() const noexcept;
+	GLsizeiptr getStride() const noexcept;
+	GLintptr getOffset(GLsizei index) const noexcept;
+
+	template <class... Args>
+	void set(GLsizei index, const Args &... values);
+	void bind(Buffer::Target target, GLuint bindingIndex, GLsizei index) const;
+
+private:
+	TypedBuffer(const TypedBuffer &) = delete;
+	TypedBuffer &operator=(const TypedBuffer &) = delete;
+
+	Buffer mBuffer;
+	char *mData;
+	GLsizei mCount;
+	GLsizeiptr mStride;
+
+};
+
+
+template <Packing P, class... Ts>
+inline void BlockLayout<P, Ts...>::pack(void *dst, const Ts &... values)
+{
+	Members::write(static_cast<char*>(dst), values...);
+}
+
+template <Packing P, class... Ts>
+inline void BlockLayout<P, Ts...>::check(const Program &program, Buffer::Target target, const std::string &blockName, const std::vector<std::string> &memberNames)
+{
+	GLenum blockInterface = GL_UNIFORM_BLOCK;
+	GLenum memberInterface = GL_UNIFORM;
+	if (target == Buffer::Target::SHADER_STORAGE) {
+		blockInterface = GL_SHADER_STORAGE_BLOCK;
+		memberInterface = GL_BUFFER_VARIABLE;
+	}
+
+	GLuint index = glGetProgramResourceIndex(program.get(), blockInterface, blockName.c_str());
+	if (index == GL_INVALID_INDEX) {
+		throw ShaderException("Block " + blockName + " is not active");
+	}
+	const GLenum dataSizeProperty = GL_BUFFER_DATA_SIZE;
+	GLint dataSize;
+	glGetProgramResourceiv(program.get(), blockInterface, index, 1, &dataSizeProperty, 1, nullptr, &dataSize);
+	if (static_cast<std::size_t>(dataSize) > size) {
+		throw ShaderException("Block " + blockName + " is larger than its layout");
+	}
+
+	std::size_t offsets[sizeof...(Ts) + 1];
+	Members::getOffsets(offsets);
+	for (std::size_t i = 0; i < memberNames.size() && i < sizeof...(Ts); ++i) {
+		GLuint member = glGetProgramResourceIndex(program.get(), memberInterface, memberNames[i].c_str());
+		if (member == GL_INVALID_INDEX) {
+			// Inactive members are fine, the layout reserves space anyway.
+			continue;
+		}
+		const GLenum offsetProperty = GL_OFFSET;
+		GLint offset;
+		glGetProgramResourceiv(program.get(), memberInterface, member, 1, &offsetProperty, 1, nullptr, &offset);
+		if (static_cast<std::size_t>(offset) != offsets[i]) {
+			throw ShaderException("Offset of " + memberNames[i] + " does not match the layout of " + blockName);
+		}
+	}
+}
+
+template <class Block>
+inline TypedBuffer<Block>::TypedBuffer() noexcept :
+	mData(nullptr),
+	mCount(0),
+	mStride(0)
+{
+}
+
+template <class Block>
+inline TypedBuffer<Block>::TypedBuffer(GLsizei count, GLsizeiptr alignment) :
+	TypedBuffer()
+{
+	create(count, alignment);
+}
+
+template <class Block>
+inline TypedBuffer<Block>::TypedBuffer(TypedBuffer &&other) noexcept :
+	mBuffer(std::move(other.mBuffer)),
+	mData(other.mData),
+	mCount(other.mCount),
+	mStride(other.mStride)
+{
+	other.reset();
+}
+
+template <class Block>
+inline TypedBuffer<Block> &TypedBuffer<Block>::operator =(TypedBuffer &&other) noexcept
+{
+	if (this != &other) {
+		mBuffer = std::move(other.mBuffer);
+		mData = other.mData;
+		mCount = other.mCount;
+		mStride = other.mStride;
+		other.reset();
+	}
+	return *this;
+}
+
+template <class Block>
+inline TypedBuffer<Block>::operator bool() const noexcept
+{
+	return (mData != nullptr);
+}
+
+template <class Block>
+inline void TypedBuffer<Block>::create(GLsizei count, GLsizeiptr alignment)
+{
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	reset();
+	mStride = static_cast<GLsizeiptr>(detail::alignUp(Block::size, alignment));
+	mBuffer.create();
+	mBuffer.storage(mStride * count, nullptr, flags);
+	mData = static_cast<char*>(mBuffer.map(0, mStride * count, flags));
+	if (mData == nullptr) {
+		mBuffer.reset();
+		throw OpenGLException("Cannot map block buffer");
+	}
+	mCount = count;
+}
+
+template <class Block>
+inline void TypedBuffer<Block>::reset() noexcept
+{
+	mBuffer.reset();
+	mData = nullptr;
+	mCount = 0;
+	mStride = 0;
+}
+
+template <class Block>
+inline const Buffer &TypedBuffer<Block>::getBuffer() const noexcept
+{
+	return mBuffer;
+}
+
+template <class Block>
+inline GLsizei TypedBuffer<Block>::getCount() const noexcept
+{
+	return mCount;
+}
+
+template <class Block>
+inline GLsizeiptr TypedBuffer<Block>::getStride() const noexcept
+{
+	return mStride;
+}
+
+template <class Block>
+inline GLintptr TypedBuffer<Block>::getOffset(GLsizei index) const noexcept
+{
+	return mStride * index;
+}
+
+template <class Block>
+template <class... Args>
+inline void TypedBuffer<Block>::set(GLsizei index, const Args &... values)
+{
+	Block::pack(mData + getOffset(index), values...);
+}
+
+template <class Block>
+inline void TypedBuffer<Block>::bind(Buffer::Target target, GLuint bindingIndex, GLsizei index) const
+{
+	mBuffer.bindRange(target, bindingIndex, getOffset(index), static_cast<GLsizeiptr>(Block::size));
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_BLOCKLAYOUT_H
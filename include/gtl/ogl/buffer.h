@@ -16,9 +16,11 @@ public:
 		ARRAY = GL_ARRAY_BUFFER,
 		COPY_READ = GL_COPY_READ_BUFFER,
 		COPY_WRITE = GL_COPY_WRITE_BUFFER,
+		DRAW_INDIRECT = GL_DRAW_INDIRECT_BUFFER,
 		ELEMENT_ARRAY = GL_ELEMENT_ARRAY_BUFFER,
 		PIXEL_PACK = GL_PIXEL_PACK_BUFFER,
 		PIXEL_UNPACK = GL_PIXEL_UNPACK_BUFFER,
+		SHADER_STORAGE = GL_SHADER_STORAGE_BUFFER,
 		TEXTURE = GL_TEXTURE_BUFFER,
 		TRANSFORM_FEEDBACK = GL_TRANSFORM_FEEDBACK_BUFFER,
 		UNIFORM = GL_UNIFORM_BUFFER
@@ -56,14 +58,17 @@ public:
 
 	GLuint get() const noexcept;
 	void bind(Target target) const;
+	void unbind(Target target) const;
+	void bindBase(Target target, GLuint index) const;
+	void bindRange(Target target, GLuint index, GLintptr offset, GLsizeiptr size) const;
 
 	void storage(GLsizeiptr size, const GLvoid *data, GLbitfield flags);
 	void data(std::size_t size, const void *data, UsageHint usage);
 
 	void setSubData(GLintptr offset, GLsizeiptr size, const GLvoid *data);
-	// TODO glCopyNamedBufferSubData
-	// TODO glClearNamedBufferData
-	// TODO glClearNamedBufferSubData
+	void copySubData(const Buffer &readBuffer, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size);
+	void clearData(GLenum internalformat, GLenum format, GLenum type, const void *data);
+	void clearSubData(GLenum internalformat, GLintptr offset, GLsizeiptr size, GLenum format, GLenum type, const void *data);
 
 	void *map(AccessPolicy access);
 	void *map(GLintptr offset, GLsizeiptr length, GLbitfield access);
@@ -153,6 +158,21 @@ inline void Buffer::bind(Buffer::Target target) const
 	glBindBuffer(toEnum(target), mId);
 }
 
+inline void Buffer::unbind(Buffer::Target target) const
+{
+	glBindBuffer(toEnum(target), 0);
+}
+
+inline void Buffer::bindBase(Buffer::Target target, GLuint index) const
+{
+	glBindBufferBase(toEnum(target), index, mId);
+}
+
+inline void Buffer::bindRange(Buffer::Target target, GLuint index, GLintptr offset, GLsizeiptr size) const
+{
+	glBindBufferRange(toEnum(target), index, mId, offset, size);
+}
+
 inline void Buffer::storage(GLsizeiptr size, const GLvoid *data, GLbitfield flags)
 {
 	glNamedBufferStorage(mId, size, data, flags);
@@ -170,6 +190,21 @@ inline void Buffer::setSubData(GLintptr offset, GLsizeiptr size, const GLvoid *d
 	glNamedBufferSubData(mId, offset, size, data);
 }
 
+inline void Buffer::copySubData(const Buffer &readBuffer, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size)
+{
+	glCopyNamedBufferSubData(readBuffer.get(), mId, readOffset, writeOffset, size);
+}
+
+inline void Buffer::clearData(GLenum internalformat, GLenum format, GLenum type, const void *data)
+{
+	glClearNamedBufferData(mId, internalformat, format, type, data);
+}
+
+inline void Buffer::clearSubData(GLenum internalformat, GLintptr offset, GLsizeiptr size, GLenum format, GLenum type, const void *data)
+{
+	glClearNamedBufferSubData(mId, internalformat, offset, size, format, type, data);
+}
+
 inline void *Buffer::map(AccessPolicy access)
 {
 	//bind(target);
@@ -0,0 +1,179 @@
+#ifndef GTL_OGL_BUFFERARENA_H
+#define GTL_OGL_BUFFERARENA_H
+
+#include <GL/glew.h>
+
+#include "gtl/ogl/buffer.h"
+#include "gtl/ogl/openglexception.h"
+#include "gtl/ogl/rangeallocator.h"
+
+
+namespace gtl {
+namespace ogl {
+
+// One large immutable buffer which is split into ranges. The arena has to
+// outlive every allocation made from it, and create() throws while any of
+// them is still alive.
+class BufferArena final
+{
+public:
+	class Allocation final
+	{
+	public:
+		Allocation() noexcept;
+		~Allocation() noexcept;
+
+		Allocation(Allocation &&other) noexcept;
+		Allocation &operator = (Allocation &&other) noexcept;
+		explicit operator bool () const noexcept;
+
+		void reset() noexcept;
+
+		const Buffer &getBuffer() const noexcept;
+		GLintptr getOffset() const noexcept;
+		GLsizeiptr getSize() const noexcept;
+
+	private:
+		friend class BufferArena;
+
+		Allocation(BufferArena *arena, RangeAllocator::Handle handle) noexcept;
+		Allocation(const Allocation &) = delete;
+		Allocation &operator=(const Allocation &) = delete;
+
+		BufferArena *mArena;
+		RangeAllocator::Handle mHandle;
+
+	};
+
+	typedef RangeAllocator::Stats Stats;
+
+	BufferArena() noexcept = default;
+	BufferArena(GLsizeiptr size, GLbitfield flags, GLsizeiptr granularity = 256);
+
+	explicit operator bool () const noexcept;
+
+	void create(GLsizeiptr size, GLbitfield flags, GLsizeiptr granularity = 256);
+
+	const Buffer &getBuffer() const noexcept;
+	Allocation allocate(GLsizeiptr size, GLsizeiptr alignment = 0);
+	Stats getStats() const noexcept;
+
+private:
+	BufferArena(const BufferArena &) = delete;
+	BufferArena &operator=(const BufferArena &) = delete;
+
+	Buffer mBuffer;
+	RangeAllocator mAllocator;
+
+};
+
+
+inline BufferArena::Allocation::Allocation() noexcept :
+	mArena(nullptr),
+	mHandle(RangeAllocator::INVALID)
+{
+}
+
+inline BufferArena::Allocation::Allocation(BufferArena *arena, RangeAllocator::Handle handle) noexcept :
+	mArena(arena),
+	mHandle(handle)
+{
+}
+
+inline BufferArena::Allocation::~Allocation() noexcept
+{
+	reset();
+}
+
+inline BufferArena::Allocation::Allocation(Allocation &&other) noexcept :
+	mArena(other.mArena),
+	mHandle(other.mHandle)
+{
+	other.mArena = nullptr;
+	other.mHandle = RangeAllocator::INVALID;
+}
+
+inline BufferArena::Allocation &BufferArena::Allocation::operator =(Allocation &&other) noexcept
+{
+	if (this != &other) {
+		reset();
+		mArena = other.mArena;
+		mHandle = other.mHandle;
+		other.mArena = nullptr;
+		other.mHandle = RangeAllocator::INVALID;
+	}
+	return *this;
+}
+
+inline BufferArena::Allocation::operator bool() const noexcept
+{
+	return (mArena != nullptr);
+}
+
+inline void BufferArena::Allocation::reset() noexcept
+{
+	if (mArena != nullptr) {
+		mArena->mAllocator.free(mHandle);
+	}
+	mArena = nullptr;
+	mHandle = RangeAllocator::INVALID;
+}
+
+inline const Buffer &BufferArena::Allocation::getBuffer() const noexcept
+{
+	return mArena->mBuffer;
+}
+
+inline GLintptr BufferArena::Allocation::getOffset() const noexcept
+{
+	return static_cast<GLintptr>(mArena->mAllocator.getOffset(mHandle));
+}
+
+inline GLsizeiptr BufferArena::Allocation::getSize() const noexcept
+{
+	return static_cast<GLsizeiptr>(mArena->mAllocator.getSize(mHandle));
+}
+
+inline BufferArena::BufferArena(GLsizeiptr size, GLbitfield flags, GLsizeiptr granularity)
+{
+	create(size, flags, granularity);
+}
+
+inline BufferArena::operator bool() const noexcept
+{
+	return static_cast<bool>(mBuffer);
+}
+
+inline void BufferArena::create(GLsizeiptr size, GLbitfield flags, GLsizeiptr granularity)
+{
+	if (mAllocator.getStats().allocationCount != 0) {
+		throw OpenGLException("Buffer arena still has allocations");
+	}
+	mAllocator.reset(size, granularity);
+	mBuffer.create();
+	mBuffer.storage(static_cast<GLsizeiptr>(mAllocator.getCapacity()), nullptr, flags);
+}
+
+inline const Buffer &BufferArena::getBuffer() const noexcept
+{
+	return mBuffer;
+}
+
+inline BufferArena::Allocation BufferArena::allocate(GLsizeiptr size, GLsizeiptr alignment)
+{
+	RangeAllocator::Handle handle = mAllocator.allocate(size, alignment);
+	if (handle == RangeAllocator::INVALID) {
+		return Allocation();
+	}
+	return Allocation(this, handle);
+}
+
+inline BufferArena::Stats BufferArena::getStats() const noexcept
+{
+	return mAllocator.getStats();
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_BUFFERARENA_H
@@ -7,10 +7,28 @@
 namespace gtl {
 namespace ogl {
 
+// Command layouts read from the DRAW_INDIRECT buffer by the indirect draws.
+struct DrawArraysIndirectCommand {
+	GLuint count;
+	GLuint instanceCount;
+	GLuint first;
+	GLuint baseInstance;
+};
+
+struct DrawElementsIndirectCommand {
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;
+};
+
 void draw(GLenum mode, GLint first, GLsizei count);
 void draw(GLenum mode, GLint first, GLsizei count, GLsizei instances);
 void drawElements(GLenum mode, GLint first, GLsizei count, GLenum type);
 void drawElements(GLenum mode, GLint first, GLsizei count, GLenum type, GLsizei instances);
+void multiDrawIndirect(GLenum mode, GLintptr offset, GLsizei drawcount, GLsizei stride = 0);
+void multiDrawElementsIndirect(GLenum mode, GLenum type, GLintptr offset, GLsizei drawcount, GLsizei stride = 0);
 
 
 inline void draw(GLenum mode, GLint first, GLsizei count)
@@ -33,6 +51,16 @@ inline void drawElements(GLenum mode, GLint first, GLsizei count, GLenum type, G
 	glDrawElementsInstanced(mode, count, type, reinterpret_cast<GLvoid*>(first), instances);
 }
 
+inline void multiDrawIndirect(GLenum mode, GLintptr offset, GLsizei drawcount, GLsizei stride)
+{
+	glMultiDrawArraysIndirect(mode, reinterpret_cast<const GLvoid*>(offset), drawcount, stride);
+}
+
+inline void multiDrawElementsIndirect(GLenum mode, GLenum type, GLintptr offset, GLsizei drawcount, GLsizei stride)
+{
+	glMultiDrawElementsIndirect(mode, type, reinterpret_cast<const GLvoid*>(offset), drawcount, stride);
+}
+
 } // namespace ogl
 } // namespace gtl
 
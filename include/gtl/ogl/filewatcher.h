@@ -0,0 +1,177 @@
+#ifndef GTL_OGL_FILEWATCHER_H
+#define GTL_OGL_FILEWATCHER_H
+
+#include <cerrno>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+
+namespace gtl {
+namespace ogl {
+
+// Watches files for changes with inotify on a background thread. Paths are
+// relative to the root directory. The directories of the watched files are
+// watched instead of the files themselves, because many editors save by
+// replacing the file. On other platforms than Linux no changes are reported.
+class FileWatcher final
+{
+public:
+	explicit FileWatcher(const std::string &root = std::string());
+	~FileWatcher() noexcept;
+
+	void watch(const std::string &path);
+	std::vector<std::string> takeChanges();
+
+	static bool isSupported() noexcept;
+
+private:
+	FileWatcher(const FileWatcher &) = delete;
+	FileWatcher &operator=(const FileWatcher &) = delete;
+
+	void run();
+
+	std::string mRoot;
+	std::mutex mMutex;
+	std::set<std::string> mFiles;
+	std::set<std::string> mChanges;
+	std::unordered_map<int, std::string> mDirectories;
+	int mFd;
+	int mWakePipe[2];
+	std::thread mThread;
+
+};
+
+
+inline FileWatcher::FileWatcher(const std::string &root) :
+	mRoot(root),
+	mFd(-1),
+	mWakePipe{-1, -1}
+{
+	if (!mRoot.empty() && mRoot.back() != '/') {
+		mRoot += '/';
+	}
+#ifdef __linux__
+	mFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (mFd < 0) {
+		return;
+	}
+	if (pipe2(mWakePipe, O_NONBLOCK | O_CLOEXEC) != 0) {
+		::close(mFd);
+		mFd = -1;
+		return;
+	}
+	mThread = std::thread(&FileWatcher::run, this);
+#endif
+}
+
+inline FileWatcher::~FileWatcher() noexcept
+{
+#ifdef __linux__
+	if (mThread.joinable()) {
+		const char stop = 0;
+		while (write(mWakePipe[1], &stop, 1) < 0 && errno == EINTR) {
+		}
+		mThread.join();
+	}
+	if (mFd >= 0) {
+		::close(mFd);
+		::close(mWakePipe[0]);
+		::close(mWakePipe[1]);
+	}
+#endif
+}
+
+inline void FileWatcher::watch(const std::string &path)
+{
+	std::size_t slash = path.rfind('/');
+	std::string directory = (slash == std::string::npos) ? std::string() : path.substr(0, slash + 1);
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (!mFiles.insert(path).second) {
+		return;
+	}
+#ifdef __linux__
+	if (mFd < 0) {
+		return;
+	}
+	std::string fullPath = mRoot + directory;
+	int wd = inotify_add_watch(mFd, fullPath.empty() ? "." : fullPath.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+	if (wd >= 0) {
+		mDirectories[wd] = directory;
+	}
+#endif
+}
+
+inline std::vector<std::string> FileWatcher::takeChanges()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	std::vector<std::string> changes(mChanges.begin(), mChanges.end());
+	mChanges.clear();
+	return changes;
+}
+
+inline bool FileWatcher::isSupported() noexcept
+{
+#ifdef __linux__
+	return true;
+#else
+	return false;
+#endif
+}
+
+inline void FileWatcher::run()
+{
+#ifdef __linux__
+	alignas(struct inotify_event) char buffer[4096];
+	for (;;) {
+		pollfd fds[2] = {
+			{ mFd, POLLIN, 0 },
+			{ mWakePipe[0], POLLIN, 0 }
+		};
+		if (poll(fds, 2, -1) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return;
+		}
+		if (fds[1].revents != 0) {
+			return;
+		}
+
+		ssize_t length;
+		while ((length = read(mFd, buffer, sizeof(buffer))) > 0) {
+			std::lock_guard<std::mutex> lock(mMutex);
+			for (char *ptr = buffer; ptr < buffer + length; ) {
+				const inotify_event *event = reinterpret_cast<const inotify_event*>(ptr);
+				ptr += sizeof(inotify_event) + event->len;
+
+				auto directory = mDirectories.find(event->wd);
+				if (directory == mDirectories.end() || event->len == 0) {
+					continue;
+				}
+				// Other files in the same directory are not of interest.
+				std::string path = directory->second + event->name;
+				if (mFiles.count(path) != 0) {
+					mChanges.insert(path);
+				}
+			}
+		}
+	}
+#endif
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_FILEWATCHER_H
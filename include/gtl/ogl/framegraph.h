@@ -0,0 +1,756 @@
+#ifndef GTL_OGL_FRAMEGRAPH_H
+#define GTL_OGL_FRAMEGRAPH_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "gtl/ogl/buffer.h"
+#include "gtl/ogl/openglexception.h"
+#include "gtl/ogl/texture.h"
+
+
+namespace gtl {
+namespace ogl {
+
+// Frame graph of render passes. Passes declare the textures and buffers they
+// read and write, and compile() works out:
+//  - which passes are culled, because nothing which is kept or imported
+//    depends on their results;
+//  - the lifetime of every transient resource, from its first to its last
+//    use by a kept pass;
+//  - one physical texture or buffer for several transient resources whose
+//    lifetimes do not overlap. Textures of the same size and view class
+//    share storage through texture views;
+//  - the glMemoryBarrier bits each pass needs, which are only those for
+//    reading or overwriting results of image and shader storage writes.
+// Physical objects are kept between frames; those not used by a compile are
+// deleted. The graph itself is rebuilt with reset() every frame.
+class FrameGraph final
+{
+public:
+	typedef std::uint32_t Resource;
+	typedef std::uint32_t Pass;
+	typedef std::function<void(const FrameGraph &graph)> Execute;
+
+	enum class Access {
+		SAMPLED,
+		IMAGE,
+		RENDER_TARGET,
+		STORAGE,
+		UNIFORM,
+		VERTEX,
+		INDEX,
+		INDIRECT,
+		COPY
+	};
+
+	struct TextureDesc {
+		Texture::Target target;
+		GLenum internalformat;
+		GLsizei width;
+		GLsizei height;
+		// Array layers or the depth of 3D textures. Cube maps count their
+		// faces, so they have 6 layers and cube map arrays a multiple of 6.
+		GLsizei layers;
+		GLsizei levels;
+		GLsizei samples;
+	};
+
+	struct Stats {
+		std::uint64_t passes;
+		std::uint64_t culledPasses;
+		std::uint64_t transientTextures;
+		std::uint64_t transientBuffers;
+		std::uint64_t physicalTextures;
+		std::uint64_t physicalBuffers;
+		std::uint64_t createdViews;
+		std::uint64_t barriers;
+		// Memory of the transient resources with and without aliasing.
+		std::uint64_t unaliasedBytes;
+		std::uint64_t aliasedBytes;
+	};
+
+	FrameGraph() noexcept;
+
+	Resource createTexture(const std::string &name, const TextureDesc &desc);
+	Resource createBuffer(const std::string &name, GLsizeiptr size);
+	Resource importTexture(const std::string &name, Texture &texture);
+	Resource importBuffer(const std::string &name, Buffer &buffer);
+
+	Pass addPass(const std::string &name, Execute execute);
+	void read(Pass pass, Resource resource, Access access);
+	void write(Pass pass, Resource resource, Access access);
+	void setSideEffect(Pass pass);
+
+	void compile();
+	void execute();
+	void reset() noexcept;
+
+	const Texture &getTexture(Resource resource) const;
+	const Buffer &getBuffer(Resource resource) const;
+	const std::string &getName(Resource resource) const;
+	bool isCulled(Pass pass) const;
+	GLbitfield getBarrier(Pass pass) const;
+	const Stats &getStats() const noexcept;
+
+	static std::size_t getTextureSize(const TextureDesc &desc) noexcept;
+
+private:
+	struct Use {
+		Resource resource;
+		Access access;
+		bool write;
+	};
+
+	struct PassData {
+		std::string name;
+		Execute execute;
+		std::vector<Use> uses;
+		GLbitfield barrier;
+		bool sideEffect;
+		bool culled;
+	};
+
+	struct ResourceData {
+		std::string name;
+		bool texture;
+		TextureDesc desc;
+		GLsizeiptr size;
+		Texture *importedTexture;
+		Buffer *importedBuffer;
+		std::size_t first;
+		std::size_t last;
+		std::size_t physical;
+		const Texture *boundTexture;
+		const Buffer *boundBuffer;
+	};
+
+	struct View {
+		GLenum internalformat;
+		GLsizei levels;
+		GLsizei layers;
+		Texture texture;
+		bool used;
+	};
+
+	struct PhysicalTexture {
+		TextureDesc desc;
+		Texture texture;
+		std::vector<View> views;
+		std::size_t busyUntil;
+		bool used;
+	};
+
+	struct PhysicalBuffer {
+		GLsizeiptr size;
+		Buffer buffer;
+		std::size_t busyUntil;
+		bool used;
+	};
+
+	struct BarrierState {
+		bool incoherent;
+		GLbitfield synchronized;
+	};
+
+	static const std::size_t NONE = static_cast<std::size_t>(-1);
+
+	FrameGraph(const FrameGraph &) = delete;
+	FrameGraph &operator=(const FrameGraph &) = delete;
+
+	Resource addResource(const std::string &name, bool texture);
+	void cull();
+	void assignTexture(ResourceData &resource);
+	void assignBuffer(ResourceData &resource);
+	const Texture &getView(PhysicalTexture &physical, const TextureDesc &desc);
+	void computeBarriers();
+
+	static bool isCompatible(const TextureDesc &physical, const TextureDesc &desc) noexcept;
+	static void getFormatInfo(GLenum internalformat, std::size_t &bytes, GLenum &viewClass) noexcept;
+	static GLbitfield getBarrierBit(Access access, bool texture) noexcept;
+
+	std::vector<PassData> mPasses;
+	std::vector<ResourceData> mResources;
+	std::vector<PhysicalTexture> mTextures;
+	std::vector<PhysicalBuffer> mBuffers;
+	bool mCompiled;
+	Stats mStats;
+
+};
+
+
+inline FrameGraph::FrameGraph() noexcept :
+	mCompiled(false),
+	mStats()
+{
+}
+
+inline FrameGraph::Resource FrameGraph::createTexture(const std::string &name, const TextureDesc &desc)
+{
+	if ((desc.target == Texture::Target::T_CUBE_MAP && desc.layers != 6)
+		|| (desc.target == Texture::Target::T_CUBE_MAP_ARRAY && (desc.layers <= 0 || desc.layers % 6 != 0))) {
+		throw OpenGLException("Frame graph texture " + name + " needs 6 layers per cube map");
+	}
+	Resource resource = addResource(name, true);
+	mResources[resource].desc = desc;
+	return resource;
+}
+
+inline FrameGraph::Resource FrameGraph::createBuffer(const std::string &name, GLsizeiptr size)
+{
+	Resource resource = addResource(name, false);
+	mResources[resource].size = size;
+	return resource;
+}
+
+inline FrameGraph::Resource FrameGraph::importTexture(const std::string &name, Texture &texture)
+{
+	Resource resource = addResource(name, true);
+	mResources[resource].importedTexture = &texture;
+	return resource;
+}
+
+inline FrameGraph::Resource FrameGraph::importBuffer(const std::string &name, Buffer &buffer)
+{
+	Resource resource = addResource(name, false);
+	mResources[resource].importedBuffer = &buffer;
+	return resource;
+}
+
+inline FrameGraph::Pass FrameGraph::addPass(const std::string &name, Execute execute)
+{
+	PassData pass;
+	pass.name = name;
+	pass.execute = std::move(execute);
+	pass.barrier = 0;
+	pass.sideEffect = false;
+	pass.culled = false;
+	mPasses.push_back(std::move(pass));
+	mCompiled = false;
+	return static_cast<Pass>(mPasses.size() - 1);
+}
+
+inline void FrameGraph::read(Pass pass, Resource resource, Access access)
+{
+	Use use = { resource, access, false };
+	mPasses.at(pass).uses.push_back(use);
+	mCompiled = false;
+}
+
+inline void FrameGraph::write(Pass pass, Resource resource, Access access)
+{
+	Use use = { resource, access, true };
+	mPasses.at(pass).uses.push_back(use);
+	mCompiled = false;
+}
+
+inline void FrameGraph::setSideEffect(Pass pass)
+{
+	mPasses.at(pass).sideEffect = true;
+	mCompiled = false;
+}
+
+inline void FrameGraph::compile()
+{
+	mStats = Stats();
+	mStats.passes = mPasses.size();
+	cull();
+
+	// Lifetimes in the order of the kept passes.
+	for (ResourceData &resource : mResources) {
+		resource.first = NONE;
+		resource.last = NONE;
+		resource.physical = NONE;
+		resource.boundTexture = resource.importedTexture;
+		resource.boundBuffer = resource.importedBuffer;
+	}
+	for (std::size_t i = 0; i < mPasses.size(); ++i) {
+		if (mPasses[i].culled) {
+			continue;
+		}
+		for (const Use &use : mPasses[i].uses) {
+			ResourceData &resource = mResources[use.resource];
+			resource.first = std::min(resource.first, i);
+			resource.last = (resource.last == NONE) ? i : std::max(resource.last, i);
+		}
+	}
+
+	// Resources are placed in the order of their first use, so a physical
+	// object is free for the next one once the last user has finished.
+	std::vector<Resource> order;
+	for (Resource i = 0; i < mResources.size(); ++i) {
+		const ResourceData &resource = mResources[i];
+		if (resource.first != NONE && resource.importedTexture == nullptr && resource.importedBuffer == nullptr) {
+			order.push_back(i);
+		}
+	}
+	std::stable_sort(order.begin(), order.end(), [this](Resource a, Resource b) {
+		return mResources[a].first < mResources[b].first;
+	});
+	for (PhysicalTexture &physical : mTextures) {
+		physical.busyUntil = NONE;
+		physical.used = false;
+		for (View &view : physical.views) {
+			view.used = false;
+		}
+	}
+	for (PhysicalBuffer &physical : mBuffers) {
+		physical.busyUntil = NONE;
+		physical.used = false;
+	}
+	for (Resource i : order) {
+		if (mResources[i].texture) {
+			assignTexture(mResources[i]);
+		} else {
+			assignBuffer(mResources[i]);
+		}
+	}
+
+	// Physical objects which nothing used this frame are deleted.
+	std::vector<std::size_t> textureIndices(mTextures.size());
+	std::size_t textureCount = 0;
+	for (std::size_t i = 0; i < mTextures.size(); ++i) {
+		textureIndices[i] = NONE;
+		if (mTextures[i].used) {
+			textureIndices[i] = textureCount;
+			if (textureCount != i) {
+				mTextures[textureCount] = std::move(mTextures[i]);
+			}
+			++textureCount;
+		}
+	}
+	mTextures.erase(mTextures.begin() + textureCount, mTextures.end());
+	std::vector<std::size_t> bufferIndices(mBuffers.size());
+	std::size_t bufferCount = 0;
+	for (std::size_t i = 0; i < mBuffers.size(); ++i) {
+		bufferIndices[i] = NONE;
+		if (mBuffers[i].used) {
+			bufferIndices[i] = bufferCount;
+			if (bufferCount != i) {
+				mBuffers[bufferCount] = std::move(mBuffers[i]);
+			}
+			++bufferCount;
+		}
+	}
+	mBuffers.erase(mBuffers.begin() + bufferCount, mBuffers.end());
+
+	// Views are created and the unused ones of earlier frames deleted before
+	// any address is taken, since both move the views of a texture.
+	for (ResourceData &resource : mResources) {
+		if (resource.physical != NONE && resource.texture) {
+			resource.physical = textureIndices[resource.physical];
+			getView(mTextures[resource.physical], resource.desc);
+		}
+	}
+	for (PhysicalTexture &physical : mTextures) {
+		physical.views.erase(std::remove_if(physical.views.begin(), physical.views.end(), [](const View &view) {
+			return !view.used;
+		}), physical.views.end());
+	}
+
+	// Only now the addresses of the physical objects are stable.
+	for (ResourceData &resource : mResources) {
+		if (resource.physical == NONE) {
+			continue;
+		}
+		if (resource.texture) {
+			resource.boundTexture = &getView(mTextures[resource.physical], resource.desc);
+		} else {
+			resource.physical = bufferIndices[resource.physical];
+			resource.boundBuffer = &mBuffers[resource.physical].buffer;
+		}
+	}
+	mStats.physicalTextures = mTextures.size();
+	mStats.physicalBuffers = mBuffers.size();
+	for (const PhysicalTexture &physical : mTextures) {
+		mStats.aliasedBytes += getTextureSize(physical.desc);
+	}
+	for (const PhysicalBuffer &physical : mBuffers) {
+		mStats.aliasedBytes += physical.size;
+	}
+
+	computeBarriers();
+	mCompiled = true;
+}
+
+inline void FrameGraph::execute()
+{
+	if (!mCompiled) {
+		compile();
+	}
+	for (const PassData &pass : mPasses) {
+		if (pass.culled) {
+			continue;
+		}
+		if (pass.barrier != 0) {
+			glMemoryBarrier(pass.barrier);
+		}
+		if (pass.execute) {
+			pass.execute(*this);
+		}
+	}
+}
+
+inline void FrameGraph::reset() noexcept
+{
+	mPasses.clear();
+	mResources.clear();
+	mCompiled = false;
+}
+
+inline const Texture &FrameGraph::getTexture(Resource resource) const
+{
+	const ResourceData &data = mResources.at(resource);
+	if (!data.texture || data.boundTexture == nullptr) {
+		throw OpenGLException("Frame graph resource " + data.name + " is no allocated texture");
+	}
+	return *data.boundTexture;
+}
+
+inline const Buffer &FrameGraph::getBuffer(Resource resource) const
+{
+	const ResourceData &data = mResources.at(resource);
+	if (data.texture || data.boundBuffer == nullptr) {
+		throw OpenGLException("Frame graph resource " + data.name + " is no allocated buffer");
+	}
+	return *data.boundBuffer;
+}
+
+inline const std::string &FrameGraph::getName(Resource resource) const
+{
+	return mResources.at(resource).name;
+}
+
+inline bool FrameGraph::isCulled(Pass pass) const
+{
+	return mPasses.at(pass).culled;
+}
+
+inline GLbitfield FrameGraph::getBarrier(Pass pass) const
+{
+	return mPasses.at(pass).barrier;
+}
+
+inline const FrameGraph::Stats &FrameGraph::getStats() const noexcept
+{
+	return mStats;
+}
+
+inline std::size_t FrameGraph::getTextureSize(const TextureDesc &desc) noexcept
+{
+	std::size_t bytes;
+	GLenum viewClass;
+	getFormatInfo(desc.internalformat, bytes, viewClass);
+	bool volume = (desc.target == Texture::Target::T_3D);
+	std::size_t size = 0;
+	for (GLsizei level = 0; level < std::max(desc.levels, 1); ++level) {
+		std::size_t width = std::max(desc.width >> level, 1);
+		std::size_t height = std::max(desc.height >> level, 1);
+		std::size_t layers = volume ? std::max(desc.layers >> level, 1) : std::max(desc.layers, 1);
+		size += width * height * layers;
+	}
+	return size * bytes * std::max(desc.samples, 1);
+}
+
+inline FrameGraph::Resource FrameGraph::addResource(const std::string &name, bool texture)
+{
+	ResourceData resource;
+	resource.name = name;
+	resource.texture = texture;
+	resource.desc = TextureDesc();
+	resource.size = 0;
+	resource.importedTexture = nullptr;
+	resource.importedBuffer = nullptr;
+	resource.first = NONE;
+	resource.last = NONE;
+	resource.physical = NONE;
+	resource.boundTexture = nullptr;
+	resource.boundBuffer = nullptr;
+	mResources.push_back(std::move(resource));
+	mCompiled = false;
+	return static_cast<Resource>(mResources.size() - 1);
+}
+
+inline void FrameGraph::cull()
+{
+	// Walking backwards, a pass is needed if it has side effects or writes a
+	// resource which is imported or read by a later needed pass.
+	std::vector<bool> needed(mResources.size(), false);
+	for (std::size_t i = mPasses.size(); i-- > 0; ) {
+		PassData &pass = mPasses[i];
+		bool keep = pass.sideEffect;
+		for (const Use &use : pass.uses) {
+			const ResourceData &resource = mResources[use.resource];
+			bool imported = (resource.importedTexture != nullptr || resource.importedBuffer != nullptr);
+			keep = keep || (use.write && (imported || needed[use.resource]));
+		}
+		pass.culled = !keep;
+		if (pass.culled) {
+			++mStats.culledPasses;
+			continue;
+		}
+		for (const Use &use : pass.uses) {
+			if (!use.write) {
+				needed[use.resource] = true;
+			}
+		}
+	}
+}
+
+inline void FrameGraph::assignTexture(ResourceData &resource)
+{
+	++mStats.transientTextures;
+	mStats.unaliasedBytes += getTextureSize(resource.desc);
+
+	// An exact match needs no view; otherwise any compatible texture does.
+	std::size_t best = NONE;
+	for (std::size_t i = 0; i < mTextures.size(); ++i) {
+		PhysicalTexture &physical = mTextures[i];
+		if (physical.busyUntil != NONE && physical.busyUntil >= resource.first) {
+			continue;
+		}
+		if (!isCompatible(physical.desc, resource.desc)) {
+			continue;
+		}
+		bool exact = (physical.desc.internalformat == resource.desc.internalformat
+			&& physical.desc.levels == resource.desc.levels && physical.desc.layers == resource.desc.layers);
+		if (best == NONE || exact) {
+			best = i;
+		}
+		if (exact) {
+			break;
+		}
+	}
+	if (best == NONE) {
+		PhysicalTexture physical;
+		physical.desc = resource.desc;
+		physical.texture.create(resource.desc.target);
+		const TextureDesc &desc = resource.desc;
+		switch (desc.target) {
+		case Texture::Target::T_1D:
+			physical.texture.storage(desc.levels, desc.internalformat, desc.width);
+			break;
+		case Texture::Target::T_2D:
+		case Texture::Target::T_RECTANGLE:
+		case Texture::Target::T_CUBE_MAP:
+			physical.texture.storage(desc.levels, desc.internalformat, desc.width, desc.height);
+			break;
+		case Texture::Target::T_2D_MULTISAMPLE:
+			physical.texture.storageMultisample(desc.samples, desc.internalformat, desc.width, desc.height, GL_TRUE);
+			break;
+		case Texture::Target::T_2D_MULTISAMPLE_ARRAY:
+			physical.texture.storageMultisample(desc.samples, desc.internalformat, desc.width, desc.height, desc.layers, GL_TRUE);
+			break;
+		default:
+			physical.texture.storage(desc.levels, desc.internalformat, desc.width, desc.height, desc.layers);
+			break;
+		}
+		physical.busyUntil = NONE;
+		physical.used = false;
+		mTextures.push_back(std::move(physical));
+		best = mTextures.size() - 1;
+	}
+	mTextures[best].busyUntil = resource.last;
+	mTextures[best].used = true;
+	resource.physical = best;
+}
+
+inline void FrameGraph::assignBuffer(ResourceData &resource)
+{
+	++mStats.transientBuffers;
+	mStats.unaliasedBytes += resource.size;
+
+	// The smallest free buffer which is large enough.
+	std::size_t best = NONE;
+	for (std::size_t i = 0; i < mBuffers.size(); ++i) {
+		const PhysicalBuffer &physical = mBuffers[i];
+		if (physical.busyUntil != NONE && physical.busyUntil >= resource.first) {
+			continue;
+		}
+		if (physical.size >= resource.size && (best == NONE || physical.size < mBuffers[best].size)) {
+			best = i;
+		}
+	}
+	if (best == NONE) {
+		PhysicalBuffer physical;
+		physical.size = resource.size;
+		physical.buffer.create();
+		physical.buffer.storage(resource.size, nullptr, 0);
+		physical.busyUntil = NONE;
+		physical.used = false;
+		mBuffers.push_back(std::move(physical));
+		best = mBuffers.size() - 1;
+	}
+	mBuffers[best].busyUntil = resource.last;
+	mBuffers[best].used = true;
+	resource.physical = best;
+}
+
+inline const Texture &FrameGraph::getView(PhysicalTexture &physical, const TextureDesc &desc)
+{
+	if (physical.desc.internalformat == desc.internalformat && physical.desc.levels == desc.levels && physical.desc.layers == desc.layers) {
+		return physical.texture;
+	}
+	for (View &view : physical.views) {
+		if (view.internalformat == desc.internalformat && view.levels == desc.levels && view.layers == desc.layers) {
+			view.used = true;
+			return view.texture;
+		}
+	}
+	View view;
+	view.internalformat = desc.internalformat;
+	view.levels = desc.levels;
+	view.layers = desc.layers;
+	view.used = true;
+	view.texture.createView(desc.target, physical.texture, desc.internalformat, 0, desc.levels, 0, desc.layers);
+	physical.views.push_back(std::move(view));
+	++mStats.createdViews;
+	return physical.views.back().texture;
+}
+
+inline void FrameGraph::computeBarriers()
+{
+	// State per physical object; imported resources get their own.
+	std::vector<BarrierState> states(mTextures.size() + mBuffers.size());
+	std::vector<std::size_t> slots(mResources.size());
+	for (std::size_t i = 0; i < mResources.size(); ++i) {
+		const ResourceData &resource = mResources[i];
+		if (resource.physical == NONE) {
+			slots[i] = states.size();
+			states.push_back(BarrierState());
+		} else {
+			slots[i] = resource.physical + (resource.texture ? 0 : mTextures.size());
+		}
+	}
+	for (BarrierState &state : states) {
+		state.incoherent = false;
+		state.synchronized = 0;
+	}
+
+	for (PassData &pass : mPasses) {
+		pass.barrier = 0;
+		if (pass.culled) {
+			continue;
+		}
+		for (const Use &use : pass.uses) {
+			BarrierState &state = states[slots[use.resource]];
+			GLbitfield bit = getBarrierBit(use.access, mResources[use.resource].texture);
+			if (state.incoherent && (state.synchronized & bit) == 0) {
+				pass.barrier |= bit;
+				state.synchronized |= bit;
+			}
+		}
+		// Writes take effect after all reads of the pass.
+		for (const Use &use : pass.uses) {
+			if (!use.write) {
+				continue;
+			}
+			BarrierState &state = states[slots[use.resource]];
+			state.incoherent = (use.access == Access::IMAGE || use.access == Access::STORAGE);
+			state.synchronized = 0;
+		}
+		if (pass.barrier != 0) {
+			++mStats.barriers;
+		}
+	}
+}
+
+inline bool FrameGraph::isCompatible(const TextureDesc &physical, const TextureDesc &desc) noexcept
+{
+	if (physical.target != desc.target || physical.width != desc.width || physical.height != desc.height || physical.samples != desc.samples) {
+		return false;
+	}
+	// Views can select fewer levels and layers, but not fewer slices of 3D
+	// textures.
+	bool volume = (desc.target == Texture::Target::T_3D);
+	if (physical.levels < desc.levels || physical.layers < desc.layers || (volume && physical.layers != desc.layers)) {
+		return false;
+	}
+	std::size_t physicalBytes, bytes;
+	GLenum physicalClass, viewClass;
+	getFormatInfo(physical.internalformat, physicalBytes, physicalClass);
+	getFormatInfo(desc.internalformat, bytes, viewClass);
+	return (physicalClass == viewClass);
+}
+
+inline void FrameGraph::getFormatInfo(GLenum internalformat, std::size_t &bytes, GLenum &viewClass) noexcept
+{
+	switch (internalformat) {
+	case GL_RGBA32F: case GL_RGBA32UI: case GL_RGBA32I:
+		bytes = 16;
+		viewClass = GL_VIEW_CLASS_128_BITS;
+		return;
+	case GL_RGB32F: case GL_RGB32UI: case GL_RGB32I:
+		bytes = 12;
+		viewClass = GL_VIEW_CLASS_96_BITS;
+		return;
+	case GL_RGBA16F: case GL_RG32F: case GL_RGBA16UI: case GL_RG32UI: case GL_RGBA16I:
+	case GL_RG32I: case GL_RGBA16: case GL_RGBA16_SNORM:
+		bytes = 8;
+		viewClass = GL_VIEW_CLASS_64_BITS;
+		return;
+	case GL_RG16F: case GL_R11F_G11F_B10F: case GL_R32F: case GL_RGB10_A2UI: case GL_RGBA8UI:
+	case GL_RG16UI: case GL_R32UI: case GL_RGBA8I: case GL_RG16I: case GL_R32I: case GL_RGB10_A2:
+	case GL_RGBA8: case GL_RG16: case GL_RGBA8_SNORM: case GL_RG16_SNORM: case GL_SRGB8_ALPHA8:
+	case GL_RGB9_E5:
+		bytes = 4;
+		viewClass = GL_VIEW_CLASS_32_BITS;
+		return;
+	case GL_R16F: case GL_RG8UI: case GL_R16UI: case GL_RG8I: case GL_R16I: case GL_RG8:
+	case GL_R16: case GL_RG8_SNORM: case GL_R16_SNORM:
+		bytes = 2;
+		viewClass = GL_VIEW_CLASS_16_BITS;
+		return;
+	case GL_R8UI: case GL_R8I: case GL_R8: case GL_R8_SNORM:
+		bytes = 1;
+		viewClass = GL_VIEW_CLASS_8_BITS;
+		return;
+	case GL_DEPTH_COMPONENT16:
+		bytes = 2;
+		break;
+	case GL_DEPTH32F_STENCIL8:
+		bytes = 8;
+		break;
+	default:
+		// Also depth formats, which cannot be viewed as any other format.
+		bytes = 4;
+		break;
+	}
+	viewClass = internalformat;
+}
+
+inline GLbitfield FrameGraph::getBarrierBit(Access access, bool texture) noexcept
+{
+	switch (access) {
+	case Access::SAMPLED:
+		return GL_TEXTURE_FETCH_BARRIER_BIT;
+	case Access::IMAGE:
+		return GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+	case Access::RENDER_TARGET:
+		return GL_FRAMEBUFFER_BARRIER_BIT;
+	case Access::STORAGE:
+		return GL_SHADER_STORAGE_BARRIER_BIT;
+	case Access::UNIFORM:
+		return GL_UNIFORM_BARRIER_BIT;
+	case Access::VERTEX:
+		return GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT;
+	case Access::INDEX:
+		return GL_ELEMENT_ARRAY_BARRIER_BIT;
+	case Access::INDIRECT:
+		return GL_COMMAND_BARRIER_BIT;
+	case Access::COPY:
+		return texture ? GL_TEXTURE_UPDATE_BARRIER_BIT : GL_BUFFER_UPDATE_BARRIER_BIT;
+	}
+	return GL_ALL_BARRIER_BITS;
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_FRAMEGRAPH_H
@@ -0,0 +1,66 @@
+#ifndef GTL_OGL_HASHER_H
+#define GTL_OGL_HASHER_H
+
+#include <cstdint>
+#include <string>
+
+
+namespace gtl {
+namespace ogl {
+
+// Incremental 64 bit FNV-1a hash. Not suitable against malicious input, but
+// good enough to identify sources, states and layouts.
+class Hasher final
+{
+public:
+	Hasher() noexcept;
+
+	Hasher &add(const void *data, std::size_t size) noexcept;
+	Hasher &add(const std::string &str) noexcept;
+	template <class T>
+	Hasher &addValue(const T &value) noexcept;
+
+	std::uint64_t getValue() const noexcept;
+
+private:
+	std::uint64_t mValue;
+
+};
+
+
+inline Hasher::Hasher() noexcept :
+	mValue(14695981039346656037ull)
+{
+}
+
+inline Hasher &Hasher::add(const void *data, std::size_t size) noexcept
+{
+	const unsigned char *bytes = static_cast<const unsigned char*>(data);
+	for (std::size_t i = 0; i < size; ++i) {
+		mValue = (mValue ^ bytes[i]) * 1099511628211ull;
+	}
+	return *this;
+}
+
+inline Hasher &Hasher::add(const std::string &str) noexcept
+{
+	// Include the length, so that ("ab", "c") and ("a", "bc") differ.
+	addValue(str.size());
+	return add(str.data(), str.size());
+}
+
+template <class T>
+inline Hasher &Hasher::addValue(const T &value) noexcept
+{
+	return add(&value, sizeof(value));
+}
+
+inline std::uint64_t Hasher::getValue() const noexcept
+{
+	return mValue;
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_HASHER_H
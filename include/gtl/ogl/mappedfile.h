@@ -0,0 +1,165 @@
+#ifndef GTL_OGL_MAPPEDFILE_H
+#define GTL_OGL_MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace gtl {
+namespace ogl {
+
+// Read-only memory mapping of a whole file. Check with operator bool whether
+// the file could be mapped.
+class MappedFile final
+{
+public:
+	MappedFile() noexcept;
+	explicit MappedFile(const std::string &path);
+	~MappedFile() noexcept;
+
+	MappedFile(MappedFile &&other) noexcept;
+	MappedFile &operator = (MappedFile &&other) noexcept;
+	explicit operator bool () const noexcept;
+
+	bool open(const std::string &path);
+	void close() noexcept;
+
+	const void *getData() const noexcept;
+	std::size_t getSize() const noexcept;
+
+private:
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	const void *mData;
+	std::size_t mSize;
+
+};
+
+
+inline MappedFile::MappedFile() noexcept :
+	mData(nullptr),
+	mSize(0)
+{
+}
+
+inline MappedFile::MappedFile(const std::string &path) :
+	MappedFile()
+{
+	open(path);
+}
+
+inline MappedFile::~MappedFile() noexcept
+{
+	close();
+}
+
+inline MappedFile::MappedFile(MappedFile &&other) noexcept :
+	mData(other.mData),
+	mSize(other.mSize)
+{
+	other.mData = nullptr;
+	other.mSize = 0;
+}
+
+inline MappedFile &MappedFile::operator =(MappedFile &&other) noexcept
+{
+	if (this != &other) {
+		close();
+		mData = other.mData;
+		mSize = other.mSize;
+		other.mData = nullptr;
+		other.mSize = 0;
+	}
+	return *this;
+}
+
+inline MappedFile::operator bool() const noexcept
+{
+	return (mData != nullptr);
+}
+
+inline bool MappedFile::open(const std::string &path)
+{
+	close();
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (mapping == nullptr) {
+		return false;
+	}
+	mData = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (mData == nullptr) {
+		return false;
+	}
+	mSize = static_cast<std::size_t>(size.QuadPart);
+#else
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0) {
+		::close(fd);
+		return false;
+	}
+	void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+	mData = data;
+	mSize = static_cast<std::size_t>(info.st_size);
+#endif
+	return true;
+}
+
+inline void MappedFile::close() noexcept
+{
+	if (mData != nullptr) {
+#ifdef _WIN32
+		UnmapViewOfFile(mData);
+#else
+		munmap(const_cast<void*>(mData), mSize);
+#endif
+	}
+	mData = nullptr;
+	mSize = 0;
+}
+
+inline const void *MappedFile::getData() const noexcept
+{
+	return mData;
+}
+
+inline std::size_t MappedFile::getSize() const noexcept
+{
+	return mSize;
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_MAPPEDFILE_H
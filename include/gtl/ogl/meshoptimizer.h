@@ -0,0 +1,660 @@
+#ifndef GTL_OGL_MESHOPTIMIZER_H
+#define GTL_OGL_MESHOPTIMIZER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "gtl/ogl/openglexception.h"
+
+
+namespace gtl {
+namespace ogl {
+
+// Reorders triangle lists with 32 bit indices (GL_UNSIGNED_INT) for
+// drawElements(). Call optimizeVertexCache() first, then optionally
+// optimizeOverdraw(), then optimizeVertexFetch() and remapVertices() on every
+// vertex stream. The vertex cache uses the algorithm of Tom Forsyth, "Linear-
+// Speed Vertex Cache Optimisation". Large meshes are split into one chunk per
+// thread, which costs one cold cache per chunk.
+// Triangles are counter-clockwise; positions are three floats per vertex.
+class MeshOptimizer final
+{
+public:
+	// Average cache miss ratio per triangle and per vertex, simulated with a
+	// FIFO cache. The lower bounds are about 0.5 and 1.0.
+	struct Metrics {
+		double acmr;
+		double atvr;
+	};
+
+	// vertices and triangles index into Meshlets::vertices and
+	// Meshlets::triangles, the latter holding three local indices per
+	// triangle. A meshlet seen from eye faces away if
+	// dot(center - eye, coneAxis) >= coneCutoff * length(center - eye) + radius.
+	struct Meshlet {
+		std::uint32_t vertexOffset;
+		std::uint32_t triangleOffset;
+		std::uint32_t vertexCount;
+		std::uint32_t triangleCount;
+		float center[3];
+		float radius;
+		float coneAxis[3];
+		float coneCutoff;
+	};
+
+	struct Meshlets {
+		std::vector<Meshlet> meshlets;
+		std::vector<std::uint32_t> vertices;
+		std::vector<std::uint8_t> triangles;
+	};
+
+	struct Stats {
+		std::uint64_t triangles;
+		std::chrono::nanoseconds elapsed;
+		// Metrics around the last optimizeVertexCache() or
+		// optimizeOverdraw().
+		Metrics before;
+		Metrics after;
+	};
+
+	static const unsigned CACHE_SIZE = 32;
+	static const unsigned METRICS_CACHE_SIZE = 16;
+
+	explicit MeshOptimizer(unsigned threadCount = std::thread::hardware_concurrency());
+
+	void optimizeVertexCache(std::vector<std::uint32_t> &indices, std::size_t vertexCount);
+	// Splits the triangles into clusters where the cache is cold anyway, or
+	// where splitting raises the ACMR by no more than threshold, and sorts
+	// the clusters so that those facing outwards come first.
+	void optimizeOverdraw(std::vector<std::uint32_t> &indices, const float *positions, std::size_t positionStride, std::size_t vertexCount, float threshold = 1.05f);
+	void buildMeshlets(const std::vector<std::uint32_t> &indices, const float *positions, std::size_t positionStride, std::size_t vertexCount, Meshlets &meshlets, std::size_t maxVertices = 64, std::size_t maxTriangles = 124);
+
+	const Stats &getStats() const noexcept;
+	void resetStats() noexcept;
+
+	// Numbers vertices in the order of their first use and rewrites the
+	// indices. Returns the new index of every old vertex; unused vertices
+	// move to the end.
+	static std::vector<std::uint32_t> optimizeVertexFetch(std::vector<std::uint32_t> &indices, std::size_t vertexCount);
+	static void remapVertices(const std::vector<std::uint32_t> &remap, const void *src, std::size_t vertexSize, void *dst);
+	static Metrics getMetrics(const std::vector<std::uint32_t> &indices, std::size_t vertexCount, unsigned cacheSize = METRICS_CACHE_SIZE);
+
+private:
+	static const std::size_t MIN_CHUNK_TRIANGLES = 65536;
+
+	MeshOptimizer(const MeshOptimizer &) = delete;
+	MeshOptimizer &operator=(const MeshOptimizer &) = delete;
+
+	// Calls function(chunk) for every chunk, each on its own thread.
+	template <class Function>
+	void run(std::size_t chunks, Function function);
+	std::size_t getChunkCount(std::size_t triangleCount) const noexcept;
+
+	static void optimizeChunk(const std::uint32_t *indices, std::size_t triangleCount, std::size_t vertexCount, std::uint32_t *output);
+	static void buildChunk(const std::uint32_t *indices, std::size_t triangleCount, const float *positions, std::size_t positionStride, std::size_t vertexCount, std::size_t maxVertices, std::size_t maxTriangles, Meshlets &meshlets);
+	static void finishMeshlet(const float *positions, std::size_t positionStride, Meshlets &meshlets);
+	static const float *getPosition(const float *positions, std::size_t positionStride, std::uint32_t vertex) noexcept;
+	static void getTriangleNormal(const float *a, const float *b, const float *c, float *normal) noexcept;
+
+	unsigned mThreadCount;
+	Stats mStats;
+
+};
+
+
+inline MeshOptimizer::MeshOptimizer(unsigned threadCount) :
+	mThreadCount(std::max(threadCount, 1u)),
+	mStats()
+{
+}
+
+inline void MeshOptimizer::optimizeVertexCache(std::vector<std::uint32_t> &indices, std::size_t vertexCount)
+{
+	auto start = std::chrono::steady_clock::now();
+	const std::size_t triangleCount = indices.size() / 3;
+	mStats.before = getMetrics(indices, vertexCount);
+
+	// Chunks get the triangles of consecutive vertex ranges, by the smallest
+	// index of every triangle. That keeps neighbours together as long as the
+	// vertex order has some locality, which exporters usually provide.
+	const std::size_t chunks = getChunkCount(triangleCount);
+	std::vector<std::size_t> begins(chunks + 1, 0);
+	std::vector<std::uint32_t> input;
+	if (chunks == 1) {
+		begins[1] = triangleCount;
+		input.swap(indices);
+	} else {
+		auto getMin = [&](std::size_t t) {
+			return std::min(indices[t * 3], std::min(indices[t * 3 + 1], indices[t * 3 + 2]));
+		};
+		std::vector<std::uint32_t> chunkOf(vertexCount, 0);
+		for (std::size_t t = 0; t < triangleCount; ++t) {
+			++chunkOf[getMin(t)];
+		}
+		std::size_t sum = 0;
+		for (std::uint32_t &chunk : chunkOf) {
+			sum += chunk;
+			chunk = static_cast<std::uint32_t>(std::min((sum - chunk) * chunks / triangleCount, chunks - 1));
+		}
+		for (std::size_t t = 0; t < triangleCount; ++t) {
+			++begins[chunkOf[getMin(t)] + 1];
+		}
+		for (std::size_t c = 0; c < chunks; ++c) {
+			begins[c + 1] += begins[c];
+		}
+		input = indices;
+		std::vector<std::size_t> fill(begins.begin(), begins.end() - 1);
+		for (std::size_t t = 0; t < triangleCount; ++t) {
+			std::copy(&indices[t * 3], &indices[t * 3] + 3, &input[fill[chunkOf[getMin(t)]]++ * 3]);
+		}
+	}
+
+	indices.resize(input.size());
+	run(chunks, [&](std::size_t chunk) {
+		optimizeChunk(input.data() + begins[chunk] * 3, begins[chunk + 1] - begins[chunk], vertexCount, indices.data() + begins[chunk] * 3);
+	});
+	std::copy(input.begin() + triangleCount * 3, input.end(), indices.begin() + triangleCount * 3);
+
+	mStats.after = getMetrics(indices, vertexCount);
+	mStats.triangles += triangleCount;
+	mStats.elapsed += std::chrono::steady_clock::now() - start;
+}
+
+inline void MeshOptimizer::optimizeOverdraw(std::vector<std::uint32_t> &indices, const float *positions, std::size_t positionStride, std::size_t vertexCount, float threshold)
+{
+	// After "Fast Triangle Reordering for Vertex Locality and Reduced
+	// Overdraw" by Sander, Nehab and Barczak.
+	auto start = std::chrono::steady_clock::now();
+	const std::size_t triangleCount = indices.size() / 3;
+	mStats.before = getMetrics(indices, vertexCount);
+	if (positionStride == 0) {
+		positionStride = 3 * sizeof(float);
+	}
+
+	// Hard boundaries where a triangle misses with all three vertices, soft
+	// boundaries inside those where the ACMR so far is close enough to the
+	// ACMR of the whole cluster. Stamps up to reset belong to a flushed
+	// cache.
+	std::vector<std::uint32_t> stamps(vertexCount, 0);
+	std::uint32_t time = 0;
+	std::uint32_t reset = 0;
+	auto simulate = [&](std::size_t triangle) {
+		unsigned misses = 0;
+		for (int k = 0; k < 3; ++k) {
+			std::uint32_t v = indices[triangle * 3 + k];
+			if (stamps[v] <= reset || time - stamps[v] >= METRICS_CACHE_SIZE) {
+				stamps[v] = ++time;
+				++misses;
+			}
+		}
+		return misses;
+	};
+	std::vector<std::size_t> hard(1, 0);
+	for (std::size_t t = 0; t < triangleCount; ++t) {
+		if (simulate(t) == 3 && t > 0) {
+			hard.push_back(t);
+		}
+	}
+	hard.push_back(triangleCount);
+
+	std::vector<std::size_t> clusters;
+	for (std::size_t h = 0; h + 1 < hard.size(); ++h) {
+		const std::size_t begin = hard[h];
+		const std::size_t end = hard[h + 1];
+		if (begin == end) {
+			continue;
+		}
+		reset = time;
+		std::size_t misses = 0;
+		for (std::size_t t = begin; t < end; ++t) {
+			misses += simulate(t);
+		}
+		const double limit = static_cast<double>(misses) / (end - begin) * threshold;
+
+		reset = time;
+		std::size_t clusterBegin = begin;
+		misses = 0;
+		clusters.push_back(begin);
+		for (std::size_t t = begin; t < end; ++t) {
+			misses += simulate(t);
+			if (t + 1 < end && static_cast<double>(misses) / (t + 1 - clusterBegin) <= limit) {
+				clusters.push_back(t + 1);
+				clusterBegin = t + 1;
+				misses = 0;
+				reset = time;
+			}
+		}
+	}
+	const std::size_t clusterCount = clusters.size();
+	clusters.push_back(triangleCount);
+
+	// Area weighted centroid and normal of every cluster; the cross product
+	// is twice the area times the normal.
+	std::vector<float> centroids(clusterCount * 4);
+	std::vector<float> normals(clusterCount * 3);
+	const std::size_t threadCount = std::max<std::size_t>(std::min<std::size_t>(mThreadCount, clusterCount / 256), 1);
+	run(threadCount, [&](std::size_t thread) {
+		for (std::size_t c = clusterCount * thread / threadCount; c < clusterCount * (thread + 1) / threadCount; ++c) {
+			double centroid[3] = { 0.0, 0.0, 0.0 };
+			double normal[3] = { 0.0, 0.0, 0.0 };
+			double area = 0.0;
+			for (std::size_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+				const float *a = getPosition(positions, positionStride, indices[t * 3]);
+				const float *b = getPosition(positions, positionStride, indices[t * 3 + 1]);
+				const float *p = getPosition(positions, positionStride, indices[t * 3 + 2]);
+				float n[3];
+				getTriangleNormal(a, b, p, n);
+				double weight = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+				for (int k = 0; k < 3; ++k) {
+					centroid[k] += (a[k] + b[k] + p[k]) / 3.0 * weight;
+					normal[k] += n[k];
+				}
+				area += weight;
+			}
+			for (int k = 0; k < 3; ++k) {
+				centroids[c * 4 + k] = static_cast<float>(centroid[k]);
+				normals[c * 3 + k] = static_cast<float>(normal[k]);
+			}
+			centroids[c * 4 + 3] = static_cast<float>(area);
+		}
+	});
+
+	double meshCentroid[3] = { 0.0, 0.0, 0.0 };
+	double meshArea = 0.0;
+	for (std::size_t c = 0; c < clusterCount; ++c) {
+		for (int k = 0; k < 3; ++k) {
+			meshCentroid[k] += centroids[c * 4 + k];
+		}
+		meshArea += centroids[c * 4 + 3];
+	}
+
+	std::vector<float> keys(clusterCount, 0.0f);
+	std::vector<std::size_t> order(clusterCount);
+	for (std::size_t c = 0; c < clusterCount; ++c) {
+		const float area = centroids[c * 4 + 3];
+		const float *n = &normals[c * 3];
+		const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (area > 0.0f && length > 0.0f && meshArea > 0.0) {
+			for (int k = 0; k < 3; ++k) {
+				keys[c] += static_cast<float>(centroids[c * 4 + k] / area - meshCentroid[k] / meshArea) * n[k] / length;
+			}
+		}
+		order[c] = c;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+		return keys[a] > keys[b];
+	});
+
+	std::vector<std::uint32_t> output;
+	output.reserve(indices.size());
+	for (std::size_t c : order) {
+		output.insert(output.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+	}
+	std::copy(output.begin(), output.end(), indices.begin());
+
+	mStats.after = getMetrics(indices, vertexCount);
+	mStats.triangles += triangleCount;
+	mStats.elapsed += std::chrono::steady_clock::now() - start;
+}
+
+inline void MeshOptimizer::buildMeshlets(const std::vector<std::uint32_t> &indices, const float *positions, std::size_t positionStride, std::size_t vertexCount, Meshlets &meshlets, std::size_t maxVertices, std::size_t maxTriangles)
+{
+	if (maxVertices < 3 || maxVertices > 256 || maxTriangles < 1) {
+		throw OpenGLException("Meshlets need 3 to 256 vertices and at least one triangle");
+	}
+	auto start = std::chrono::steady_clock::now();
+	const std::size_t triangleCount = indices.size() / 3;
+	if (positionStride == 0) {
+		positionStride = 3 * sizeof(float);
+	}
+
+	const std::size_t chunks = getChunkCount(triangleCount);
+	std::vector<Meshlets> parts(chunks);
+	run(chunks, [&](std::size_t chunk) {
+		const std::size_t first = triangleCount * chunk / chunks;
+		const std::size_t last = triangleCount * (chunk + 1) / chunks;
+		buildChunk(indices.data() + first * 3, last - first, positions, positionStride, vertexCount, maxVertices, maxTriangles, parts[chunk]);
+	});
+
+	meshlets.meshlets.clear();
+	meshlets.vertices.clear();
+	meshlets.triangles.clear();
+	for (const Meshlets &part : parts) {
+		const std::uint32_t vertexOffset = static_cast<std::uint32_t>(meshlets.vertices.size());
+		const std::uint32_t triangleOffset = static_cast<std::uint32_t>(meshlets.triangles.size());
+		for (Meshlet meshlet : part.meshlets) {
+			meshlet.vertexOffset += vertexOffset;
+			meshlet.triangleOffset += triangleOffset;
+			meshlets.meshlets.push_back(meshlet);
+		}
+		meshlets.vertices.insert(meshlets.vertices.end(), part.vertices.begin(), part.vertices.end());
+		meshlets.triangles.insert(meshlets.triangles.end(), part.triangles.begin(), part.triangles.end());
+	}
+
+	mStats.triangles += triangleCount;
+	mStats.elapsed += std::chrono::steady_clock::now() - start;
+}
+
+inline const MeshOptimizer::Stats &MeshOptimizer::getStats() const noexcept
+{
+	return mStats;
+}
+
+inline void MeshOptimizer::resetStats() noexcept
+{
+	mStats = Stats();
+}
+
+inline std::vector<std::uint32_t> MeshOptimizer::optimizeVertexFetch(std::vector<std::uint32_t> &indices, std::size_t vertexCount)
+{
+	const std::uint32_t unused = ~0u;
+	std::vector<std::uint32_t> remap(vertexCount, unused);
+	std::uint32_t next = 0;
+	for (std::uint32_t &index : indices) {
+		if (remap[index] == unused) {
+			remap[index] = next++;
+		}
+		index = remap[index];
+	}
+	for (std::uint32_t &index : remap) {
+		if (index == unused) {
+			index = next++;
+		}
+	}
+	return remap;
+}
+
+inline void MeshOptimizer::remapVertices(const std::vector<std::uint32_t> &remap, const void *src, std::size_t vertexSize, void *dst)
+{
+	// dst must not overlap src.
+	const std::uint8_t *input = static_cast<const std::uint8_t*>(src);
+	std::uint8_t *output = static_cast<std::uint8_t*>(dst);
+	for (std::size_t v = 0; v < remap.size(); ++v) {
+		std::memcpy(output + remap[v] * vertexSize, input + v * vertexSize, vertexSize);
+	}
+}
+
+inline MeshOptimizer::Metrics MeshOptimizer::getMetrics(const std::vector<std::uint32_t> &indices, std::size_t vertexCount, unsigned cacheSize)
+{
+	// A vertex is in the FIFO if fewer than cacheSize misses happened since
+	// it was loaded; 0 means never loaded.
+	std::vector<std::uint32_t> stamps(vertexCount, 0);
+	std::uint32_t time = 0;
+	std::size_t used = 0;
+	for (std::uint32_t index : indices) {
+		if (stamps[index] == 0) {
+			++used;
+		}
+		if (stamps[index] == 0 || time - stamps[index] >= cacheSize) {
+			stamps[index] = ++time;
+		}
+	}
+
+	Metrics metrics;
+	metrics.acmr = indices.empty() ? 0.0 : static_cast<double>(time) / (indices.size() / 3);
+	metrics.atvr = (used == 0) ? 0.0 : static_cast<double>(time) / used;
+	return metrics;
+}
+
+template <class Function>
+inline void MeshOptimizer::run(std::size_t chunks, Function function)
+{
+	std::vector<std::thread> threads;
+	for (std::size_t chunk = 1; chunk < chunks; ++chunk) {
+		threads.emplace_back(function, chunk);
+	}
+	function(0);
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+}
+
+inline std::size_t MeshOptimizer::getChunkCount(std::size_t triangleCount) const noexcept
+{
+	// Every chunk starts with a cold cache, so small meshes stay in one.
+	return std::max<std::size_t>(std::min<std::size_t>(mThreadCount, triangleCount / MIN_CHUNK_TRIANGLES), 1);
+}
+
+inline void MeshOptimizer::optimizeChunk(const std::uint32_t *indices, std::size_t triangleCount, std::size_t vertexCount, std::uint32_t *output)
+{
+	// Scores of Forsyth: the last triangle gets a fixed score, the rest of
+	// the cache decays with its position, and vertices with few remaining
+	// triangles get a boost so that they are finished first.
+	const unsigned maxValence = 32;
+	float cacheScores[CACHE_SIZE];
+	float valenceScores[maxValence];
+	for (unsigned i = 0; i < CACHE_SIZE; ++i) {
+		cacheScores[i] = (i < 3) ? 0.75f : std::pow(1.0f - static_cast<float>(i - 3) / (CACHE_SIZE - 3), 1.5f);
+	}
+	for (unsigned i = 0; i < maxValence; ++i) {
+		valenceScores[i] = (i == 0) ? 0.0f : 2.0f / std::sqrt(static_cast<float>(i));
+	}
+	auto getScore = [&](int position, std::uint32_t remaining) {
+		if (remaining == 0) {
+			return -1.0f;
+		}
+		float score = (position < 0) ? 0.0f : cacheScores[position];
+		return score + ((remaining < maxValence) ? valenceScores[remaining] : 2.0f / std::sqrt(static_cast<float>(remaining)));
+	};
+
+	// Triangles of every vertex; the first remaining[v] entries are the ones
+	// not emitted yet.
+	std::vector<std::uint32_t> remaining(vertexCount, 0);
+	for (std::size_t i = 0; i < triangleCount * 3; ++i) {
+		++remaining[indices[i]];
+	}
+	std::vector<std::uint32_t> offsets(vertexCount + 1, 0);
+	for (std::size_t v = 0; v < vertexCount; ++v) {
+		offsets[v + 1] = offsets[v] + remaining[v];
+	}
+	std::vector<std::uint32_t> adjacency(triangleCount * 3);
+	std::vector<std::uint32_t> fill(offsets.begin(), offsets.end() - 1);
+	for (std::size_t t = 0; t < triangleCount; ++t) {
+		for (int k = 0; k < 3; ++k) {
+			adjacency[fill[indices[t * 3 + k]]++] = static_cast<std::uint32_t>(t);
+		}
+	}
+
+	std::vector<int> positions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (std::size_t v = 0; v < vertexCount; ++v) {
+		vertexScores[v] = getScore(-1, remaining[v]);
+	}
+	std::vector<bool> emitted(triangleCount, false);
+
+	std::uint32_t cache[CACHE_SIZE + 3];
+	std::uint32_t newCache[CACHE_SIZE + 3];
+	unsigned cacheCount = 0;
+	std::size_t cursor = 0;
+	std::size_t best = triangleCount;
+	for (std::size_t e = 0; e < triangleCount; ++e) {
+		if (best == triangleCount) {
+			// Nothing in the cache has triangles left, take the next one in
+			// input order.
+			while (emitted[cursor]) {
+				++cursor;
+			}
+			best = cursor;
+		}
+
+		const std::uint32_t *triangle = indices + best * 3;
+		std::copy(triangle, triangle + 3, output + e * 3);
+		emitted[best] = true;
+		for (int k = 0; k < 3; ++k) {
+			const std::uint32_t v = triangle[k];
+			std::uint32_t *list = &adjacency[offsets[v]];
+			std::uint32_t *end = list + remaining[v];
+			*std::find(list, end, static_cast<std::uint32_t>(best)) = *(end - 1);
+			--remaining[v];
+		}
+
+		// Move the triangle to the front of the LRU cache.
+		unsigned newCount = 0;
+		for (int k = 0; k < 3; ++k) {
+			newCache[newCount++] = triangle[k];
+		}
+		for (unsigned i = 0; i < cacheCount; ++i) {
+			const std::uint32_t v = cache[i];
+			if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+				newCache[newCount++] = v;
+			}
+		}
+		for (unsigned i = CACHE_SIZE; i < newCount; ++i) {
+			positions[newCache[i]] = -1;
+			vertexScores[newCache[i]] = getScore(-1, remaining[newCache[i]]);
+		}
+		cacheCount = (newCount < CACHE_SIZE) ? newCount : CACHE_SIZE;
+		std::copy(newCache, newCache + cacheCount, cache);
+		for (unsigned i = 0; i < cacheCount; ++i) {
+			positions[cache[i]] = static_cast<int>(i);
+			vertexScores[cache[i]] = getScore(static_cast<int>(i), remaining[cache[i]]);
+		}
+
+		// Only triangles of cached vertices changed their score.
+		best = triangleCount;
+		float bestScore = -1.0f;
+		for (unsigned i = 0; i < cacheCount; ++i) {
+			const std::uint32_t v = cache[i];
+			for (std::uint32_t a = offsets[v]; a < offsets[v] + remaining[v]; ++a) {
+				const std::uint32_t t = adjacency[a];
+				const float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+				if (score > bestScore) {
+					bestScore = score;
+					best = t;
+				}
+			}
+		}
+	}
+}
+
+inline void MeshOptimizer::buildChunk(const std::uint32_t *indices, std::size_t triangleCount, const float *positions, std::size_t positionStride, std::size_t vertexCount, std::size_t maxVertices, std::size_t maxTriangles, Meshlets &meshlets)
+{
+	// Greedily in index order, which is already local after
+	// optimizeVertexCache().
+	const std::uint16_t unused = 0xFFFF;
+	std::vector<std::uint16_t> local(vertexCount, unused);
+	std::size_t vertexBegin = 0;
+	std::size_t triangleBegin = 0;
+	auto finish = [&]() {
+		Meshlet meshlet;
+		meshlet.vertexOffset = static_cast<std::uint32_t>(vertexBegin);
+		meshlet.triangleOffset = static_cast<std::uint32_t>(triangleBegin);
+		meshlet.vertexCount = static_cast<std::uint32_t>(meshlets.vertices.size() - vertexBegin);
+		meshlet.triangleCount = static_cast<std::uint32_t>((meshlets.triangles.size() - triangleBegin) / 3);
+		meshlets.meshlets.push_back(meshlet);
+		finishMeshlet(positions, positionStride, meshlets);
+		for (std::size_t i = vertexBegin; i < meshlets.vertices.size(); ++i) {
+			local[meshlets.vertices[i]] = unused;
+		}
+		vertexBegin = meshlets.vertices.size();
+		triangleBegin = meshlets.triangles.size();
+	};
+
+	for (std::size_t t = 0; t < triangleCount; ++t) {
+		const std::uint32_t *triangle = indices + t * 3;
+		std::size_t added = (local[triangle[0]] == unused) ? 1 : 0;
+		added += (local[triangle[1]] == unused && triangle[1] != triangle[0]) ? 1 : 0;
+		added += (local[triangle[2]] == unused && triangle[2] != triangle[0] && triangle[2] != triangle[1]) ? 1 : 0;
+		const std::size_t vertices = meshlets.vertices.size() - vertexBegin;
+		const std::size_t triangles = (meshlets.triangles.size() - triangleBegin) / 3;
+		if (vertices + added > maxVertices || triangles + 1 > maxTriangles) {
+			finish();
+		}
+		for (int k = 0; k < 3; ++k) {
+			const std::uint32_t v = triangle[k];
+			if (local[v] == unused) {
+				local[v] = static_cast<std::uint16_t>(meshlets.vertices.size() - vertexBegin);
+				meshlets.vertices.push_back(v);
+			}
+			meshlets.triangles.push_back(static_cast<std::uint8_t>(local[v]));
+		}
+	}
+	if (meshlets.triangles.size() > triangleBegin) {
+		finish();
+	}
+}
+
+inline void MeshOptimizer::finishMeshlet(const float *positions, std::size_t positionStride, Meshlets &meshlets)
+{
+	Meshlet &meshlet = meshlets.meshlets.back();
+
+	// Bounding sphere around the center of the bounding box.
+	float low[3];
+	float high[3];
+	const float *first = getPosition(positions, positionStride, meshlets.vertices[meshlet.vertexOffset]);
+	std::copy(first, first + 3, low);
+	std::copy(first, first + 3, high);
+	for (std::uint32_t i = 0; i < meshlet.vertexCount; ++i) {
+		const float *p = getPosition(positions, positionStride, meshlets.vertices[meshlet.vertexOffset + i]);
+		for (int k = 0; k < 3; ++k) {
+			low[k] = std::min(low[k], p[k]);
+			high[k] = std::max(high[k], p[k]);
+		}
+	}
+	float radius = 0.0f;
+	for (int k = 0; k < 3; ++k) {
+		meshlet.center[k] = (low[k] + high[k]) * 0.5f;
+	}
+	for (std::uint32_t i = 0; i < meshlet.vertexCount; ++i) {
+		const float *p = getPosition(positions, positionStride, meshlets.vertices[meshlet.vertexOffset + i]);
+		float d[3] = { p[0] - meshlet.center[0], p[1] - meshlet.center[1], p[2] - meshlet.center[2] };
+		radius = std::max(radius, d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+	}
+	meshlet.radius = std::sqrt(radius);
+
+	// Normal cone: the average of the unit normals, and the widest angle to
+	// any of them. Cones of half a sphere or more are never culled.
+	std::vector<float> normals(meshlet.triangleCount * 3, 0.0f);
+	float axis[3] = { 0.0f, 0.0f, 0.0f };
+	for (std::uint32_t t = 0; t < meshlet.triangleCount; ++t) {
+		const std::uint8_t *triangle = &meshlets.triangles[meshlet.triangleOffset + t * 3];
+		float *n = &normals[t * 3];
+		getTriangleNormal(getPosition(positions, positionStride, meshlets.vertices[meshlet.vertexOffset + triangle[0]]),
+			getPosition(positions, positionStride, meshlets.vertices[meshlet.vertexOffset + triangle[1]]),
+			getPosition(positions, positionStride, meshlets.vertices[meshlet.vertexOffset + triangle[2]]), n);
+		const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		for (int k = 0; k < 3; ++k) {
+			n[k] = (length > 0.0f) ? n[k] / length : 0.0f;
+			axis[k] += n[k];
+		}
+	}
+	const float length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+	float minDot = 1.0f;
+	for (int k = 0; k < 3; ++k) {
+		axis[k] = (length > 0.0f) ? axis[k] / length : 0.0f;
+		meshlet.coneAxis[k] = axis[k];
+	}
+	for (std::uint32_t t = 0; t < meshlet.triangleCount; ++t) {
+		const float *n = &normals[t * 3];
+		if (n[0] != 0.0f || n[1] != 0.0f || n[2] != 0.0f) {
+			minDot = std::min(minDot, n[0] * axis[0] + n[1] * axis[1] + n[2] * axis[2]);
+		}
+	}
+	meshlet.coneCutoff = (length > 0.0f && minDot > 0.0f) ? std::sqrt(1.0f - minDot * minDot) : 1.0f;
+}
+
+inline const float *MeshOptimizer::getPosition(const float *positions, std::size_t positionStride, std::uint32_t vertex) noexcept
+{
+	return reinterpret_cast<const float*>(reinterpret_cast<const std::uint8_t*>(positions) + vertex * positionStride);
+}
+
+inline void MeshOptimizer::getTriangleNormal(const float *a, const float *b, const float *c, float *normal) noexcept
+{
+	const float u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+	const float v[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+	normal[0] = u[1] * v[2] - u[2] * v[1];
+	normal[1] = u[2] * v[0] - u[0] * v[2];
+	normal[2] = u[0] * v[1] - u[1] * v[0];
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_MESHOPTIMIZER_H
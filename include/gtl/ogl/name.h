@@ -0,0 +1,102 @@
+#ifndef GTL_OGL_NAME_H
+#define GTL_OGL_NAME_H
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+
+namespace gtl {
+namespace ogl {
+
+// Interned string. Every distinct string gets a small, process-wide unique
+// id, so looking it up later does neither hash nor compare strings.
+// Construct names once and keep them around:
+//
+//     static const Name modelView("modelView");
+class Name final
+{
+public:
+	explicit Name(const std::string &str);
+	explicit Name(const char *str);
+
+	std::uint32_t getId() const noexcept;
+	const std::string &getString() const;
+
+	bool operator == (const Name &other) const noexcept;
+	bool operator != (const Name &other) const noexcept;
+
+	static std::size_t getCount();
+
+private:
+	struct Registry {
+		std::mutex mutex;
+		std::unordered_map<std::string, std::uint32_t> ids;
+		std::deque<std::string> strings;
+	};
+
+	static Registry &getRegistry();
+
+	std::uint32_t mId;
+
+};
+
+
+inline Name::Name(const std::string &str)
+{
+	Registry &registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	auto result = registry.ids.insert(std::make_pair(str, static_cast<std::uint32_t>(registry.strings.size())));
+	if (result.second) {
+		registry.strings.push_back(str);
+	}
+	mId = result.first->second;
+}
+
+inline Name::Name(const char *str) :
+	Name(std::string(str))
+{
+}
+
+inline std::uint32_t Name::getId() const noexcept
+{
+	return mId;
+}
+
+inline const std::string &Name::getString() const
+{
+	Registry &registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	// Elements of a deque never move when appending.
+	return registry.strings[mId];
+}
+
+inline bool Name::operator ==(const Name &other) const noexcept
+{
+	return (mId == other.mId);
+}
+
+inline bool Name::operator !=(const Name &other) const noexcept
+{
+	return (mId != other.mId);
+}
+
+inline std::size_t Name::getCount()
+{
+	Registry &registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	return registry.strings.size();
+}
+
+inline Name::Registry &Name::getRegistry()
+{
+	static Registry registry;
+	return registry;
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_NAME_H
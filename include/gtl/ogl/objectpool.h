@@ -0,0 +1,218 @@
+#ifndef GTL_OGL_OBJECTPOOL_H
+#define GTL_OGL_OBJECTPOOL_H
+
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "gtl/ogl/buffer.h"
+#include "gtl/ogl/openglexception.h"
+#include "gtl/ogl/programpipeline.h"
+#include "gtl/ogl/sampler.h"
+#include "gtl/ogl/texture.h"
+#include "gtl/ogl/transformfeedback.h"
+#include "gtl/ogl/vertexarray.h"
+
+
+namespace gtl {
+namespace ogl {
+
+template <class T>
+struct ObjectPoolTraits;
+
+template <>
+struct ObjectPoolTraits<Buffer>
+{
+	static const bool NEEDS_TARGET = false;
+	static void create(GLenum, GLsizei n, GLuint *names) { glCreateBuffers(n, names); }
+	static void destroy(GLsizei n, const GLuint *names) { glDeleteBuffers(n, names); }
+};
+
+template <>
+struct ObjectPoolTraits<ProgramPipeline>
+{
+	static const bool NEEDS_TARGET = false;
+	static void create(GLenum, GLsizei n, GLuint *names) { glCreateProgramPipelines(n, names); }
+	static void destroy(GLsizei n, const GLuint *names) { glDeleteProgramPipelines(n, names); }
+};
+
+template <>
+struct ObjectPoolTraits<Sampler>
+{
+	static const bool NEEDS_TARGET = false;
+	static void create(GLenum, GLsizei n, GLuint *names) { glCreateSamplers(n, names); }
+	static void destroy(GLsizei n, const GLuint *names) { glDeleteSamplers(n, names); }
+};
+
+template <>
+struct ObjectPoolTraits<Texture>
+{
+	static const bool NEEDS_TARGET = true;
+	static void create(GLenum target, GLsizei n, GLuint *names) { glCreateTextures(target, n, names); }
+	static void destroy(GLsizei n, const GLuint *names) { glDeleteTextures(n, names); }
+};
+
+template <>
+struct ObjectPoolTraits<TransformFeedback>
+{
+	static const bool NEEDS_TARGET = false;
+	static void create(GLenum, GLsizei n, GLuint *names) { glCreateTransformFeedbacks(n, names); }
+	static void destroy(GLsizei n, const GLuint *names) { glDeleteTransformFeedbacks(n, names); }
+};
+
+template <>
+struct ObjectPoolTraits<VertexArray>
+{
+	static const bool NEEDS_TARGET = false;
+	static void create(GLenum, GLsizei n, GLuint *names) { glCreateVertexArrays(n, names); }
+	static void destroy(GLsizei n, const GLuint *names) { glDeleteVertexArrays(n, names); }
+};
+
+// Creates object names in batches and deletes recycled objects in batches.
+// Recycled names are never handed out again, since objects keep their state
+// (e.g. immutable storage) after they have been used. The target is only
+// used for textures, and a texture pool throws without one.
+template <class T>
+class ObjectPool final
+{
+public:
+	struct Stats {
+		std::uint64_t hits;
+		std::uint64_t misses;
+		std::uint64_t createdBatches;
+		std::uint64_t created;
+		std::uint64_t deletedBatches;
+		std::uint64_t deleted;
+	};
+
+	explicit ObjectPool(GLsizei batchSize = 64, GLenum target = 0);
+	~ObjectPool() noexcept;
+
+	T acquire();
+	void recycle(T &&object);
+	void collect() noexcept;
+	void shrink() noexcept;
+
+	GLsizei getBatchSize() const noexcept;
+	void setBatchSize(GLsizei batchSize);
+	std::size_t getCachedCount() const noexcept;
+	std::size_t getPendingCount() const noexcept;
+	const Stats &getStats() const noexcept;
+
+private:
+	ObjectPool(const ObjectPool &) = delete;
+	ObjectPool &operator=(const ObjectPool &) = delete;
+
+	std::vector<GLuint> mCached;
+	std::vector<GLuint> mPending;
+	GLsizei mBatchSize;
+	GLenum mTarget;
+	Stats mStats;
+
+};
+
+
+template <class T>
+inline ObjectPool<T>::ObjectPool(GLsizei batchSize, GLenum target) :
+	mBatchSize(0),
+	mTarget(target),
+	mStats()
+{
+	if (ObjectPoolTraits<T>::NEEDS_TARGET && target == 0) {
+		throw OpenGLException("Object pool needs a texture target");
+	}
+	setBatchSize(batchSize);
+}
+
+template <class T>
+inline ObjectPool<T>::~ObjectPool() noexcept
+{
+	collect();
+	shrink();
+}
+
+template <class T>
+inline T ObjectPool<T>::acquire()
+{
+	if (mCached.empty()) {
+		mCached.resize(mBatchSize);
+		ObjectPoolTraits<T>::create(mTarget, mBatchSize, mCached.data());
+		++mStats.misses;
+		++mStats.createdBatches;
+		mStats.created += mBatchSize;
+	} else {
+		++mStats.hits;
+	}
+	GLuint name = mCached.back();
+	mCached.pop_back();
+	return T(name);
+}
+
+template <class T>
+inline void ObjectPool<T>::recycle(T &&object)
+{
+	if (object) {
+		mPending.push_back(object.release());
+	}
+}
+
+template <class T>
+inline void ObjectPool<T>::collect() noexcept
+{
+	if (!mPending.empty()) {
+		ObjectPoolTraits<T>::destroy(static_cast<GLsizei>(mPending.size()), mPending.data());
+		++mStats.deletedBatches;
+		mStats.deleted += mPending.size();
+		mPending.clear();
+	}
+}
+
+template <class T>
+inline void ObjectPool<T>::shrink() noexcept
+{
+	if (!mCached.empty()) {
+		ObjectPoolTraits<T>::destroy(static_cast<GLsizei>(mCached.size()), mCached.data());
+		++mStats.deletedBatches;
+		mStats.deleted += mCached.size();
+		mCached.clear();
+	}
+}
+
+template <class T>
+inline GLsizei ObjectPool<T>::getBatchSize() const noexcept
+{
+	return mBatchSize;
+}
+
+template <class T>
+inline void ObjectPool<T>::setBatchSize(GLsizei batchSize)
+{
+	if (batchSize <= 0) {
+		throw OpenGLException("Object pool batch size must be positive");
+	}
+	mBatchSize = batchSize;
+}
+
+template <class T>
+inline std::size_t ObjectPool<T>::getCachedCount() const noexcept
+{
+	return mCached.size();
+}
+
+template <class T>
+inline std::size_t ObjectPool<T>::getPendingCount() const noexcept
+{
+	return mPending.size();
+}
+
+template <class T>
+inline const typename ObjectPool<T>::Stats &ObjectPool<T>::getStats() const noexcept
+{
+	return mStats;
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_OBJECTPOOL_H
@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <GL/glew.h>
@@ -11,8 +12,11 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "gtl/ogl/name.h"
+#include "gtl/ogl/programreflection.h"
 #include "gtl/ogl/shader.h"
 #include "gtl/ogl/shaderexception.h"
+#include "gtl/ogl/uniformshadow.h"
 
 
 namespace gtl {
@@ -45,13 +49,24 @@ public:
 	void bindFragDataLocation(GLuint location, const std::string &name);
 	void bindAttribLocation(GLuint location, const std::string &name);
 	void setTransformFeedbackVaryings(GLsizei count, const char **varyings, GLenum bufferMode);
-	void link();
+	void link(bool reflect = false);
+	void startLink();
+	bool isLinkCompleted() const;
+	bool getLinkStatus() const;
 	void validate();
+	void reflect();
+
+	void setParameter(GLenum pname, GLint value);
+	void setBinary(GLenum binaryFormat, const void *binary, GLsizei length);
+	std::vector<char> getBinary(GLenum &binaryFormat) const;
 
 	std::string getInfoLog() const;
+	const ProgramReflection &getReflection() const noexcept;
 	// TODO getFragDataLocation ?
 	GLint getAttribLocation(const std::string &name) const;
+	GLint getAttribLocation(const Name &name) const;
 	GLint getUniformLocation(const std::string &name) const;
+	GLint getUniformLocation(const Name &name) const;
 
 	void setUniform(GLint location, GLint value) const;
 	void setUniform(GLint location, GLfloat value) const;
@@ -60,11 +75,18 @@ public:
 	void setUniform(GLint location, const glm::mat3 &value) const;
 	void setUniform(GLint location, const glm::mat4 &value) const;
 
+	bool isShadowed() const noexcept;
+	void setShadowed(bool shadowed);
+	const UniformShadow::Stats &getUniformStats() const noexcept;
+	void resetUniformStats() noexcept;
+
 private:
 	Program(const Program &) = delete;
 	Program &operator=(const Program &) = delete;
 
 	GLuint mId;
+	ProgramReflection mReflection;
+	mutable UniformShadow mShadow;
 };
 
 
@@ -99,13 +121,22 @@ inline Program::~Program() noexcept
 }
 
 inline Program::Program(Program &&other) noexcept :
-	mId(other.release())
+	mId(other.mId),
+	mReflection(std::move(other.mReflection)),
+	mShadow(std::move(other.mShadow))
 {
+	other.mId = 0;
 }
 
 inline Program &Program::operator =(Program &&other) noexcept
 {
-	reset(other.release());
+	if (this != &other) {
+		reset();
+		mId = other.mId;
+		other.mId = 0;
+		mReflection = std::move(other.mReflection);
+		mShadow = std::move(other.mShadow);
+	}
 	return *this;
 }
 
@@ -136,12 +167,16 @@ inline void Program::reset(GLuint programName) noexcept
 		glDeleteProgram(mId);
 	}
 	mId = programName;
+	mReflection.clear();
+	mShadow.invalidate();
 }
 
 inline GLuint Program::release() noexcept
 {
 	GLuint tmp = mId;
 	mId = 0;
+	mReflection.clear();
+	mShadow.invalidate();
 	return tmp;
 }
 
@@ -180,14 +215,39 @@ inline void Program::setTransformFeedbackVaryings(GLsizei count, const char **va
 	glTransformFeedbackVaryings(mId, count, varyings, bufferMode);
 }
 
-inline void Program::link()
+inline void Program::link(bool reflect)
 {
-	GLint status;
-	glLinkProgram(mId);
-	glGetProgramiv(mId, GL_LINK_STATUS, &status);
-	if (status != GL_TRUE) {
+	startLink();
+	if (!getLinkStatus()) {
 		throw ShaderException("Error while linking shader program");
 	}
+	if (reflect) {
+		this->reflect();
+	}
+}
+
+inline void Program::startLink()
+{
+	mReflection.clear();
+	mShadow.invalidate();
+	glLinkProgram(mId);
+}
+
+inline bool Program::isLinkCompleted() const
+{
+	if (!Shader::isParallelCompileSupported()) {
+		return true;
+	}
+	GLint completed;
+	glGetProgramiv(mId, GL_COMPLETION_STATUS_KHR, &completed);
+	return (completed == GL_TRUE);
+}
+
+inline bool Program::getLinkStatus() const
+{
+	GLint status;
+	glGetProgramiv(mId, GL_LINK_STATUS, &status);
+	return (status == GL_TRUE);
 }
 
 inline void Program::validate()
@@ -200,6 +260,40 @@ inline void Program::validate()
 	}
 }
 
+inline void Program::reflect()
+{
+	mReflection.reflect(mId);
+}
+
+inline void Program::setParameter(GLenum pname, GLint value)
+{
+	glProgramParameteri(mId, pname, value);
+}
+
+inline void Program::setBinary(GLenum binaryFormat, const void *binary, GLsizei length)
+{
+	GLint status;
+	mReflection.clear();
+	mShadow.invalidate();
+	glProgramBinary(mId, binaryFormat, binary, length);
+	glGetProgramiv(mId, GL_LINK_STATUS, &status);
+	if (status != GL_TRUE) {
+		throw ShaderException("Program binary was rejected");
+	}
+}
+
+inline std::vector<char> Program::getBinary(GLenum &binaryFormat) const
+{
+	GLint length;
+	glGetProgramiv(mId, GL_PROGRAM_BINARY_LENGTH, &length);
+	std::vector<char> binary(length);
+	if (length != 0) {
+		glGetProgramBinary(mId, length, &length, &binaryFormat, binary.data());
+		binary.resize(length);
+	}
+	return binary;
+}
+
 inline std::string Program::getInfoLog() const
 {
 	GLint lenght;
@@ -213,44 +307,97 @@ inline std::string Program::getInfoLog() const
 	}
 }
 
+inline const ProgramReflection &Program::getReflection() const noexcept
+{
+	return mReflection;
+}
+
 inline GLint Program::getAttribLocation(const std::string &name) const
 {
 	return glGetAttribLocation(mId, name.c_str());
 }
 
+inline GLint Program::getAttribLocation(const Name &name) const
+{
+	if (mReflection.empty()) {
+		return getAttribLocation(name.getString());
+	}
+	return mReflection.getAttribLocation(name);
+}
+
 inline GLint Program::getUniformLocation(const std::string &name) const
 {
 	return glGetUniformLocation(mId, name.c_str());
 }
 
+inline GLint Program::getUniformLocation(const Name &name) const
+{
+	if (mReflection.empty()) {
+		return getUniformLocation(name.getString());
+	}
+	return mReflection.getUniformLocation(name);
+}
+
 inline void Program::setUniform(GLint location, GLint value) const
 {
-	glProgramUniform1i(mId, location, value);
+	if (mShadow.update(location, &value, sizeof(value))) {
+		glProgramUniform1i(mId, location, value);
+	}
 }
 
 inline void Program::setUniform(GLint location, GLfloat value) const
 {
-	glProgramUniform1f(mId, location, value);
+	if (mShadow.update(location, &value, sizeof(value))) {
+		glProgramUniform1f(mId, location, value);
+	}
 }
 
 inline void Program::setUniform(GLint location, const glm::vec3 &value) const
 {
-	glProgramUniform3fv(mId, location, 1, glm::value_ptr(value));
+	if (mShadow.update(location, &value, sizeof(value))) {
+		glProgramUniform3fv(mId, location, 1, glm::value_ptr(value));
+	}
 }
 
 inline void Program::setUniform(GLint location, const glm::vec4 &value) const
 {
-	glProgramUniform4fv(mId, location, 1, glm::value_ptr(value));
+	if (mShadow.update(location, &value, sizeof(value))) {
+		glProgramUniform4fv(mId, location, 1, glm::value_ptr(value));
+	}
 }
 
 inline void Program::setUniform(GLint location, const glm::mat3 &value) const
 {
-	glProgramUniformMatrix3fv(mId, location, 1, GL_FALSE, glm::value_ptr(value));
+	if (mShadow.update(location, &value, sizeof(value))) {
+		glProgramUniformMatrix3fv(mId, location, 1, GL_FALSE, glm::value_ptr(value));
+	}
 }
 
 inline void Program::setUniform(GLint location, const glm::mat4 &value) const
 {
-	glProgramUniformMatrix4fv(mId, location, 1, GL_FALSE, glm::value_ptr(value));
+	if (mShadow.update(location, &value, sizeof(value))) {
+		glProgramUniformMatrix4fv(mId, location, 1, GL_FALSE, glm::value_ptr(value));
+	}
+}
+
+inline bool Program::isShadowed() const noexcept
+{
+	return mShadow.isEnabled();
+}
+
+inline void Program::setShadowed(bool shadowed)
+{
+	mShadow.setEnabled(shadowed);
+}
+
+inline const UniformShadow::Stats &Program::getUniformStats() const noexcept
+{
+	return mShadow.getStats();
+}
+
+inline void Program::resetUniformStats() noexcept
+{
+	mShadow.resetStats();
 }
 
 } // namespace ogl
@@ -0,0 +1,253 @@
+#ifndef GTL_OGL_PROGRAMCACHE_H
+#define GTL_OGL_PROGRAMCACHE_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "gtl/ogl/hasher.h"
+#include "gtl/ogl/mappedfile.h"
+#include "gtl/ogl/program.h"
+#include "gtl/ogl/shader.h"
+#include "gtl/ogl/shaderexception.h"
+
+
+namespace gtl {
+namespace ogl {
+
+// Stores linked programs on disk with glGetProgramBinary and restores them
+// with glProgramBinary. Entries are keyed by the sources, the defines and the
+// driver (vendor, renderer and version). Entries which the driver rejects
+// are deleted and the program is linked from source again. The cache has to
+// be created while a context is current.
+class ProgramCache final
+{
+public:
+	struct Stage {
+		Shader::Type type;
+		std::string source;
+		std::string defines;
+	};
+
+	struct Stats {
+		std::uint64_t hits;
+		std::uint64_t misses;
+		std::uint64_t rejected;
+		std::chrono::nanoseconds loadTime;
+		std::chrono::nanoseconds linkTime;
+	};
+
+	explicit ProgramCache(const std::string &directory);
+
+	Program get(const std::vector<Stage> &stages, bool reflect = false);
+	std::uint64_t getKey(const std::vector<Stage> &stages) const;
+	std::string getPath(std::uint64_t key) const;
+
+	const Stats &getStats() const noexcept;
+	void resetStats() noexcept;
+
+private:
+	static const std::uint32_t FORMAT_VERSION = 1;
+
+	struct Header {
+		char magic[4];
+		std::uint32_t version;
+		std::uint64_t key;
+		std::uint32_t binaryFormat;
+		std::uint32_t length;
+	};
+
+	ProgramCache(const ProgramCache &) = delete;
+	ProgramCache &operator=(const ProgramCache &) = delete;
+
+	static std::string getString(GLenum name);
+	bool load(Program &program, std::uint64_t key);
+	void link(Program &program, const std::vector<Stage> &stages);
+	void store(const Program &program, std::uint64_t key);
+
+	std::string mDirectory;
+	std::string mDriver;
+	Stats mStats;
+
+};
+
+
+inline ProgramCache::ProgramCache(const std::string &directory) :
+	mDirectory(directory),
+	mStats()
+{
+	mDriver = getString(GL_VENDOR) + '\n' + getString(GL_RENDERER) + '\n' + getString(GL_VERSION);
+}
+
+inline Program ProgramCache::get(const std::vector<Stage> &stages, bool reflect)
+{
+	std::uint64_t key = getKey(stages);
+
+	auto start = std::chrono::steady_clock::now();
+	Program program(true);
+	if (load(program, key)) {
+		++mStats.hits;
+		mStats.loadTime += std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - start);
+	} else {
+		start = std::chrono::steady_clock::now();
+		link(program, stages);
+		store(program, key);
+		++mStats.misses;
+		mStats.linkTime += std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - start);
+	}
+	if (reflect) {
+		program.reflect();
+	}
+	return program;
+}
+
+inline std::uint64_t ProgramCache::getKey(const std::vector<Stage> &stages) const
+{
+	Hasher hasher;
+	hasher.addValue(static_cast<std::uint32_t>(FORMAT_VERSION));
+	hasher.add(mDriver);
+	for (const Stage &stage : stages) {
+		hasher.addValue(static_cast<GLenum>(stage.type));
+		hasher.add(stage.source);
+		hasher.add(stage.defines);
+	}
+	return hasher.getValue();
+}
+
+inline std::string ProgramCache::getPath(std::uint64_t key) const
+{
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+	return mDirectory + '/' + name;
+}
+
+inline const ProgramCache::Stats &ProgramCache::getStats() const noexcept
+{
+	return mStats;
+}
+
+inline void ProgramCache::resetStats() noexcept
+{
+	mStats = Stats();
+}
+
+inline std::string ProgramCache::getString(GLenum name)
+{
+	const GLubyte *str = glGetString(name);
+	return (str == nullptr) ? std::string() : std::string(reinterpret_cast<const char*>(str));
+}
+
+inline bool ProgramCache::load(Program &program, std::uint64_t key)
+{
+	std::string path = getPath(key);
+	MappedFile file(path);
+	if (!file) {
+		return false;
+	}
+
+	Header header;
+	const char *data = static_cast<const char*>(file.getData());
+	if (file.getSize() < sizeof(header)) {
+		return false;
+	}
+	std::memcpy(&header, data, sizeof(header));
+	if (std::memcmp(header.magic, "GTLP", 4) != 0 || header.version != FORMAT_VERSION
+			|| header.key != key || header.length != file.getSize() - sizeof(header)) {
+		return false;
+	}
+
+	try {
+		program.setBinary(header.binaryFormat, data + sizeof(header), header.length);
+		return true;
+	} catch (const ShaderException &) {
+		// Most likely the driver was updated without changing its version.
+		file.close();
+		std::remove(path.c_str());
+		++mStats.rejected;
+		return false;
+	}
+}
+
+inline void ProgramCache::link(Program &program, const std::vector<Stage> &stages)
+{
+	program.setParameter(GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+	std::vector<Shader> shaders;
+	shaders.reserve(stages.size());
+	for (const Stage &stage : stages) {
+		// The defines have to follow the #version directive.
+		std::size_t split = 0;
+		std::size_t version = stage.source.find("#version");
+		if (version != std::string::npos) {
+			split = stage.source.find('\n', version);
+			split = (split == std::string::npos) ? stage.source.size() : split + 1;
+		}
+		const GLchar *strings[] = {
+			stage.source.data(),
+			stage.defines.data(),
+			stage.source.data() + split
+		};
+		GLint lengths[] = {
+			static_cast<GLint>(split),
+			static_cast<GLint>(stage.defines.size()),
+			static_cast<GLint>(stage.source.size() - split)
+		};
+
+		shaders.emplace_back(stage.type);
+		shaders.back().setSource(3, strings, lengths);
+		shaders.back().compile();
+		program.attachShader(shaders.back());
+	}
+	program.link();
+	for (const Shader &shader : shaders) {
+		program.detachShader(shader);
+	}
+}
+
+inline void ProgramCache::store(const Program &program, std::uint64_t key)
+{
+	GLenum binaryFormat = 0;
+	std::vector<char> binary = program.getBinary(binaryFormat);
+	if (binary.empty()) {
+		return;
+	}
+
+	Header header;
+	std::memcpy(header.magic, "GTLP", 4);
+	header.version = FORMAT_VERSION;
+	header.key = key;
+	header.binaryFormat = binaryFormat;
+	header.length = static_cast<std::uint32_t>(binary.size());
+
+	// Write to a temporary file first, so that readers never see half a file.
+	std::string path = getPath(key);
+	std::string temporary = path + ".tmp";
+	{
+		std::ofstream out(temporary.c_str(), std::ios::binary | std::ios::trunc);
+		if (!out) {
+			return;
+		}
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(binary.data(), binary.size());
+		if (!out) {
+			out.close();
+			std::remove(temporary.c_str());
+			return;
+		}
+	}
+	std::remove(path.c_str());
+	std::rename(temporary.c_str(), path.c_str());
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_PROGRAMCACHE_H
@@ -0,0 +1,234 @@
+#ifndef GTL_OGL_PROGRAMCOMPILER_H
+#define GTL_OGL_PROGRAMCOMPILER_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "gtl/ogl/program.h"
+#include "gtl/ogl/shader.h"
+
+
+namespace gtl {
+namespace ogl {
+
+// Compiles and links many programs at once without waiting for each of them.
+// With KHR_parallel_shader_compile the driver compiles on its own threads and
+// update() only polls GL_COMPLETION_STATUS_KHR. Without the extension, the
+// status queries in update() block like Shader::compile() does. Info logs are
+// only fetched for programs which failed.
+class ProgramCompiler final
+{
+public:
+	struct Stage {
+		Shader::Type type;
+		std::string source;
+	};
+
+	enum class State {
+		COMPILING,
+		LINKING,
+		READY,
+		FAILED
+	};
+
+	typedef std::size_t Ticket;
+
+	explicit ProgramCompiler(const Program *fallback = nullptr);
+
+	Ticket submit(const std::vector<Stage> &stages, bool reflect = false);
+	void update();
+	void release(Ticket ticket) noexcept;
+
+	State getState(Ticket ticket) const noexcept;
+	bool isReady(Ticket ticket) const noexcept;
+	const Program &get(Ticket ticket) const noexcept;
+	Program take(Ticket ticket);
+	const std::string &getInfoLog(Ticket ticket) const noexcept;
+	std::size_t getPendingCount() const noexcept;
+
+private:
+	struct Entry {
+		Program program;
+		std::vector<Shader> shaders;
+		std::string infoLog;
+		State state;
+		bool reflect;
+		bool used;
+	};
+
+	ProgramCompiler(const ProgramCompiler &) = delete;
+	ProgramCompiler &operator=(const ProgramCompiler &) = delete;
+
+	void updateCompiling(Entry &entry);
+	void updateLinking(Entry &entry);
+
+	std::vector<Entry> mEntries;
+	std::vector<Ticket> mUnusedTickets;
+	const Program *mFallback;
+	Program mEmpty;
+	std::size_t mPendingCount;
+
+};
+
+
+inline ProgramCompiler::ProgramCompiler(const Program *fallback) :
+	mFallback(fallback),
+	mPendingCount(0)
+{
+	if (GLEW_KHR_parallel_shader_compile) {
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+	}
+}
+
+inline ProgramCompiler::Ticket ProgramCompiler::submit(const std::vector<Stage> &stages, bool reflect)
+{
+	Ticket ticket;
+	if (mUnusedTickets.empty()) {
+		ticket = mEntries.size();
+		mEntries.emplace_back();
+	} else {
+		ticket = mUnusedTickets.back();
+		mUnusedTickets.pop_back();
+	}
+
+	Entry &entry = mEntries[ticket];
+	entry.program.reset();
+	entry.shaders.clear();
+	entry.infoLog.clear();
+	entry.state = State::COMPILING;
+	entry.reflect = reflect;
+	entry.used = true;
+	++mPendingCount;
+
+	entry.shaders.reserve(stages.size());
+	for (const Stage &stage : stages) {
+		entry.shaders.emplace_back(stage.type, stage.source);
+		entry.shaders.back().startCompile();
+	}
+	return ticket;
+}
+
+inline void ProgramCompiler::update()
+{
+	for (Entry &entry : mEntries) {
+		if (entry.used && entry.state == State::COMPILING) {
+			updateCompiling(entry);
+		}
+		if (entry.used && entry.state == State::LINKING) {
+			updateLinking(entry);
+		}
+	}
+}
+
+inline void ProgramCompiler::release(Ticket ticket) noexcept
+{
+	// Releasing twice would count the build and the ticket twice.
+	if (ticket >= mEntries.size() || !mEntries[ticket].used) {
+		return;
+	}
+	Entry &entry = mEntries[ticket];
+	if (entry.state == State::COMPILING || entry.state == State::LINKING) {
+		--mPendingCount;
+	}
+	entry.program.reset();
+	entry.shaders.clear();
+	entry.infoLog.clear();
+	// A released ticket reads as failed until submit() hands it out again.
+	entry.state = State::FAILED;
+	entry.used = false;
+	mUnusedTickets.push_back(ticket);
+}
+
+inline ProgramCompiler::State ProgramCompiler::getState(Ticket ticket) const noexcept
+{
+	return mEntries[ticket].state;
+}
+
+inline bool ProgramCompiler::isReady(Ticket ticket) const noexcept
+{
+	return (mEntries[ticket].state == State::READY);
+}
+
+inline const Program &ProgramCompiler::get(Ticket ticket) const noexcept
+{
+	if (isReady(ticket)) {
+		return mEntries[ticket].program;
+	}
+	return (mFallback != nullptr) ? *mFallback : mEmpty;
+}
+
+inline Program ProgramCompiler::take(Ticket ticket)
+{
+	Program program;
+	if (isReady(ticket)) {
+		program = std::move(mEntries[ticket].program);
+	}
+	release(ticket);
+	return program;
+}
+
+inline const std::string &ProgramCompiler::getInfoLog(Ticket ticket) const noexcept
+{
+	return mEntries[ticket].infoLog;
+}
+
+inline std::size_t ProgramCompiler::getPendingCount() const noexcept
+{
+	return mPendingCount;
+}
+
+inline void ProgramCompiler::updateCompiling(Entry &entry)
+{
+	for (const Shader &shader : entry.shaders) {
+		if (!shader.isCompileCompleted()) {
+			return;
+		}
+	}
+	for (const Shader &shader : entry.shaders) {
+		if (!shader.getCompileStatus()) {
+			entry.infoLog = shader.getInfoLog();
+			entry.shaders.clear();
+			entry.state = State::FAILED;
+			--mPendingCount;
+			return;
+		}
+	}
+
+	entry.program.create();
+	for (const Shader &shader : entry.shaders) {
+		entry.program.attachShader(shader);
+	}
+	entry.program.startLink();
+	entry.state = State::LINKING;
+}
+
+inline void ProgramCompiler::updateLinking(Entry &entry)
+{
+	if (!entry.program.isLinkCompleted()) {
+		return;
+	}
+	for (const Shader &shader : entry.shaders) {
+		entry.program.detachShader(shader);
+	}
+	entry.shaders.clear();
+	--mPendingCount;
+
+	if (!entry.program.getLinkStatus()) {
+		entry.infoLog = entry.program.getInfoLog();
+		entry.program.reset();
+		entry.state = State::FAILED;
+		return;
+	}
+	if (entry.reflect) {
+		entry.program.reflect();
+	}
+	entry.state = State::READY;
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_PROGRAMCOMPILER_H
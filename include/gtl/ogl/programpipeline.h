@@ -0,0 +1,185 @@
+#ifndef GTL_OGL_PROGRAMPIPELINE_H
+#define GTL_OGL_PROGRAMPIPELINE_H
+
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "gtl/ogl/program.h"
+#include "gtl/ogl/shader.h"
+#include "gtl/ogl/shaderexception.h"
+
+
+namespace gtl {
+namespace ogl {
+
+class ProgramPipeline final
+{
+public:
+	ProgramPipeline(bool create);
+	explicit ProgramPipeline(GLuint pipelineName = 0) noexcept;
+	~ProgramPipeline() noexcept;
+
+	ProgramPipeline(ProgramPipeline &&other) noexcept;
+	ProgramPipeline &operator = (ProgramPipeline &&other) noexcept;
+	explicit operator bool () const noexcept;
+
+	void create();
+	void reset(GLuint pipelineName = 0) noexcept;
+	GLuint release() noexcept;
+
+	GLuint get() const noexcept;
+	void bind() const;
+	void unbind() const;
+
+	void useProgramStages(GLbitfield stages, const Program &program);
+	void useProgramStages(Shader::Type type, const Program &program);
+	void setActiveProgram(const Program &program);
+	void validate();
+
+	std::string getInfoLog() const;
+
+	static GLbitfield toStageBit(Shader::Type type) noexcept;
+
+private:
+	ProgramPipeline(const ProgramPipeline &) = delete;
+	ProgramPipeline &operator=(const ProgramPipeline &) = delete;
+
+	GLuint mId;
+
+};
+
+
+inline ProgramPipeline::ProgramPipeline(bool create) :
+	ProgramPipeline()
+{
+	if (create) {
+		this->create();
+	}
+}
+
+inline ProgramPipeline::ProgramPipeline(GLuint pipelineName) noexcept :
+	mId(pipelineName)
+{
+}
+
+inline ProgramPipeline::~ProgramPipeline() noexcept
+{
+	reset();
+}
+
+inline ProgramPipeline::ProgramPipeline(ProgramPipeline &&other) noexcept :
+	mId(other.release())
+{
+}
+
+inline ProgramPipeline &ProgramPipeline::operator =(ProgramPipeline &&other) noexcept
+{
+	reset(other.release());
+	return *this;
+}
+
+inline ProgramPipeline::operator bool() const noexcept
+{
+	return (mId != 0);
+}
+
+inline void ProgramPipeline::create()
+{
+	reset();
+	glCreateProgramPipelines(1, &mId);
+}
+
+inline void ProgramPipeline::reset(GLuint pipelineName) noexcept
+{
+	if (mId != 0) {
+		glDeleteProgramPipelines(1, &mId);
+	}
+	mId = pipelineName;
+}
+
+inline GLuint ProgramPipeline::release() noexcept
+{
+	GLuint tmp = mId;
+	mId = 0;
+	return tmp;
+}
+
+inline GLuint ProgramPipeline::get() const noexcept
+{
+	return mId;
+}
+
+inline void ProgramPipeline::bind() const
+{
+	// The pipeline is only used while no program is current.
+	glBindProgramPipeline(mId);
+}
+
+inline void ProgramPipeline::unbind() const
+{
+	glBindProgramPipeline(0);
+}
+
+inline void ProgramPipeline::useProgramStages(GLbitfield stages, const Program &program)
+{
+	glUseProgramStages(mId, stages, program.get());
+}
+
+inline void ProgramPipeline::useProgramStages(Shader::Type type, const Program &program)
+{
+	useProgramStages(toStageBit(type), program);
+}
+
+inline void ProgramPipeline::setActiveProgram(const Program &program)
+{
+	glActiveShaderProgram(mId, program.get());
+}
+
+inline void ProgramPipeline::validate()
+{
+	GLint status;
+	glValidateProgramPipeline(mId);
+	glGetProgramPipelineiv(mId, GL_VALIDATE_STATUS, &status);
+	if (status != GL_TRUE) {
+		throw ShaderException("Program pipeline is invalid");
+	}
+}
+
+inline std::string ProgramPipeline::getInfoLog() const
+{
+	GLint lenght;
+	glGetProgramPipelineiv(mId, GL_INFO_LOG_LENGTH, &lenght);
+	if (lenght != 0) {
+		std::vector<GLchar> buffer(lenght);
+		glGetProgramPipelineInfoLog(mId, lenght, &lenght, buffer.data());
+		return std::string(buffer.data(), lenght);
+	} else {
+		return std::string();
+	}
+}
+
+inline GLbitfield ProgramPipeline::toStageBit(Shader::Type type) noexcept
+{
+	switch (type) {
+	case Shader::Type::VERTEX:
+		return GL_VERTEX_SHADER_BIT;
+	case Shader::Type::TESS_CONTROL:
+		return GL_TESS_CONTROL_SHADER_BIT;
+	case Shader::Type::TESS_EVALUATION:
+		return GL_TESS_EVALUATION_SHADER_BIT;
+	case Shader::Type::GEOMETRY:
+		return GL_GEOMETRY_SHADER_BIT;
+	case Shader::Type::FRAGMENT:
+		return GL_FRAGMENT_SHADER_BIT;
+	case Shader::Type::COMPUTE:
+		return GL_COMPUTE_SHADER_BIT;
+	}
+	return 0;
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_PROGRAMPIPELINE_H
@@ -0,0 +1,148 @@
+#ifndef GTL_OGL_PROGRAMPIPELINECACHE_H
+#define GTL_OGL_PROGRAMPIPELINECACHE_H
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "gtl/ogl/program.h"
+#include "gtl/ogl/programpipeline.h"
+#include "gtl/ogl/shader.h"
+
+
+namespace gtl {
+namespace ogl {
+
+// Creates one pipeline per combination of separable programs, so that N
+// vertex and M fragment programs only need N + M programs instead of N * M
+// linked ones. Pipelines are keyed by program names, so call erase() before
+// a program is deleted.
+class ProgramPipelineCache final
+{
+public:
+	typedef std::pair<Shader::Type, const Program*> Stage;
+
+	struct Stats {
+		std::uint64_t hits;
+		std::uint64_t misses;
+	};
+
+	ProgramPipelineCache() noexcept;
+
+	const ProgramPipeline &get(const Program &vertex, const Program &fragment);
+	const ProgramPipeline &get(const std::vector<Stage> &stages);
+	void erase(const Program &program) noexcept;
+	void clear() noexcept;
+
+	std::size_t getSize() const noexcept;
+	const Stats &getStats() const noexcept;
+
+private:
+	static const std::size_t STAGE_COUNT = 6;
+	typedef std::array<GLuint, STAGE_COUNT> Key;
+
+	ProgramPipelineCache(const ProgramPipelineCache &) = delete;
+	ProgramPipelineCache &operator=(const ProgramPipelineCache &) = delete;
+
+	static std::size_t getStageIndex(Shader::Type type) noexcept;
+
+	std::map<Key, ProgramPipeline> mPipelines;
+	Stats mStats;
+
+};
+
+
+inline ProgramPipelineCache::ProgramPipelineCache() noexcept :
+	mStats()
+{
+}
+
+inline const ProgramPipeline &ProgramPipelineCache::get(const Program &vertex, const Program &fragment)
+{
+	std::vector<Stage> stages;
+	stages.reserve(2);
+	stages.push_back(Stage(Shader::Type::VERTEX, &vertex));
+	stages.push_back(Stage(Shader::Type::FRAGMENT, &fragment));
+	return get(stages);
+}
+
+inline const ProgramPipeline &ProgramPipelineCache::get(const std::vector<Stage> &stages)
+{
+	Key key;
+	key.fill(0);
+	for (const Stage &stage : stages) {
+		key[getStageIndex(stage.first)] = stage.second->get();
+	}
+
+	auto it = mPipelines.find(key);
+	if (it != mPipelines.end()) {
+		++mStats.hits;
+		return it->second;
+	}
+
+	++mStats.misses;
+	ProgramPipeline pipeline(true);
+	for (const Stage &stage : stages) {
+		pipeline.useProgramStages(stage.first, *stage.second);
+	}
+	return mPipelines.insert(std::make_pair(key, std::move(pipeline))).first->second;
+}
+
+inline void ProgramPipelineCache::erase(const Program &program) noexcept
+{
+	auto it = mPipelines.begin();
+	while (it != mPipelines.end()) {
+		bool used = false;
+		for (GLuint name : it->first) {
+			used = used || (name == program.get());
+		}
+		if (used) {
+			it = mPipelines.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+inline void ProgramPipelineCache::clear() noexcept
+{
+	mPipelines.clear();
+}
+
+inline std::size_t ProgramPipelineCache::getSize() const noexcept
+{
+	return mPipelines.size();
+}
+
+inline const ProgramPipelineCache::Stats &ProgramPipelineCache::getStats() const noexcept
+{
+	return mStats;
+}
+
+inline std::size_t ProgramPipelineCache::getStageIndex(Shader::Type type) noexcept
+{
+	switch (type) {
+	case Shader::Type::VERTEX:
+		return 0;
+	case Shader::Type::TESS_CONTROL:
+		return 1;
+	case Shader::Type::TESS_EVALUATION:
+		return 2;
+	case Shader::Type::GEOMETRY:
+		return 3;
+	case Shader::Type::FRAGMENT:
+		return 4;
+	case Shader::Type::COMPUTE:
+		return 5;
+	}
+	return 0;
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_PROGRAMPIPELINECACHE_H
@@ -0,0 +1,320 @@
+#ifndef GTL_OGL_PROGRAMREFLECTION_H
+#define GTL_OGL_PROGRAMREFLECTION_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "gtl/ogl/name.h"
+
+
+namespace gtl {
+namespace ogl {
+
+// Active resources of a linked program, collected once through the program
+// interface query API. Lookups by Name use small open-addressing tables and
+// neither allocate nor call into OpenGL.
+class ProgramReflection final
+{
+public:
+	struct Uniform {
+		std::uint32_t name;
+		GLint location;
+		GLenum type;
+		GLint arraySize;
+		GLint blockIndex;
+		GLint offset;
+	};
+
+	struct Attribute {
+		std::uint32_t name;
+		GLint location;
+		GLenum type;
+		GLint arraySize;
+	};
+
+	struct Block {
+		std::uint32_t name;
+		GLuint index;
+		GLint binding;
+		GLint dataSize;
+	};
+
+	ProgramReflection() = default;
+	explicit ProgramReflection(GLuint programName);
+
+	void reflect(GLuint programName);
+	void clear() noexcept;
+	bool empty() const noexcept;
+
+	const Uniform *findUniform(const Name &name) const noexcept;
+	const Attribute *findAttribute(const Name &name) const noexcept;
+	const Block *findUniformBlock(const Name &name) const noexcept;
+	const Block *findStorageBlock(const Name &name) const noexcept;
+
+	GLint getUniformLocation(const Name &name) const noexcept;
+	GLint getAttribLocation(const Name &name) const noexcept;
+
+	const std::vector<Uniform> &getUniforms() const noexcept;
+	const std::vector<Attribute> &getAttributes() const noexcept;
+	const std::vector<Block> &getUniformBlocks() const noexcept;
+	const std::vector<Block> &getStorageBlocks() const noexcept;
+
+private:
+	class Table final
+	{
+	public:
+		void build(const std::vector<std::uint32_t> &ids, const std::vector<std::uint32_t> &aliases);
+		void clear() noexcept;
+		std::int32_t find(std::uint32_t id) const noexcept;
+
+	private:
+		struct Entry {
+			std::uint32_t id;
+			std::int32_t index;
+		};
+
+		void insert(std::uint32_t id, std::int32_t index) noexcept;
+
+		std::vector<Entry> mEntries;
+		std::uint32_t mMask;
+	};
+
+	static std::string getResourceName(GLuint programName, GLenum programInterface, GLuint index, std::vector<GLchar> &buffer);
+	static std::uint32_t getBaseName(const std::string &name);
+	void reflectBlocks(GLuint programName, GLenum programInterface, std::vector<Block> &blocks, Table &table, std::vector<GLchar> &buffer);
+
+	std::vector<Uniform> mUniforms;
+	std::vector<Attribute> mAttributes;
+	std::vector<Block> mUniformBlocks;
+	std::vector<Block> mStorageBlocks;
+	Table mUniformTable;
+	Table mAttributeTable;
+	Table mUniformBlockTable;
+	Table mStorageBlockTable;
+
+};
+
+
+inline ProgramReflection::ProgramReflection(GLuint programName)
+{
+	reflect(programName);
+}
+
+inline void ProgramReflection::reflect(GLuint programName)
+{
+	clear();
+
+	std::vector<GLchar> buffer;
+	std::vector<std::uint32_t> ids;
+	std::vector<std::uint32_t> aliases;
+	GLint count;
+
+	glGetProgramInterfaceiv(programName, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+	mUniforms.reserve(count);
+	for (GLint i = 0; i < count; ++i) {
+		const GLenum props[] = { GL_TYPE, GL_ARRAY_SIZE, GL_LOCATION, GL_BLOCK_INDEX, GL_OFFSET };
+		GLint values[5];
+		glGetProgramResourceiv(programName, GL_UNIFORM, i, 5, props, 5, nullptr, values);
+		std::string name = getResourceName(programName, GL_UNIFORM, i, buffer);
+		Uniform uniform = { Name(name).getId(), values[2], static_cast<GLenum>(values[0]), values[1], values[3], values[4] };
+		mUniforms.push_back(uniform);
+		ids.push_back(uniform.name);
+		aliases.push_back(getBaseName(name));
+	}
+	mUniformTable.build(ids, aliases);
+
+	ids.clear();
+	aliases.clear();
+	glGetProgramInterfaceiv(programName, GL_PROGRAM_INPUT, GL_ACTIVE_RESOURCES, &count);
+	mAttributes.reserve(count);
+	for (GLint i = 0; i < count; ++i) {
+		const GLenum props[] = { GL_TYPE, GL_ARRAY_SIZE, GL_LOCATION };
+		GLint values[3];
+		glGetProgramResourceiv(programName, GL_PROGRAM_INPUT, i, 3, props, 3, nullptr, values);
+		std::string name = getResourceName(programName, GL_PROGRAM_INPUT, i, buffer);
+		Attribute attribute = { Name(name).getId(), values[2], static_cast<GLenum>(values[0]), values[1] };
+		mAttributes.push_back(attribute);
+		ids.push_back(attribute.name);
+		aliases.push_back(getBaseName(name));
+	}
+	mAttributeTable.build(ids, aliases);
+
+	reflectBlocks(programName, GL_UNIFORM_BLOCK, mUniformBlocks, mUniformBlockTable, buffer);
+	reflectBlocks(programName, GL_SHADER_STORAGE_BLOCK, mStorageBlocks, mStorageBlockTable, buffer);
+}
+
+inline void ProgramReflection::clear() noexcept
+{
+	mUniforms.clear();
+	mAttributes.clear();
+	mUniformBlocks.clear();
+	mStorageBlocks.clear();
+	mUniformTable.clear();
+	mAttributeTable.clear();
+	mUniformBlockTable.clear();
+	mStorageBlockTable.clear();
+}
+
+inline bool ProgramReflection::empty() const noexcept
+{
+	return mUniforms.empty() && mAttributes.empty() && mUniformBlocks.empty() && mStorageBlocks.empty();
+}
+
+inline const ProgramReflection::Uniform *ProgramReflection::findUniform(const Name &name) const noexcept
+{
+	std::int32_t index = mUniformTable.find(name.getId());
+	return (index < 0) ? nullptr : &mUniforms[index];
+}
+
+inline const ProgramReflection::Attribute *ProgramReflection::findAttribute(const Name &name) const noexcept
+{
+	std::int32_t index = mAttributeTable.find(name.getId());
+	return (index < 0) ? nullptr : &mAttributes[index];
+}
+
+inline const ProgramReflection::Block *ProgramReflection::findUniformBlock(const Name &name) const noexcept
+{
+	std::int32_t index = mUniformBlockTable.find(name.getId());
+	return (index < 0) ? nullptr : &mUniformBlocks[index];
+}
+
+inline const ProgramReflection::Block *ProgramReflection::findStorageBlock(const Name &name) const noexcept
+{
+	std::int32_t index = mStorageBlockTable.find(name.getId());
+	return (index < 0) ? nullptr : &mStorageBlocks[index];
+}
+
+inline GLint ProgramReflection::getUniformLocation(const Name &name) const noexcept
+{
+	const Uniform *uniform = findUniform(name);
+	return (uniform == nullptr) ? -1 : uniform->location;
+}
+
+inline GLint ProgramReflection::getAttribLocation(const Name &name) const noexcept
+{
+	const Attribute *attribute = findAttribute(name);
+	return (attribute == nullptr) ? -1 : attribute->location;
+}
+
+inline const std::vector<ProgramReflection::Uniform> &ProgramReflection::getUniforms() const noexcept
+{
+	return mUniforms;
+}
+
+inline const std::vector<ProgramReflection::Attribute> &ProgramReflection::getAttributes() const noexcept
+{
+	return mAttributes;
+}
+
+inline const std::vector<ProgramReflection::Block> &ProgramReflection::getUniformBlocks() const noexcept
+{
+	return mUniformBlocks;
+}
+
+inline const std::vector<ProgramReflection::Block> &ProgramReflection::getStorageBlocks() const noexcept
+{
+	return mStorageBlocks;
+}
+
+inline std::string ProgramReflection::getResourceName(GLuint programName, GLenum programInterface, GLuint index, std::vector<GLchar> &buffer)
+{
+	const GLenum prop = GL_NAME_LENGTH;
+	GLint length;
+	glGetProgramResourceiv(programName, programInterface, index, 1, &prop, 1, nullptr, &length);
+	if (length <= 0) {
+		return std::string();
+	}
+	buffer.resize(length);
+	glGetProgramResourceName(programName, programInterface, index, length, &length, buffer.data());
+	return std::string(buffer.data(), length);
+}
+
+inline std::uint32_t ProgramReflection::getBaseName(const std::string &name)
+{
+	// Arrays are reported as "name[0]", but should be found as "name", too.
+	std::size_t length = name.size();
+	if (length > 3 && name.compare(length - 3, 3, "[0]") == 0) {
+		return Name(name.substr(0, length - 3)).getId();
+	}
+	return Name(name).getId();
+}
+
+inline void ProgramReflection::reflectBlocks(GLuint programName, GLenum programInterface, std::vector<Block> &blocks, Table &table, std::vector<GLchar> &buffer)
+{
+	std::vector<std::uint32_t> ids;
+	std::vector<std::uint32_t> aliases;
+	GLint count;
+
+	glGetProgramInterfaceiv(programName, programInterface, GL_ACTIVE_RESOURCES, &count);
+	blocks.reserve(count);
+	for (GLint i = 0; i < count; ++i) {
+		const GLenum props[] = { GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE };
+		GLint values[2];
+		glGetProgramResourceiv(programName, programInterface, i, 2, props, 2, nullptr, values);
+		std::string name = getResourceName(programName, programInterface, i, buffer);
+		Block block = { Name(name).getId(), static_cast<GLuint>(i), values[0], values[1] };
+		blocks.push_back(block);
+		ids.push_back(block.name);
+		aliases.push_back(getBaseName(name));
+	}
+	table.build(ids, aliases);
+}
+
+inline void ProgramReflection::Table::build(const std::vector<std::uint32_t> &ids, const std::vector<std::uint32_t> &aliases)
+{
+	std::uint32_t capacity = 4;
+	while (capacity < ids.size() * 4) {
+		capacity *= 2;
+	}
+	Entry empty = { 0xFFFFFFFFu, -1 };
+	mEntries.assign(capacity, empty);
+	mMask = capacity - 1;
+
+	for (std::size_t i = 0; i < ids.size(); ++i) {
+		insert(ids[i], static_cast<std::int32_t>(i));
+	}
+	for (std::size_t i = 0; i < aliases.size(); ++i) {
+		if (find(aliases[i]) < 0) {
+			insert(aliases[i], static_cast<std::int32_t>(i));
+		}
+	}
+}
+
+inline void ProgramReflection::Table::clear() noexcept
+{
+	mEntries.clear();
+}
+
+inline std::int32_t ProgramReflection::Table::find(std::uint32_t id) const noexcept
+{
+	if (mEntries.empty()) {
+		return -1;
+	}
+	for (std::uint32_t slot = (id * 2654435761u) & mMask; ; slot = (slot + 1) & mMask) {
+		const Entry &entry = mEntries[slot];
+		if (entry.id == id) {
+			return entry.index;
+		}
+		if (entry.index < 0) {
+			return -1;
+		}
+	}
+}
+
+inline void ProgramReflection::Table::insert(std::uint32_t id, std::int32_t index) noexcept
+{
+	std::uint32_t slot = (id * 2654435761u) & mMask;
+	while (mEntries[slot].index >= 0 && mEntries[slot].id != id) {
+		slot = (slot + 1) & mMask;
+	}
+	mEntries[slot].id = id;
+	mEntries[slot].index = index;
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_PROGRAMREFLECTION_H
@@ -0,0 +1,426 @@
+#ifndef GTL_OGL_RANGEALLOCATOR_H
+#define GTL_OGL_RANGEALLOCATOR_H
+
+#include <cstdint>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+namespace gtl {
+namespace ogl {
+
+// Two-level segregated fit (TLSF) allocator for ranges of an address space
+// such as a buffer object. Allocation and free are O(1). Offsets and sizes
+// are multiples of the granularity, which has to be a power of two.
+class RangeAllocator final
+{
+public:
+	typedef std::uint32_t Handle;
+	static const Handle INVALID = 0xFFFFFFFFu;
+
+	struct Stats {
+		std::uint64_t capacity;
+		std::uint64_t usedSize;
+		std::uint64_t freeSize;
+		std::uint64_t largestFreeBlock;
+		std::uint32_t allocationCount;
+		std::uint32_t freeBlockCount;
+
+		double getOccupancy() const noexcept;
+		double getFragmentation() const noexcept;
+	};
+
+	RangeAllocator() noexcept;
+	explicit RangeAllocator(std::uint64_t capacity, std::uint64_t granularity = 256);
+
+	void reset(std::uint64_t capacity, std::uint64_t granularity = 256);
+
+	Handle allocate(std::uint64_t size, std::uint64_t alignment = 0);
+	void free(Handle handle) noexcept;
+
+	std::uint64_t getOffset(Handle handle) const noexcept;
+	std::uint64_t getSize(Handle handle) const noexcept;
+	std::uint64_t getCapacity() const noexcept;
+	// Largest size which allocate() can return with the given alignment,
+	// which happens when nothing is allocated. Because of the size classes
+	// this is up to 1/32 less than the capacity.
+	std::uint64_t getMaxAllocation(std::uint64_t alignment = 0) const noexcept;
+	std::uint64_t getGranularity() const noexcept;
+	Stats getStats() const noexcept;
+
+private:
+	static const unsigned SL_LOG2 = 5;
+	static const unsigned SL_COUNT = 1u << SL_LOG2;
+	static const unsigned FL_COUNT = 64 - SL_LOG2;
+
+	struct Block {
+		std::uint64_t offset;
+		std::uint64_t size;
+		Handle prevPhys;
+		Handle nextPhys;
+		Handle prevFree;
+		Handle nextFree;
+		bool free;
+	};
+
+	static unsigned findLastSet(std::uint64_t value) noexcept;
+	static unsigned findFirstSet(std::uint64_t value) noexcept;
+	static void mapping(std::uint64_t units, unsigned &fl, unsigned &sl) noexcept;
+
+	Handle newBlock(std::uint64_t offset, std::uint64_t size, Handle prevPhys, Handle nextPhys);
+	void deleteBlock(Handle handle) noexcept;
+	void insertFree(Handle handle) noexcept;
+	void removeFree(Handle handle) noexcept;
+	Handle findFree(std::uint64_t units) const noexcept;
+
+	std::vector<Block> mBlocks;
+	std::vector<Handle> mUnusedBlocks;
+	std::uint64_t mFlBitmap;
+	std::uint32_t mSlBitmaps[FL_COUNT];
+	Handle mHeads[FL_COUNT][SL_COUNT];
+	std::uint64_t mCapacity;
+	unsigned mGranularityLog2;
+	std::uint64_t mUsedSize;
+	std::uint32_t mAllocationCount;
+	std::uint32_t mFreeBlockCount;
+
+};
+
+
+inline double RangeAllocator::Stats::getOccupancy() const noexcept
+{
+	return (capacity == 0) ? 0.0 : static_cast<double>(usedSize) / capacity;
+}
+
+inline double RangeAllocator::Stats::getFragmentation() const noexcept
+{
+	return (freeSize == 0) ? 0.0 : 1.0 - static_cast<double>(largestFreeBlock) / freeSize;
+}
+
+inline RangeAllocator::RangeAllocator() noexcept :
+	mFlBitmap(0),
+	mSlBitmaps(),
+	mCapacity(0),
+	mGranularityLog2(0),
+	mUsedSize(0),
+	mAllocationCount(0),
+	mFreeBlockCount(0)
+{
+}
+
+inline RangeAllocator::RangeAllocator(std::uint64_t capacity, std::uint64_t granularity) :
+	RangeAllocator()
+{
+	reset(capacity, granularity);
+}
+
+inline void RangeAllocator::reset(std::uint64_t capacity, std::uint64_t granularity)
+{
+	mBlocks.clear();
+	mUnusedBlocks.clear();
+	mFlBitmap = 0;
+	for (unsigned fl = 0; fl < FL_COUNT; ++fl) {
+		mSlBitmaps[fl] = 0;
+		for (unsigned sl = 0; sl < SL_COUNT; ++sl) {
+			mHeads[fl][sl] = INVALID;
+		}
+	}
+	mGranularityLog2 = (granularity == 0) ? 0 : findLastSet(granularity);
+	mCapacity = capacity >> mGranularityLog2 << mGranularityLog2;
+	mUsedSize = 0;
+	mAllocationCount = 0;
+	mFreeBlockCount = 0;
+
+	if (mCapacity != 0) {
+		insertFree(newBlock(0, mCapacity, INVALID, INVALID));
+	}
+}
+
+inline RangeAllocator::Handle RangeAllocator::allocate(std::uint64_t size, std::uint64_t alignment)
+{
+	const std::uint64_t granularity = std::uint64_t(1) << mGranularityLog2;
+	std::uint64_t units = (size + granularity - 1) >> mGranularityLog2;
+	if (units == 0) {
+		units = 1;
+	}
+	std::uint64_t padding = 0;
+	if (alignment > granularity) {
+		padding = (alignment >> mGranularityLog2) - 1;
+	}
+
+	Handle handle = findFree(units + padding);
+	if (handle == INVALID) {
+		return INVALID;
+	}
+	removeFree(handle);
+
+	if (padding != 0) {
+		Block &block = mBlocks[handle];
+		std::uint64_t aligned = (block.offset + alignment - 1) / alignment * alignment;
+		std::uint64_t gap = aligned - block.offset;
+		if (gap != 0) {
+			Handle front = newBlock(mBlocks[handle].offset, gap, mBlocks[handle].prevPhys, handle);
+			Block &b = mBlocks[handle];
+			if (b.prevPhys != INVALID) {
+				mBlocks[b.prevPhys].nextPhys = front;
+			}
+			b.prevPhys = front;
+			b.offset += gap;
+			b.size -= gap;
+			insertFree(front);
+		}
+	}
+
+	std::uint64_t bytes = units << mGranularityLog2;
+	if (mBlocks[handle].size > bytes) {
+		const Block &b = mBlocks[handle];
+		Handle back = newBlock(b.offset + bytes, b.size - bytes, handle, b.nextPhys);
+		Block &block = mBlocks[handle];
+		if (block.nextPhys != INVALID) {
+			mBlocks[block.nextPhys].prevPhys = back;
+		}
+		block.nextPhys = back;
+		block.size = bytes;
+		insertFree(back);
+	}
+
+	mUsedSize += bytes;
+	++mAllocationCount;
+	return handle;
+}
+
+inline void RangeAllocator::free(Handle handle) noexcept
+{
+	Block &block = mBlocks[handle];
+	mUsedSize -= block.size;
+	--mAllocationCount;
+
+	Handle prev = block.prevPhys;
+	if (prev != INVALID && mBlocks[prev].free) {
+		removeFree(prev);
+		Block &p = mBlocks[prev];
+		p.size += mBlocks[handle].size;
+		p.nextPhys = mBlocks[handle].nextPhys;
+		if (p.nextPhys != INVALID) {
+			mBlocks[p.nextPhys].prevPhys = prev;
+		}
+		deleteBlock(handle);
+		handle = prev;
+	}
+
+	Handle next = mBlocks[handle].nextPhys;
+	if (next != INVALID && mBlocks[next].free) {
+		removeFree(next);
+		Block &b = mBlocks[handle];
+		b.size += mBlocks[next].size;
+		b.nextPhys = mBlocks[next].nextPhys;
+		if (b.nextPhys != INVALID) {
+			mBlocks[b.nextPhys].prevPhys = handle;
+		}
+		deleteBlock(next);
+	}
+
+	insertFree(handle);
+}
+
+inline std::uint64_t RangeAllocator::getOffset(Handle handle) const noexcept
+{
+	return mBlocks[handle].offset;
+}
+
+inline std::uint64_t RangeAllocator::getSize(Handle handle) const noexcept
+{
+	return mBlocks[handle].size;
+}
+
+inline std::uint64_t RangeAllocator::getCapacity() const noexcept
+{
+	return mCapacity;
+}
+
+inline std::uint64_t RangeAllocator::getMaxAllocation(std::uint64_t alignment) const noexcept
+{
+	// findFree() rounds up to the next list, so only sizes up to the
+	// smallest one of the list holding the whole capacity find it.
+	std::uint64_t units = mCapacity >> mGranularityLog2;
+	if (units >= SL_COUNT) {
+		unsigned shift = findLastSet(units) - SL_LOG2;
+		units = units >> shift << shift;
+	}
+	std::uint64_t padding = 0;
+	if (alignment > (std::uint64_t(1) << mGranularityLog2)) {
+		padding = (alignment >> mGranularityLog2) - 1;
+	}
+	return (units > padding) ? (units - padding) << mGranularityLog2 : 0;
+}
+
+inline std::uint64_t RangeAllocator::getGranularity() const noexcept
+{
+	return std::uint64_t(1) << mGranularityLog2;
+}
+
+inline RangeAllocator::Stats RangeAllocator::getStats() const noexcept
+{
+	Stats stats;
+	stats.capacity = mCapacity;
+	stats.usedSize = mUsedSize;
+	stats.freeSize = mCapacity - mUsedSize;
+	stats.largestFreeBlock = 0;
+	stats.allocationCount = mAllocationCount;
+	stats.freeBlockCount = mFreeBlockCount;
+
+	// The largest block is in the highest non-empty list, which only
+	// contains blocks of similar size.
+	if (mFlBitmap != 0) {
+		unsigned fl = findLastSet(mFlBitmap);
+		unsigned sl = findLastSet(mSlBitmaps[fl]);
+		for (Handle h = mHeads[fl][sl]; h != INVALID; h = mBlocks[h].nextFree) {
+			if (mBlocks[h].size > stats.largestFreeBlock) {
+				stats.largestFreeBlock = mBlocks[h].size;
+			}
+		}
+	}
+	return stats;
+}
+
+inline unsigned RangeAllocator::findLastSet(std::uint64_t value) noexcept
+{
+#if defined(__GNUC__)
+	return 63u - static_cast<unsigned>(__builtin_clzll(value));
+#elif defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanReverse64(&index, value);
+	return static_cast<unsigned>(index);
+#else
+	unsigned index = 0;
+	while (value >>= 1) {
+		++index;
+	}
+	return index;
+#endif
+}
+
+inline unsigned RangeAllocator::findFirstSet(std::uint64_t value) noexcept
+{
+#if defined(__GNUC__)
+	return static_cast<unsigned>(__builtin_ctzll(value));
+#elif defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanForward64(&index, value);
+	return static_cast<unsigned>(index);
+#else
+	unsigned index = 0;
+	while ((value & 1) == 0) {
+		value >>= 1;
+		++index;
+	}
+	return index;
+#endif
+}
+
+inline void RangeAllocator::mapping(std::uint64_t units, unsigned &fl, unsigned &sl) noexcept
+{
+	if (units < SL_COUNT) {
+		fl = 0;
+		sl = static_cast<unsigned>(units);
+	} else {
+		unsigned last = findLastSet(units);
+		fl = last - SL_LOG2 + 1;
+		sl = static_cast<unsigned>(units >> (last - SL_LOG2)) - SL_COUNT;
+	}
+}
+
+inline RangeAllocator::Handle RangeAllocator::newBlock(std::uint64_t offset, std::uint64_t size, Handle prevPhys, Handle nextPhys)
+{
+	Block block = { offset, size, prevPhys, nextPhys, INVALID, INVALID, false };
+	if (mUnusedBlocks.empty()) {
+		// Every block may end up unused, so deleteBlock() never allocates.
+		mUnusedBlocks.reserve(mBlocks.size() + 1);
+		mBlocks.push_back(block);
+		return static_cast<Handle>(mBlocks.size() - 1);
+	}
+	Handle handle = mUnusedBlocks.back();
+	mUnusedBlocks.pop_back();
+	mBlocks[handle] = block;
+	return handle;
+}
+
+inline void RangeAllocator::deleteBlock(Handle handle) noexcept
+{
+	// newBlock() has reserved room for every block.
+	mUnusedBlocks.push_back(handle);
+}
+
+inline void RangeAllocator::insertFree(Handle handle) noexcept
+{
+	Block &block = mBlocks[handle];
+	unsigned fl, sl;
+	mapping(block.size >> mGranularityLog2, fl, sl);
+
+	block.free = true;
+	block.prevFree = INVALID;
+	block.nextFree = mHeads[fl][sl];
+	if (block.nextFree != INVALID) {
+		mBlocks[block.nextFree].prevFree = handle;
+	}
+	mHeads[fl][sl] = handle;
+	mSlBitmaps[fl] |= 1u << sl;
+	mFlBitmap |= std::uint64_t(1) << fl;
+	++mFreeBlockCount;
+}
+
+inline void RangeAllocator::removeFree(Handle handle) noexcept
+{
+	Block &block = mBlocks[handle];
+	unsigned fl, sl;
+	mapping(block.size >> mGranularityLog2, fl, sl);
+
+	if (block.prevFree != INVALID) {
+		mBlocks[block.prevFree].nextFree = block.nextFree;
+	} else {
+		mHeads[fl][sl] = block.nextFree;
+		if (block.nextFree == INVALID) {
+			mSlBitmaps[fl] &= ~(1u << sl);
+			if (mSlBitmaps[fl] == 0) {
+				mFlBitmap &= ~(std::uint64_t(1) << fl);
+			}
+		}
+	}
+	if (block.nextFree != INVALID) {
+		mBlocks[block.nextFree].prevFree = block.prevFree;
+	}
+	block.free = false;
+	--mFreeBlockCount;
+}
+
+inline RangeAllocator::Handle RangeAllocator::findFree(std::uint64_t units) const noexcept
+{
+	// Round up to the next list, so that every block in it is large enough.
+	if (units >= SL_COUNT) {
+		units += (std::uint64_t(1) << (findLastSet(units) - SL_LOG2)) - 1;
+	}
+	unsigned fl, sl;
+	mapping(units, fl, sl);
+	if (fl >= FL_COUNT) {
+		return INVALID;
+	}
+
+	std::uint32_t slMap = mSlBitmaps[fl] & (~0u << sl);
+	if (slMap == 0) {
+		std::uint64_t flMap = (fl + 1 < 64) ? (mFlBitmap & (~std::uint64_t(0) << (fl + 1))) : 0;
+		if (flMap == 0) {
+			return INVALID;
+		}
+		fl = findFirstSet(flMap);
+		slMap = mSlBitmaps[fl];
+	}
+	return mHeads[fl][findFirstSet(slMap)];
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_RANGEALLOCATOR_H
@@ -0,0 +1,292 @@
+#ifndef GTL_OGL_READBACKQUEUE_H
+#define GTL_OGL_READBACKQUEUE_H
+
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "gtl/ogl/buffer.h"
+#include "gtl/ogl/openglexception.h"
+#include "gtl/ogl/sync.h"
+#include "gtl/ogl/texture.h"
+
+
+namespace gtl {
+namespace ogl {
+
+// Reads data back from the GPU without stalling. Every request copies into a
+// persistently mapped staging buffer and returns a handle which becomes ready
+// once the fence behind the copy signals. Readbacks are not polled before
+// they are at least `latency` frames old. The queue has to outlive its
+// handles.
+class ReadbackQueue final
+{
+public:
+	class Readback final
+	{
+	public:
+		Readback() noexcept;
+		~Readback() noexcept;
+
+		Readback(Readback &&other) noexcept;
+		Readback &operator = (Readback &&other) noexcept;
+		explicit operator bool () const noexcept;
+
+		void reset() noexcept;
+
+		bool isReady() const;
+		bool wait(std::chrono::nanoseconds timeout) const;
+		const void *getData() const noexcept;
+		GLsizeiptr getSize() const noexcept;
+
+	private:
+		friend class ReadbackQueue;
+
+		Readback(ReadbackQueue *queue, std::size_t slot) noexcept;
+		Readback(const Readback &) = delete;
+		Readback &operator=(const Readback &) = delete;
+
+		ReadbackQueue *mQueue;
+		std::size_t mSlot;
+
+	};
+
+	struct Stats {
+		std::uint64_t requests;
+		std::uint64_t stagingReuses;
+		std::uint64_t stagingAllocations;
+		std::uint64_t polls;
+	};
+
+	explicit ReadbackQueue(GLuint latency = 2) noexcept;
+
+	Readback read(const Buffer &buffer, GLintptr offset, GLsizeiptr size);
+	Readback read(const Texture &texture, GLint level, GLenum format, GLenum type, GLsizei bufSize);
+	void endFrame() noexcept;
+
+	GLuint getLatency() const noexcept;
+	void setLatency(GLuint latency) noexcept;
+
+	const Stats &getStats() const noexcept;
+
+private:
+	struct Slot {
+		Buffer buffer;
+		Sync fence;
+		const char *data;
+		GLsizeiptr capacity;
+		GLsizeiptr size;
+		std::uint64_t frame;
+		bool inUse;
+	};
+
+	ReadbackQueue(const ReadbackQueue &) = delete;
+	ReadbackQueue &operator=(const ReadbackQueue &) = delete;
+
+	std::size_t acquire(GLsizeiptr size);
+	Readback submit(std::size_t slot);
+	bool poll(Slot &slot, GLuint64 timeout);
+
+	std::vector<Slot> mSlots;
+	std::uint64_t mFrame;
+	GLuint mLatency;
+	Stats mStats;
+
+};
+
+
+inline ReadbackQueue::Readback::Readback() noexcept :
+	mQueue(nullptr),
+	mSlot(0)
+{
+}
+
+inline ReadbackQueue::Readback::Readback(ReadbackQueue *queue, std::size_t slot) noexcept :
+	mQueue(queue),
+	mSlot(slot)
+{
+}
+
+inline ReadbackQueue::Readback::~Readback() noexcept
+{
+	reset();
+}
+
+inline ReadbackQueue::Readback::Readback(Readback &&other) noexcept :
+	mQueue(other.mQueue),
+	mSlot(other.mSlot)
+{
+	other.mQueue = nullptr;
+}
+
+inline ReadbackQueue::Readback &ReadbackQueue::Readback::operator =(Readback &&other) noexcept
+{
+	if (this != &other) {
+		reset();
+		mQueue = other.mQueue;
+		mSlot = other.mSlot;
+		other.mQueue = nullptr;
+	}
+	return *this;
+}
+
+inline ReadbackQueue::Readback::operator bool() const noexcept
+{
+	return (mQueue != nullptr);
+}
+
+inline void ReadbackQueue::Readback::reset() noexcept
+{
+	if (mQueue != nullptr) {
+		// A pending fence is kept, so the slot is not reused too early.
+		mQueue->mSlots[mSlot].inUse = false;
+	}
+	mQueue = nullptr;
+}
+
+inline bool ReadbackQueue::Readback::isReady() const
+{
+	Slot &slot = mQueue->mSlots[mSlot];
+	if (!slot.fence) {
+		return true;
+	}
+	if (mQueue->mFrame - slot.frame < mQueue->mLatency) {
+		return false;
+	}
+	return mQueue->poll(slot, 0);
+}
+
+inline bool ReadbackQueue::Readback::wait(std::chrono::nanoseconds timeout) const
+{
+	Slot &slot = mQueue->mSlots[mSlot];
+	if (!slot.fence) {
+		return true;
+	}
+	return mQueue->poll(slot, static_cast<GLuint64>(timeout.count()));
+}
+
+inline const void *ReadbackQueue::Readback::getData() const noexcept
+{
+	return mQueue->mSlots[mSlot].data;
+}
+
+inline GLsizeiptr ReadbackQueue::Readback::getSize() const noexcept
+{
+	return mQueue->mSlots[mSlot].size;
+}
+
+inline ReadbackQueue::ReadbackQueue(GLuint latency) noexcept :
+	mFrame(0),
+	mLatency(latency),
+	mStats()
+{
+}
+
+inline ReadbackQueue::Readback ReadbackQueue::read(const Buffer &buffer, GLintptr offset, GLsizeiptr size)
+{
+	std::size_t slot = acquire(size);
+	mSlots[slot].buffer.copySubData(buffer, offset, 0, size);
+	return submit(slot);
+}
+
+inline ReadbackQueue::Readback ReadbackQueue::read(const Texture &texture, GLint level, GLenum format, GLenum type, GLsizei bufSize)
+{
+	std::size_t slot = acquire(bufSize);
+	const Buffer &staging = mSlots[slot].buffer;
+	staging.bind(Buffer::Target::PIXEL_PACK);
+	texture.getImage(level, format, type, bufSize, nullptr);
+	staging.unbind(Buffer::Target::PIXEL_PACK);
+	return submit(slot);
+}
+
+inline void ReadbackQueue::endFrame() noexcept
+{
+	++mFrame;
+}
+
+inline GLuint ReadbackQueue::getLatency() const noexcept
+{
+	return mLatency;
+}
+
+inline void ReadbackQueue::setLatency(GLuint latency) noexcept
+{
+	mLatency = latency;
+}
+
+inline const ReadbackQueue::Stats &ReadbackQueue::getStats() const noexcept
+{
+	return mStats;
+}
+
+inline std::size_t ReadbackQueue::acquire(GLsizeiptr size)
+{
+	++mStats.requests;
+
+	// Take the smallest idle staging buffer which is large enough.
+	std::size_t best = mSlots.size();
+	for (std::size_t i = 0; i < mSlots.size(); ++i) {
+		Slot &slot = mSlots[i];
+		if (slot.inUse || slot.capacity < size) {
+			continue;
+		}
+		if (slot.fence && !poll(slot, 0)) {
+			continue;
+		}
+		if (best == mSlots.size() || slot.capacity < mSlots[best].capacity) {
+			best = i;
+		}
+	}
+	if (best != mSlots.size()) {
+		++mStats.stagingReuses;
+	} else {
+		const GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		GLsizeiptr capacity = 256;
+		while (capacity < size) {
+			capacity *= 2;
+		}
+
+		Slot slot = { Buffer(true), Sync(), nullptr, capacity, 0, 0, false };
+		slot.buffer.storage(capacity, nullptr, flags | GL_CLIENT_STORAGE_BIT);
+		slot.data = static_cast<const char*>(slot.buffer.map(0, capacity, flags));
+		if (slot.data == nullptr) {
+			throw OpenGLException("Cannot map readback buffer");
+		}
+		mSlots.push_back(std::move(slot));
+		best = mSlots.size() - 1;
+		++mStats.stagingAllocations;
+	}
+
+	mSlots[best].inUse = true;
+	mSlots[best].size = size;
+	mSlots[best].frame = mFrame;
+	return best;
+}
+
+inline ReadbackQueue::Readback ReadbackQueue::submit(std::size_t slot)
+{
+	mSlots[slot].fence.create();
+	return Readback(this, slot);
+}
+
+inline bool ReadbackQueue::poll(Slot &slot, GLuint64 timeout)
+{
+	++mStats.polls;
+	GLenum result = slot.fence.clientWait(GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+	if (result == GL_WAIT_FAILED) {
+		throw OpenGLException("Waiting for readback failed");
+	}
+	if (result == GL_TIMEOUT_EXPIRED) {
+		return false;
+	}
+	slot.fence.reset();
+	return true;
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_READBACKQUEUE_H
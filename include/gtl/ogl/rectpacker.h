@@ -0,0 +1,255 @@
+#ifndef GTL_OGL_RECTPACKER_H
+#define GTL_OGL_RECTPACKER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <GL/glew.h>
+
+
+namespace gtl {
+namespace ogl {
+
+// Online rectangle packer using MaxRects with the best short side fit rule.
+// The free space is kept as a list of maximal free rectangles, which may
+// overlap. Removed rectangles go back to the free list as they are. When an
+// insertion does not fit and enough area was freed since, the list is
+// rebuilt from the used rectangles, so that freed neighbours coalesce.
+class RectPacker final
+{
+public:
+	struct Rect {
+		GLint x;
+		GLint y;
+		GLsizei width;
+		GLsizei height;
+	};
+
+	RectPacker() noexcept;
+	RectPacker(GLsizei width, GLsizei height);
+
+	void reset(GLsizei width, GLsizei height);
+	bool insert(GLsizei width, GLsizei height, Rect &result);
+	void remove(const Rect &rect);
+
+	GLsizei getWidth() const noexcept;
+	GLsizei getHeight() const noexcept;
+	std::uint64_t getUsedArea() const noexcept;
+	double getOccupancy() const noexcept;
+
+private:
+	static bool contains(const Rect &outer, const Rect &inner) noexcept;
+	static bool intersects(const Rect &a, const Rect &b) noexcept;
+	void place(const Rect &used);
+	void split(const Rect &free, const Rect &used);
+	void prune();
+	void rebuild();
+
+	std::vector<Rect> mFree;
+	std::vector<Rect> mUsed;
+	std::vector<Rect> mSplit;
+	GLsizei mWidth;
+	GLsizei mHeight;
+	std::uint64_t mUsedArea;
+	std::uint64_t mFreedArea;
+
+};
+
+
+inline RectPacker::RectPacker() noexcept :
+	mWidth(0),
+	mHeight(0),
+	mUsedArea(0),
+	mFreedArea(0)
+{
+}
+
+inline RectPacker::RectPacker(GLsizei width, GLsizei height) :
+	RectPacker()
+{
+	reset(width, height);
+}
+
+inline void RectPacker::reset(GLsizei width, GLsizei height)
+{
+	Rect all = { 0, 0, width, height };
+	mFree.assign(1, all);
+	mUsed.clear();
+	mWidth = width;
+	mHeight = height;
+	mUsedArea = 0;
+	mFreedArea = 0;
+}
+
+inline bool RectPacker::insert(GLsizei width, GLsizei height, Rect &result)
+{
+	GLsizei bestShort = std::numeric_limits<GLsizei>::max();
+	GLsizei bestLong = std::numeric_limits<GLsizei>::max();
+	std::size_t best = mFree.size();
+	for (std::size_t i = 0; i < mFree.size(); ++i) {
+		const Rect &free = mFree[i];
+		if (free.width < width || free.height < height) {
+			continue;
+		}
+		GLsizei dx = free.width - width;
+		GLsizei dy = free.height - height;
+		GLsizei shortSide = (dx < dy) ? dx : dy;
+		GLsizei longSide = (dx < dy) ? dy : dx;
+		if (shortSide < bestShort || (shortSide == bestShort && longSide < bestLong)) {
+			best = i;
+			bestShort = shortSide;
+			bestLong = longSide;
+		}
+	}
+	if (best == mFree.size()) {
+		// Rebuilding is expensive, and cannot help much without enough freed
+		// area.
+		if (mFreedArea < static_cast<std::uint64_t>(width) * height) {
+			return false;
+		}
+		rebuild();
+		return insert(width, height, result);
+	}
+
+	result.x = mFree[best].x;
+	result.y = mFree[best].y;
+	result.width = width;
+	result.height = height;
+	place(result);
+	mUsed.push_back(result);
+	mUsedArea += static_cast<std::uint64_t>(width) * height;
+	return true;
+}
+
+inline void RectPacker::remove(const Rect &rect)
+{
+	for (std::size_t i = 0; i < mUsed.size(); ++i) {
+		if (mUsed[i].x == rect.x && mUsed[i].y == rect.y) {
+			mUsed[i] = mUsed.back();
+			mUsed.pop_back();
+			mUsedArea -= static_cast<std::uint64_t>(rect.width) * rect.height;
+			if (mUsed.empty()) {
+				reset(mWidth, mHeight);
+			} else {
+				// No free rectangle overlaps a used one, so the list stays free
+				// of contained rectangles.
+				mFree.push_back(rect);
+				mFreedArea += static_cast<std::uint64_t>(rect.width) * rect.height;
+			}
+			return;
+		}
+	}
+}
+
+inline GLsizei RectPacker::getWidth() const noexcept
+{
+	return mWidth;
+}
+
+inline GLsizei RectPacker::getHeight() const noexcept
+{
+	return mHeight;
+}
+
+inline std::uint64_t RectPacker::getUsedArea() const noexcept
+{
+	return mUsedArea;
+}
+
+inline double RectPacker::getOccupancy() const noexcept
+{
+	std::uint64_t area = static_cast<std::uint64_t>(mWidth) * mHeight;
+	return (area == 0) ? 0.0 : static_cast<double>(mUsedArea) / area;
+}
+
+inline bool RectPacker::contains(const Rect &outer, const Rect &inner) noexcept
+{
+	return inner.x >= outer.x && inner.y >= outer.y
+		&& inner.x + inner.width <= outer.x + outer.width
+		&& inner.y + inner.height <= outer.y + outer.height;
+}
+
+inline bool RectPacker::intersects(const Rect &a, const Rect &b) noexcept
+{
+	return a.x < b.x + b.width && b.x < a.x + a.width
+		&& a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+inline void RectPacker::place(const Rect &used)
+{
+	// Every free rectangle which overlaps the used one is split into the
+	// parts around it.
+	mSplit.clear();
+	for (std::size_t i = 0; i < mFree.size(); ) {
+		if (intersects(mFree[i], used)) {
+			split(mFree[i], used);
+			mFree[i] = mFree.back();
+			mFree.pop_back();
+		} else {
+			++i;
+		}
+	}
+	mFree.insert(mFree.end(), mSplit.begin(), mSplit.end());
+	prune();
+}
+
+inline void RectPacker::split(const Rect &free, const Rect &used)
+{
+	if (used.x > free.x) {
+		Rect left = { free.x, free.y, used.x - free.x, free.height };
+		mSplit.push_back(left);
+	}
+	if (used.x + used.width < free.x + free.width) {
+		Rect right = { used.x + used.width, free.y, free.x + free.width - used.x - used.width, free.height };
+		mSplit.push_back(right);
+	}
+	if (used.y > free.y) {
+		Rect bottom = { free.x, free.y, free.width, used.y - free.y };
+		mSplit.push_back(bottom);
+	}
+	if (used.y + used.height < free.y + free.height) {
+		Rect top = { free.x, used.y + used.height, free.width, free.y + free.height - used.y - used.height };
+		mSplit.push_back(top);
+	}
+}
+
+inline void RectPacker::prune()
+{
+	for (std::size_t i = 0; i < mFree.size(); ++i) {
+		for (std::size_t j = i + 1; j < mFree.size(); ) {
+			if (contains(mFree[i], mFree[j])) {
+				mFree[j] = mFree.back();
+				mFree.pop_back();
+			} else if (contains(mFree[j], mFree[i])) {
+				mFree[i] = mFree[j];
+				mFree[j] = mFree.back();
+				mFree.pop_back();
+				// mFree[i] changed, so its containment has to be checked again.
+				j = i + 1;
+			} else {
+				++j;
+			}
+		}
+	}
+}
+
+inline void RectPacker::rebuild()
+{
+	// Placing row by row keeps the intermediate free lists short.
+	std::sort(mUsed.begin(), mUsed.end(), [](const Rect &a, const Rect &b) {
+		return (a.y != b.y) ? (a.y < b.y) : (a.x < b.x);
+	});
+	Rect all = { 0, 0, mWidth, mHeight };
+	mFree.assign(1, all);
+	for (const Rect &used : mUsed) {
+		place(used);
+	}
+	mFreedArea = 0;
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_RECTPACKER_H
@@ -0,0 +1,170 @@
+#ifndef GTL_OGL_SAMPLER_H
+#define GTL_OGL_SAMPLER_H
+
+#include <GL/glew.h>
+
+
+namespace gtl {
+namespace ogl {
+
+class Sampler final
+{
+public:
+	Sampler(bool create);
+	explicit Sampler(GLuint samplerName = 0) noexcept;
+	~Sampler() noexcept;
+
+	Sampler(Sampler &&other) noexcept;
+	Sampler &operator = (Sampler &&other) noexcept;
+	explicit operator bool () const noexcept;
+
+	void create();
+	void reset(GLuint samplerName = 0) noexcept;
+	GLuint release() noexcept;
+
+	GLuint get() const noexcept;
+	void bind(GLuint unit) const;
+	void unbind(GLuint unit) const;
+
+	void setParameter(GLenum pname, GLfloat param);
+	void setParameter(GLenum pname, const GLfloat *param);
+	void setParameter(GLenum pname, GLint param);
+	void setParameter(GLenum pname, const GLint *param);
+	void setParameterI(GLenum pname, const GLint *params);
+	void setParameterI(GLenum pname, const GLuint *params);
+
+	void getParameter(GLenum pname, GLfloat *params) const;
+	void getParameter(GLenum pname, GLint *params) const;
+
+	// Binds samplers to the units first to first + count - 1 in one call;
+	// samplers may be null to unbind all of them.
+	static void bind(GLuint first, GLsizei count, const GLuint *samplers);
+
+private:
+	Sampler(const Sampler &) = delete;
+	Sampler &operator=(const Sampler &) = delete;
+
+	GLuint mId;
+
+};
+
+
+inline Sampler::Sampler(bool create) :
+	Sampler()
+{
+	if (create) {
+		this->create();
+	}
+}
+
+inline Sampler::Sampler(GLuint samplerName) noexcept :
+	mId(samplerName)
+{
+}
+
+inline Sampler::~Sampler() noexcept
+{
+	reset();
+}
+
+inline Sampler::Sampler(Sampler &&other) noexcept :
+	mId(other.release())
+{
+}
+
+inline Sampler &Sampler::operator =(Sampler &&other) noexcept
+{
+	reset(other.release());
+	return *this;
+}
+
+inline Sampler::operator bool() const noexcept
+{
+	return (mId != 0);
+}
+
+inline void Sampler::create()
+{
+	reset();
+	glCreateSamplers(1, &mId);
+}
+
+inline void Sampler::reset(GLuint samplerName) noexcept
+{
+	if (mId != 0) {
+		glDeleteSamplers(1, &mId);
+	}
+	mId = samplerName;
+}
+
+inline GLuint Sampler::release() noexcept
+{
+	GLuint tmp = mId;
+	mId = 0;
+	return tmp;
+}
+
+inline GLuint Sampler::get() const noexcept
+{
+	return mId;
+}
+
+inline void Sampler::bind(GLuint unit) const
+{
+	glBindSampler(unit, mId);
+}
+
+inline void Sampler::unbind(GLuint unit) const
+{
+	glBindSampler(unit, 0);
+}
+
+inline void Sampler::setParameter(GLenum pname, GLfloat param)
+{
+	glSamplerParameterf(mId, pname, param);
+}
+
+inline void Sampler::setParameter(GLenum pname, const GLfloat *param)
+{
+	glSamplerParameterfv(mId, pname, param);
+}
+
+inline void Sampler::setParameter(GLenum pname, GLint param)
+{
+	glSamplerParameteri(mId, pname, param);
+}
+
+inline void Sampler::setParameter(GLenum pname, const GLint *param)
+{
+	glSamplerParameteriv(mId, pname, param);
+}
+
+inline void Sampler::setParameterI(GLenum pname, const GLint *params)
+{
+	glSamplerParameterIiv(mId, pname, params);
+}
+
+inline void Sampler::setParameterI(GLenum pname, const GLuint *params)
+{
+	glSamplerParameterIuiv(mId, pname, params);
+}
+
+inline void Sampler::getParameter(GLenum pname, GLfloat *params) const
+{
+	glGetSamplerParameterfv(mId, pname, params);
+}
+
+inline void Sampler::getParameter(GLenum pname, GLint *params) const
+{
+	glGetSamplerParameteriv(mId, pname, params);
+}
+
+inline void Sampler::bind(GLuint first, GLsizei count, const GLuint *samplers)
+{
+	glBindSamplers(first, count, samplers);
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_SAMPLER_H
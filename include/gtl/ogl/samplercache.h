@@ -0,0 +1,261 @@
+#ifndef GTL_OGL_SAMPLERCACHE_H
+#define GTL_OGL_SAMPLERCACHE_H
+
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "gtl/ogl/hasher.h"
+#include "gtl/ogl/sampler.h"
+
+
+namespace gtl {
+namespace ogl {
+
+// Complete sampling state of a sampler object. The default constructor sets
+// the defaults of OpenGL. Floats are compared by their bits with -0 taken as
+// 0, so that a NaN still finds its cached sampler.
+struct SamplerState {
+	GLenum minFilter;
+	GLenum magFilter;
+	GLenum wrapS;
+	GLenum wrapT;
+	GLenum wrapR;
+	GLenum compareMode;
+	GLenum compareFunc;
+	GLfloat minLod;
+	GLfloat maxLod;
+	GLfloat lodBias;
+	GLfloat maxAnisotropy;
+	GLfloat borderColor[4];
+
+	SamplerState() noexcept;
+
+	SamplerState &setFilter(GLenum min, GLenum mag) noexcept;
+	SamplerState &setWrap(GLenum wrap) noexcept;
+	SamplerState &setWrap(GLenum s, GLenum t, GLenum r) noexcept;
+	SamplerState &setCompare(GLenum func) noexcept;
+	SamplerState &setAnisotropy(GLfloat anisotropy) noexcept;
+
+	std::uint64_t getHash() const noexcept;
+	void apply(Sampler &sampler) const;
+
+	bool operator == (const SamplerState &other) const noexcept;
+	bool operator != (const SamplerState &other) const noexcept;
+};
+
+// Shares one sampler object per distinct SamplerState, so that textures are
+// never changed to sample them differently. The returned samplers live until
+// clear() or the destruction of the cache.
+class SamplerCache final
+{
+public:
+	struct Stats {
+		std::uint64_t hits;
+		std::uint64_t misses;
+	};
+
+	SamplerCache() noexcept;
+
+	const Sampler &get(const SamplerState &state);
+	void bind(GLuint first, const std::vector<SamplerState> &states);
+	void clear() noexcept;
+
+	std::size_t getSize() const noexcept;
+	const Stats &getStats() const noexcept;
+	void resetStats() noexcept;
+
+private:
+	struct Hash {
+		std::size_t operator () (const SamplerState &state) const noexcept;
+	};
+
+	SamplerCache(const SamplerCache &) = delete;
+	SamplerCache &operator=(const SamplerCache &) = delete;
+
+	std::unordered_map<SamplerState, Sampler, Hash> mSamplers;
+	std::vector<GLuint> mNames;
+	Stats mStats;
+
+};
+
+namespace detail {
+
+inline GLuint floatBits(GLfloat value) noexcept
+{
+	GLuint bits = 0;
+	if (value != 0.0f) {
+		std::memcpy(&bits, &value, sizeof(bits));
+	}
+	return bits;
+}
+
+} // namespace detail
+
+
+inline SamplerState::SamplerState() noexcept :
+	minFilter(GL_NEAREST_MIPMAP_LINEAR),
+	magFilter(GL_LINEAR),
+	wrapS(GL_REPEAT),
+	wrapT(GL_REPEAT),
+	wrapR(GL_REPEAT),
+	compareMode(GL_NONE),
+	compareFunc(GL_LEQUAL),
+	minLod(-1000.0f),
+	maxLod(1000.0f),
+	lodBias(0.0f),
+	maxAnisotropy(1.0f),
+	borderColor{ 0.0f, 0.0f, 0.0f, 0.0f }
+{
+}
+
+inline SamplerState &SamplerState::setFilter(GLenum min, GLenum mag) noexcept
+{
+	minFilter = min;
+	magFilter = mag;
+	return *this;
+}
+
+inline SamplerState &SamplerState::setWrap(GLenum wrap) noexcept
+{
+	return setWrap(wrap, wrap, wrap);
+}
+
+inline SamplerState &SamplerState::setWrap(GLenum s, GLenum t, GLenum r) noexcept
+{
+	wrapS = s;
+	wrapT = t;
+	wrapR = r;
+	return *this;
+}
+
+inline SamplerState &SamplerState::setCompare(GLenum func) noexcept
+{
+	compareMode = GL_COMPARE_REF_TO_TEXTURE;
+	compareFunc = func;
+	return *this;
+}
+
+inline SamplerState &SamplerState::setAnisotropy(GLfloat anisotropy) noexcept
+{
+	maxAnisotropy = anisotropy;
+	return *this;
+}
+
+inline std::uint64_t SamplerState::getHash() const noexcept
+{
+	// Field by field, so that padding never takes part.
+	Hasher hasher;
+	hasher.addValue(minFilter).addValue(magFilter);
+	hasher.addValue(wrapS).addValue(wrapT).addValue(wrapR);
+	hasher.addValue(compareMode).addValue(compareFunc);
+	hasher.addValue(detail::floatBits(minLod)).addValue(detail::floatBits(maxLod));
+	hasher.addValue(detail::floatBits(lodBias)).addValue(detail::floatBits(maxAnisotropy));
+	for (GLfloat value : borderColor) {
+		hasher.addValue(detail::floatBits(value));
+	}
+	return hasher.getValue();
+}
+
+inline void SamplerState::apply(Sampler &sampler) const
+{
+	const SamplerState defaults;
+	sampler.setParameter(GL_TEXTURE_MIN_FILTER, static_cast<GLint>(minFilter));
+	sampler.setParameter(GL_TEXTURE_MAG_FILTER, static_cast<GLint>(magFilter));
+	sampler.setParameter(GL_TEXTURE_WRAP_S, static_cast<GLint>(wrapS));
+	sampler.setParameter(GL_TEXTURE_WRAP_T, static_cast<GLint>(wrapT));
+	sampler.setParameter(GL_TEXTURE_WRAP_R, static_cast<GLint>(wrapR));
+	sampler.setParameter(GL_TEXTURE_COMPARE_MODE, static_cast<GLint>(compareMode));
+	sampler.setParameter(GL_TEXTURE_COMPARE_FUNC, static_cast<GLint>(compareFunc));
+	sampler.setParameter(GL_TEXTURE_MIN_LOD, minLod);
+	sampler.setParameter(GL_TEXTURE_MAX_LOD, maxLod);
+	sampler.setParameter(GL_TEXTURE_LOD_BIAS, lodBias);
+	sampler.setParameter(GL_TEXTURE_BORDER_COLOR, borderColor);
+	// Anisotropic filtering is only core since OpenGL 4.6, so the default is
+	// not set explicitly.
+	if (maxAnisotropy != defaults.maxAnisotropy) {
+		sampler.setParameter(GL_TEXTURE_MAX_ANISOTROPY_EXT, maxAnisotropy);
+	}
+}
+
+inline bool SamplerState::operator ==(const SamplerState &other) const noexcept
+{
+	return minFilter == other.minFilter && magFilter == other.magFilter
+		&& wrapS == other.wrapS && wrapT == other.wrapT && wrapR == other.wrapR
+		&& compareMode == other.compareMode && compareFunc == other.compareFunc
+		&& detail::floatBits(minLod) == detail::floatBits(other.minLod)
+		&& detail::floatBits(maxLod) == detail::floatBits(other.maxLod)
+		&& detail::floatBits(lodBias) == detail::floatBits(other.lodBias)
+		&& detail::floatBits(maxAnisotropy) == detail::floatBits(other.maxAnisotropy)
+		&& detail::floatBits(borderColor[0]) == detail::floatBits(other.borderColor[0])
+		&& detail::floatBits(borderColor[1]) == detail::floatBits(other.borderColor[1])
+		&& detail::floatBits(borderColor[2]) == detail::floatBits(other.borderColor[2])
+		&& detail::floatBits(borderColor[3]) == detail::floatBits(other.borderColor[3]);
+}
+
+inline bool SamplerState::operator !=(const SamplerState &other) const noexcept
+{
+	return !(*this == other);
+}
+
+inline SamplerCache::SamplerCache() noexcept :
+	mStats()
+{
+}
+
+inline const Sampler &SamplerCache::get(const SamplerState &state)
+{
+	auto it = mSamplers.find(state);
+	if (it != mSamplers.end()) {
+		++mStats.hits;
+		return it->second;
+	}
+
+	++mStats.misses;
+	Sampler sampler(true);
+	state.apply(sampler);
+	return mSamplers.emplace(state, std::move(sampler)).first->second;
+}
+
+inline void SamplerCache::bind(GLuint first, const std::vector<SamplerState> &states)
+{
+	mNames.clear();
+	for (const SamplerState &state : states) {
+		mNames.push_back(get(state).get());
+	}
+	Sampler::bind(first, static_cast<GLsizei>(mNames.size()), mNames.data());
+}
+
+inline void SamplerCache::clear() noexcept
+{
+	mSamplers.clear();
+}
+
+inline std::size_t SamplerCache::getSize() const noexcept
+{
+	return mSamplers.size();
+}
+
+inline const SamplerCache::Stats &SamplerCache::getStats() const noexcept
+{
+	return mStats;
+}
+
+inline void SamplerCache::resetStats() noexcept
+{
+	mStats = Stats();
+}
+
+inline std::size_t SamplerCache::Hash::operator ()(const SamplerState &state) const noexcept
+{
+	return static_cast<std::size_t>(state.getHash());
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_SAMPLERCACHE_H
@@ -3,6 +3,7 @@
 
 #include <limits>
 #include <string>
+#include <vector>
 
 #include <GL/glew.h>
 
@@ -42,9 +43,17 @@ public:
 
 	void setSource(const std::string &source);
 	void setSource(GLsizei count, const GLchar **sources, GLint *length);
+	void setBinary(GLenum binaryFormat, const void *binary, GLsizei length);
+	void specialize(const std::string &entryPoint = "main", GLuint count = 0, const GLuint *indices = nullptr, const GLuint *values = nullptr);
 	void compile();
+	void startCompile();
+	bool isCompileCompleted() const;
+	bool getCompileStatus() const;
 	std::string getInfoLog() const;
 
+	static bool isParallelCompileSupported() noexcept;
+	static bool isSpirvSupported() noexcept;
+
 private:
 	Shader(const Shader &) = delete;
 	Shader &operator=(const Shader &) = delete;
@@ -139,16 +148,50 @@ inline void Shader::setSource(GLsizei count, const GLchar **sources, GLint *leng
 	glShaderSource(mId, count, sources, length);
 }
 
+inline void Shader::setBinary(GLenum binaryFormat, const void *binary, GLsizei length)
+{
+	glShaderBinary(1, &mId, binaryFormat, binary, length);
+}
+
+inline void Shader::specialize(const std::string &entryPoint, GLuint count, const GLuint *indices, const GLuint *values)
+{
+	// Takes the place of compile() for SPIR-V binaries.
+	glSpecializeShader(mId, entryPoint.c_str(), count, indices, values);
+	if (!getCompileStatus()) {
+		throw ShaderException("Error while specializing shader");
+	}
+}
+
 inline void Shader::compile()
 {
-	GLint status;
-	glCompileShader(mId);
-	glGetShaderiv(mId, GL_COMPILE_STATUS, &status);
-	if (status != GL_TRUE) {
+	startCompile();
+	if (!getCompileStatus()) {
 		throw ShaderException("Error while compiling shader");
 	}
 }
 
+inline void Shader::startCompile()
+{
+	glCompileShader(mId);
+}
+
+inline bool Shader::isCompileCompleted() const
+{
+	if (!isParallelCompileSupported()) {
+		return true;
+	}
+	GLint completed;
+	glGetShaderiv(mId, GL_COMPLETION_STATUS_KHR, &completed);
+	return (completed == GL_TRUE);
+}
+
+inline bool Shader::getCompileStatus() const
+{
+	GLint status;
+	glGetShaderiv(mId, GL_COMPILE_STATUS, &status);
+	return (status == GL_TRUE);
+}
+
 inline std::string Shader::getInfoLog() const
 {
 	GLint lenght;
@@ -162,6 +205,16 @@ inline std::string Shader::getInfoLog() const
 	}
 }
 
+inline bool Shader::isParallelCompileSupported() noexcept
+{
+	return GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile;
+}
+
+inline bool Shader::isSpirvSupported() noexcept
+{
+	return GLEW_VERSION_4_6 || GLEW_ARB_gl_spirv;
+}
+
 } // namespace ogl
 } // namespace gtl
 
@@ -0,0 +1,115 @@
+#ifndef GTL_OGL_SHADERFILESYSTEM_H
+#define GTL_OGL_SHADERFILESYSTEM_H
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+
+
+namespace gtl {
+namespace ogl {
+
+// Source of shader files for ShaderPreprocessor. Returned strings stay valid
+// until the file is invalidated or the file system is destroyed, so
+// preprocessed sources can point into them instead of copying.
+class ShaderFileSystem
+{
+public:
+	virtual ~ShaderFileSystem() = default;
+
+	virtual const std::string *load(const std::string &path) = 0;
+	virtual void invalidate(const std::string &path) = 0;
+
+};
+
+class MemoryFileSystem final : public ShaderFileSystem
+{
+public:
+	void add(const std::string &path, const std::string &content);
+
+	virtual const std::string *load(const std::string &path) override;
+	virtual void invalidate(const std::string &path) override;
+
+private:
+	std::unordered_map<std::string, std::string> mFiles;
+
+};
+
+// Reads files relative to a root directory and keeps them in memory.
+class DiskFileSystem final : public ShaderFileSystem
+{
+public:
+	explicit DiskFileSystem(const std::string &root = std::string());
+
+	const std::string &getRoot() const noexcept;
+	std::string getFullPath(const std::string &path) const;
+
+	virtual const std::string *load(const std::string &path) override;
+	virtual void invalidate(const std::string &path) override;
+
+private:
+	std::string mRoot;
+	std::unordered_map<std::string, std::string> mFiles;
+
+};
+
+
+inline void MemoryFileSystem::add(const std::string &path, const std::string &content)
+{
+	mFiles[path] = content;
+}
+
+inline const std::string *MemoryFileSystem::load(const std::string &path)
+{
+	auto it = mFiles.find(path);
+	return (it == mFiles.end()) ? nullptr : &it->second;
+}
+
+inline void MemoryFileSystem::invalidate(const std::string &)
+{
+	// Files in memory are the source of truth, so there is nothing to reload.
+}
+
+inline DiskFileSystem::DiskFileSystem(const std::string &root) :
+	mRoot(root)
+{
+	if (!mRoot.empty() && mRoot.back() != '/') {
+		mRoot += '/';
+	}
+}
+
+inline const std::string &DiskFileSystem::getRoot() const noexcept
+{
+	return mRoot;
+}
+
+inline std::string DiskFileSystem::getFullPath(const std::string &path) const
+{
+	return mRoot + path;
+}
+
+inline const std::string *DiskFileSystem::load(const std::string &path)
+{
+	auto it = mFiles.find(path);
+	if (it != mFiles.end()) {
+		return &it->second;
+	}
+
+	std::ifstream in(getFullPath(path).c_str(), std::ios::binary);
+	if (!in) {
+		return nullptr;
+	}
+	std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	return &mFiles.insert(std::make_pair(path, std::move(content))).first->second;
+}
+
+inline void DiskFileSystem::invalidate(const std::string &path)
+{
+	mFiles.erase(path);
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_SHADERFILESYSTEM_H
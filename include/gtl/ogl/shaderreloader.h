@@ -0,0 +1,357 @@
+#ifndef GTL_OGL_SHADERRELOADER_H
+#define GTL_OGL_SHADERRELOADER_H
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "gtl/ogl/filewatcher.h"
+#include "gtl/ogl/program.h"
+#include "gtl/ogl/shader.h"
+#include "gtl/ogl/shaderexception.h"
+#include "gtl/ogl/shaderfilesystem.h"
+#include "gtl/ogl/shadersource.h"
+
+
+namespace gtl {
+namespace ogl {
+
+// Reloads programs when one of their source files changes on disk. Every
+// stage knows the files it includes, so a change to an include file only
+// recompiles the stages which use it; the other stages are linked from the
+// shaders of the last successful build. Compiling and linking is started in
+// update() and polled in later calls, so with KHR_parallel_shader_compile
+// the render thread never waits for the driver. The registered Program is
+// replaced only after a successful link; on failure it stays untouched and
+// getInfoLog() tells why.
+//
+// The reloader keeps a pointer to the registered Program, so it must neither
+// move nor be destroyed until its handle is removed. A reload keeps the
+// uniform shadowing setting, but the new program starts with default uniform
+// values like after every link, so they have to be set again.
+class ShaderReloader final
+{
+public:
+	struct Stage {
+		Shader::Type type;
+		std::string path;
+		DefineSet defines;
+	};
+
+	struct Stats {
+		std::uint64_t reloads;
+		std::uint64_t failures;
+		std::uint64_t compiledShaders;
+	};
+
+	typedef std::uint32_t Handle;
+
+	explicit ShaderReloader(DiskFileSystem &fileSystem);
+
+	Handle add(Program &program, const std::vector<Stage> &stages, bool reflect = false);
+	void remove(Handle handle);
+
+	void update();
+	void reload(const std::string &path);
+
+	const std::string &getInfoLog(Handle handle) const;
+	std::size_t getPendingCount() const noexcept;
+
+	const Stats &getStats() const noexcept;
+	void resetStats() noexcept;
+
+private:
+	enum class State {
+		IDLE,
+		COMPILING,
+		LINKING
+	};
+
+	struct Entry {
+		Program *program;
+		std::vector<Stage> stages;
+		std::vector<Shader> shaders;
+		std::vector<std::vector<std::string>> dependencies;
+		std::vector<std::uint32_t> versions;
+		std::vector<std::uint32_t> builtVersions;
+		std::vector<std::uint32_t> pendingVersions;
+		std::vector<Shader> pendingShaders;
+		Program pendingProgram;
+		std::string infoLog;
+		State state;
+		bool changed;
+		bool reflect;
+	};
+
+	typedef std::pair<Handle, std::size_t> Dependent;
+
+	ShaderReloader(const ShaderReloader &) = delete;
+	ShaderReloader &operator=(const ShaderReloader &) = delete;
+
+	void setDependencies(Handle handle, Entry &entry, std::size_t stage, const std::vector<std::string> &dependencies);
+	void start(Handle handle, Entry &entry);
+	void updateCompiling(Entry &entry);
+	void updateLinking(Entry &entry);
+	void fail(Entry &entry, const std::string &infoLog);
+
+	DiskFileSystem &mFileSystem;
+	ShaderPreprocessor mPreprocessor;
+	FileWatcher mWatcher;
+	std::map<Handle, Entry> mEntries;
+	std::unordered_map<std::string, std::set<Dependent>> mDependents;
+	Handle mNextHandle;
+	std::size_t mPendingCount;
+	Stats mStats;
+
+};
+
+
+inline ShaderReloader::ShaderReloader(DiskFileSystem &fileSystem) :
+	mFileSystem(fileSystem),
+	mPreprocessor(fileSystem),
+	mWatcher(fileSystem.getRoot()),
+	mNextHandle(0),
+	mPendingCount(0),
+	mStats()
+{
+}
+
+inline ShaderReloader::Handle ShaderReloader::add(Program &program, const std::vector<Stage> &stages, bool reflect)
+{
+	Entry entry;
+	entry.program = &program;
+	entry.stages = stages;
+	entry.dependencies.resize(stages.size());
+	entry.versions.assign(stages.size(), 0);
+	entry.builtVersions.assign(stages.size(), 0);
+	entry.state = State::IDLE;
+	entry.changed = false;
+	entry.reflect = reflect;
+
+	// The first build is synchronous and reports errors like Shader::compile()
+	// and Program::link() do.
+	std::vector<std::vector<std::string>> dependencies;
+	Program linked(true);
+	for (const Stage &stage : stages) {
+		ShaderSource source = mPreprocessor.process(stage.path, stage.defines);
+		entry.shaders.emplace_back(stage.type);
+		source.apply(entry.shaders.back());
+		entry.shaders.back().compile();
+		linked.attachShader(entry.shaders.back());
+		dependencies.push_back(source.getDependencies());
+	}
+	linked.link(reflect);
+	for (const Shader &shader : entry.shaders) {
+		linked.detachShader(shader);
+	}
+
+	linked.setShadowed(program.isShadowed());
+	program = std::move(linked);
+	Handle handle = ++mNextHandle;
+	Entry &added = mEntries.emplace(handle, std::move(entry)).first->second;
+	for (std::size_t i = 0; i < stages.size(); ++i) {
+		setDependencies(handle, added, i, dependencies[i]);
+	}
+	return handle;
+}
+
+inline void ShaderReloader::remove(Handle handle)
+{
+	auto it = mEntries.find(handle);
+	if (it == mEntries.end()) {
+		return;
+	}
+	for (std::size_t i = 0; i < it->second.stages.size(); ++i) {
+		setDependencies(handle, it->second, i, std::vector<std::string>());
+	}
+	if (it->second.state != State::IDLE) {
+		--mPendingCount;
+	}
+	mEntries.erase(it);
+}
+
+inline void ShaderReloader::update()
+{
+	for (const std::string &path : mWatcher.takeChanges()) {
+		reload(path);
+	}
+
+	for (auto &it : mEntries) {
+		Entry &entry = it.second;
+		if (entry.state == State::COMPILING) {
+			updateCompiling(entry);
+		}
+		if (entry.state == State::LINKING) {
+			updateLinking(entry);
+		}
+		// Changes during a build start another one once it has finished.
+		if (entry.state == State::IDLE) {
+			start(it.first, entry);
+		}
+	}
+}
+
+inline void ShaderReloader::reload(const std::string &path)
+{
+	mFileSystem.invalidate(path);
+	auto it = mDependents.find(path);
+	if (it == mDependents.end()) {
+		return;
+	}
+	for (const Dependent &dependent : it->second) {
+		Entry &entry = mEntries.find(dependent.first)->second;
+		++entry.versions[dependent.second];
+		entry.changed = true;
+	}
+}
+
+inline const std::string &ShaderReloader::getInfoLog(Handle handle) const
+{
+	static const std::string empty;
+	auto it = mEntries.find(handle);
+	return (it == mEntries.end()) ? empty : it->second.infoLog;
+}
+
+inline std::size_t ShaderReloader::getPendingCount() const noexcept
+{
+	return mPendingCount;
+}
+
+inline const ShaderReloader::Stats &ShaderReloader::getStats() const noexcept
+{
+	return mStats;
+}
+
+inline void ShaderReloader::resetStats() noexcept
+{
+	mStats = Stats();
+}
+
+inline void ShaderReloader::setDependencies(Handle handle, Entry &entry, std::size_t stage, const std::vector<std::string> &dependencies)
+{
+	Dependent dependent(handle, stage);
+	for (const std::string &path : entry.dependencies[stage]) {
+		auto it = mDependents.find(path);
+		if (it != mDependents.end()) {
+			it->second.erase(dependent);
+			if (it->second.empty()) {
+				mDependents.erase(it);
+			}
+		}
+	}
+	for (const std::string &path : dependencies) {
+		mDependents[path].insert(dependent);
+		mWatcher.watch(path);
+	}
+	entry.dependencies[stage] = dependencies;
+}
+
+inline void ShaderReloader::start(Handle handle, Entry &entry)
+{
+	if (!entry.changed) {
+		return;
+	}
+	entry.changed = false;
+
+	// Stages which failed before are built again together with the changed
+	// ones, but a failed build is only retried after the next change.
+	++mStats.reloads;
+	entry.pendingShaders.clear();
+	entry.pendingShaders.resize(entry.stages.size());
+	entry.pendingVersions = entry.versions;
+	for (std::size_t i = 0; i < entry.stages.size(); ++i) {
+		if (entry.versions[i] == entry.builtVersions[i]) {
+			continue;
+		}
+
+		const Stage &stage = entry.stages[i];
+		try {
+			ShaderSource source = mPreprocessor.process(stage.path, stage.defines);
+			// Also a failed build has to be retried when one of its files changes.
+			setDependencies(handle, entry, i, source.getDependencies());
+			entry.pendingShaders[i].create(stage.type);
+			source.apply(entry.pendingShaders[i]);
+		} catch (const ShaderException &e) {
+			fail(entry, e.what());
+			return;
+		}
+		entry.pendingShaders[i].startCompile();
+		++mStats.compiledShaders;
+	}
+	entry.state = State::COMPILING;
+	++mPendingCount;
+}
+
+inline void ShaderReloader::updateCompiling(Entry &entry)
+{
+	for (const Shader &shader : entry.pendingShaders) {
+		if (shader && !shader.isCompileCompleted()) {
+			return;
+		}
+	}
+	for (const Shader &shader : entry.pendingShaders) {
+		if (shader && !shader.getCompileStatus()) {
+			--mPendingCount;
+			fail(entry, shader.getInfoLog());
+			return;
+		}
+	}
+
+	entry.pendingProgram.create();
+	for (std::size_t i = 0; i < entry.stages.size(); ++i) {
+		entry.pendingProgram.attachShader(entry.pendingShaders[i] ? entry.pendingShaders[i] : entry.shaders[i]);
+	}
+	entry.pendingProgram.startLink();
+	entry.state = State::LINKING;
+}
+
+inline void ShaderReloader::updateLinking(Entry &entry)
+{
+	if (!entry.pendingProgram.isLinkCompleted()) {
+		return;
+	}
+	--mPendingCount;
+	for (std::size_t i = 0; i < entry.stages.size(); ++i) {
+		entry.pendingProgram.detachShader(entry.pendingShaders[i] ? entry.pendingShaders[i] : entry.shaders[i]);
+	}
+
+	if (!entry.pendingProgram.getLinkStatus()) {
+		fail(entry, entry.pendingProgram.getInfoLog());
+		return;
+	}
+	if (entry.reflect) {
+		entry.pendingProgram.reflect();
+	}
+
+	entry.pendingProgram.setShadowed(entry.program->isShadowed());
+	*entry.program = std::move(entry.pendingProgram);
+	for (std::size_t i = 0; i < entry.stages.size(); ++i) {
+		if (entry.pendingShaders[i]) {
+			entry.shaders[i] = std::move(entry.pendingShaders[i]);
+			entry.builtVersions[i] = entry.pendingVersions[i];
+		}
+	}
+	entry.pendingShaders.clear();
+	entry.infoLog.clear();
+	entry.state = State::IDLE;
+}
+
+inline void ShaderReloader::fail(Entry &entry, const std::string &infoLog)
+{
+	entry.pendingShaders.clear();
+	entry.pendingProgram.reset();
+	entry.infoLog = infoLog;
+	entry.state = State::IDLE;
+	++mStats.failures;
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_SHADERRELOADER_H
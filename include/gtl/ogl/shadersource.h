@@ -0,0 +1,324 @@
+#ifndef GTL_OGL_SHADERSOURCE_H
+#define GTL_OGL_SHADERSOURCE_H
+
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "gtl/ogl/hasher.h"
+#include "gtl/ogl/shader.h"
+#include "gtl/ogl/shaderexception.h"
+#include "gtl/ogl/shaderfilesystem.h"
+
+
+namespace gtl {
+namespace ogl {
+
+// Set of preprocessor definitions. They are kept sorted, so the order in
+// which they are set does not change the resulting source.
+class DefineSet final
+{
+public:
+	DefineSet &set(const std::string &name, const std::string &value = std::string());
+	DefineSet &set(const std::string &name, int value);
+	void erase(const std::string &name);
+	bool empty() const noexcept;
+
+	std::string toString() const;
+
+private:
+	std::map<std::string, std::string> mDefines;
+
+};
+
+// Preprocessed shader source as a list of strings for glShaderSource. The
+// strings point into the files of a ShaderFileSystem, so shared headers are
+// never copied. The file system has to keep the files while the source is
+// used.
+class ShaderSource final
+{
+public:
+	ShaderSource() = default;
+
+	ShaderSource(ShaderSource &&other) = default;
+	ShaderSource &operator = (ShaderSource &&other) = default;
+
+	void append(const char *data, std::size_t length);
+	void appendCopy(const std::string &str);
+	std::size_t addDependency(const std::string &path);
+
+	void apply(Shader &shader) const;
+
+	std::uint64_t getHash() const noexcept;
+	const std::vector<std::string> &getDependencies() const noexcept;
+	std::string toString() const;
+
+private:
+	ShaderSource(const ShaderSource &) = delete;
+	ShaderSource &operator=(const ShaderSource &) = delete;
+
+	std::vector<const GLchar*> mStrings;
+	std::vector<GLint> mLengths;
+	std::deque<std::string> mGenerated;
+	std::vector<std::string> mDependencies;
+	Hasher mHasher;
+
+};
+
+// Resolves #include "file" directives and inserts defines after the #version
+// directive. Every file is included at most once per source. Included files
+// are searched relative to the including file first and relative to the root
+// of the file system second. #line directives keep the line numbers in info
+// logs meaningful; the source string number is the index of the file in
+// ShaderSource::getDependencies().
+class ShaderPreprocessor final
+{
+public:
+	explicit ShaderPreprocessor(ShaderFileSystem &fileSystem) noexcept;
+
+	ShaderSource process(const std::string &path, const DefineSet &defines = DefineSet());
+	ShaderFileSystem &getFileSystem() const noexcept;
+
+private:
+	static bool parseInclude(const std::string &content, std::size_t begin, std::size_t end, std::string &path);
+	static std::size_t findVersion(const std::string &content);
+	static std::string getDirectory(const std::string &path);
+
+	void expand(ShaderSource &source, const std::string &content, const std::string &path, std::size_t fileIndex, const std::string *defines, std::set<std::string> &included);
+
+	ShaderFileSystem &mFileSystem;
+
+};
+
+
+inline DefineSet &DefineSet::set(const std::string &name, const std::string &value)
+{
+	mDefines[name] = value;
+	return *this;
+}
+
+inline DefineSet &DefineSet::set(const std::string &name, int value)
+{
+	return set(name, std::to_string(value));
+}
+
+inline void DefineSet::erase(const std::string &name)
+{
+	mDefines.erase(name);
+}
+
+inline bool DefineSet::empty() const noexcept
+{
+	return mDefines.empty();
+}
+
+inline std::string DefineSet::toString() const
+{
+	std::string result;
+	for (const auto &define : mDefines) {
+		result += "#define " + define.first;
+		if (!define.second.empty()) {
+			result += ' ' + define.second;
+		}
+		result += '\n';
+	}
+	return result;
+}
+
+inline void ShaderSource::append(const char *data, std::size_t length)
+{
+	if (length == 0) {
+		return;
+	}
+	if (length > static_cast<std::size_t>(std::numeric_limits<GLint>::max())) {
+		throw ShaderException("Shader source too large.");
+	}
+	mStrings.push_back(data);
+	mLengths.push_back(static_cast<GLint>(length));
+	// The hash only depends on the text, not on how it is split.
+	mHasher.add(data, length);
+}
+
+inline void ShaderSource::appendCopy(const std::string &str)
+{
+	// Elements of a deque never move when appending.
+	mGenerated.push_back(str);
+	append(mGenerated.back().data(), mGenerated.back().size());
+}
+
+inline std::size_t ShaderSource::addDependency(const std::string &path)
+{
+	mDependencies.push_back(path);
+	return mDependencies.size() - 1;
+}
+
+inline void ShaderSource::apply(Shader &shader) const
+{
+	shader.setSource(static_cast<GLsizei>(mStrings.size()), const_cast<const GLchar**>(mStrings.data()), const_cast<GLint*>(mLengths.data()));
+}
+
+inline std::uint64_t ShaderSource::getHash() const noexcept
+{
+	return mHasher.getValue();
+}
+
+inline const std::vector<std::string> &ShaderSource::getDependencies() const noexcept
+{
+	return mDependencies;
+}
+
+inline std::string ShaderSource::toString() const
+{
+	std::string result;
+	for (std::size_t i = 0; i < mStrings.size(); ++i) {
+		result.append(mStrings[i], mLengths[i]);
+	}
+	return result;
+}
+
+inline ShaderPreprocessor::ShaderPreprocessor(ShaderFileSystem &fileSystem) noexcept :
+	mFileSystem(fileSystem)
+{
+}
+
+inline ShaderSource ShaderPreprocessor::process(const std::string &path, const DefineSet &defines)
+{
+	const std::string *content = mFileSystem.load(path);
+	if (content == nullptr) {
+		throw ShaderException("Cannot load shader " + path);
+	}
+
+	ShaderSource source;
+	std::set<std::string> included;
+	included.insert(path);
+	std::string defineString = defines.toString();
+	expand(source, *content, path, source.addDependency(path), &defineString, included);
+	return source;
+}
+
+inline ShaderFileSystem &ShaderPreprocessor::getFileSystem() const noexcept
+{
+	return mFileSystem;
+}
+
+inline bool ShaderPreprocessor::parseInclude(const std::string &content, std::size_t begin, std::size_t end, std::string &path)
+{
+	std::size_t pos = content.find_first_not_of(" \t", begin);
+	if (pos >= end || content[pos] != '#') {
+		return false;
+	}
+	pos = content.find_first_not_of(" \t", pos + 1);
+	if (pos >= end || content.compare(pos, 7, "include") != 0) {
+		return false;
+	}
+	pos = content.find_first_not_of(" \t", pos + 7);
+	if (pos >= end || (content[pos] != '"' && content[pos] != '<')) {
+		return false;
+	}
+	char close = (content[pos] == '"') ? '"' : '>';
+	std::size_t last = content.find(close, pos + 1);
+	if (last >= end) {
+		return false;
+	}
+	path = content.substr(pos + 1, last - pos - 1);
+	return true;
+}
+
+inline std::size_t ShaderPreprocessor::findVersion(const std::string &content)
+{
+	// Only a directive at the start of a line counts, not a mention of it in
+	// a comment or string behind other code.
+	std::size_t begin = 0;
+	while (begin < content.size()) {
+		std::size_t end = content.find('\n', begin);
+		if (end == std::string::npos) {
+			end = content.size();
+		}
+		std::size_t pos = content.find_first_not_of(" \t", begin);
+		if (pos < end && content[pos] == '#') {
+			pos = content.find_first_not_of(" \t", pos + 1);
+			if (pos < end && content.compare(pos, 7, "version") == 0) {
+				return begin;
+			}
+		}
+		begin = end + 1;
+	}
+	return std::string::npos;
+}
+
+inline std::string ShaderPreprocessor::getDirectory(const std::string &path)
+{
+	std::size_t slash = path.rfind('/');
+	return (slash == std::string::npos) ? std::string() : path.substr(0, slash + 1);
+}
+
+inline void ShaderPreprocessor::expand(ShaderSource &source, const std::string &content, const std::string &path, std::size_t fileIndex, const std::string *defines, std::set<std::string> &included)
+{
+	std::size_t pos = 0;
+	std::size_t chunk = 0;
+	std::size_t line = 1;
+
+	if (defines != nullptr && !defines->empty()) {
+		std::size_t version = findVersion(content);
+		if (version != std::string::npos) {
+			std::size_t split = content.find('\n', version);
+			split = (split == std::string::npos) ? content.size() : split + 1;
+			for (std::size_t i = 0; i < split; ++i) {
+				line += (content[i] == '\n') ? 1 : 0;
+			}
+			source.append(content.data(), split);
+			pos = chunk = split;
+		}
+		source.appendCopy(*defines);
+		source.appendCopy("#line " + std::to_string(line) + ' ' + std::to_string(fileIndex) + '\n');
+	}
+
+	std::string includePath;
+	while (pos < content.size()) {
+		std::size_t end = content.find('\n', pos);
+		if (end == std::string::npos) {
+			end = content.size();
+		}
+
+		if (parseInclude(content, pos, end, includePath)) {
+			source.append(content.data() + chunk, pos - chunk);
+			chunk = (end < content.size()) ? end + 1 : end;
+
+			std::string resolved = getDirectory(path) + includePath;
+			const std::string *includedContent = mFileSystem.load(resolved);
+			if (includedContent == nullptr) {
+				resolved = includePath;
+				includedContent = mFileSystem.load(resolved);
+			}
+			if (includedContent == nullptr) {
+				throw ShaderException("Cannot resolve #include \"" + includePath + "\" in " + path);
+			}
+			if (included.insert(resolved).second) {
+				std::size_t index = source.addDependency(resolved);
+				source.appendCopy("#line 1 " + std::to_string(index) + '\n');
+				expand(source, *includedContent, resolved, index, nullptr, included);
+				source.appendCopy("\n#line " + std::to_string(line + 1) + ' ' + std::to_string(fileIndex) + '\n');
+			} else {
+				// Keeps the following lines at their number.
+				source.appendCopy("\n");
+			}
+		}
+
+		pos = end + 1;
+		++line;
+	}
+	if (chunk < content.size()) {
+		source.append(content.data() + chunk, content.size() - chunk);
+	}
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_SHADERSOURCE_H
@@ -0,0 +1,162 @@
+#ifndef GTL_OGL_SHADERVARIANTCACHE_H
+#define GTL_OGL_SHADERVARIANTCACHE_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "gtl/ogl/hasher.h"
+#include "gtl/ogl/program.h"
+#include "gtl/ogl/shader.h"
+#include "gtl/ogl/shadersource.h"
+
+
+namespace gtl {
+namespace ogl {
+
+// Compiles every distinct preprocessed source only once. Shaders are keyed by
+// their type and the hash of the final source, so variants which expand to
+// the same text share one shader object. Programs are keyed by the keys of
+// their shaders. References stay valid until the cache is cleared.
+class ShaderVariantCache final
+{
+public:
+	typedef std::pair<Shader::Type, const ShaderSource*> Stage;
+
+	struct Stats {
+		std::uint64_t shaderHits;
+		std::uint64_t shaderMisses;
+		std::uint64_t programHits;
+		std::uint64_t programMisses;
+	};
+
+	explicit ShaderVariantCache(ShaderPreprocessor &preprocessor);
+
+	const Shader &getShader(Shader::Type type, const ShaderSource &source);
+	const Shader &getShader(Shader::Type type, const std::string &path, const DefineSet &defines = DefineSet());
+	const Program &getProgram(const std::vector<Stage> &stages, bool reflect = false);
+
+	void clear() noexcept;
+	std::size_t getShaderCount() const noexcept;
+	std::size_t getProgramCount() const noexcept;
+
+	const Stats &getStats() const noexcept;
+	void resetStats() noexcept;
+
+private:
+	ShaderVariantCache(const ShaderVariantCache &) = delete;
+	ShaderVariantCache &operator=(const ShaderVariantCache &) = delete;
+
+	static std::uint64_t getShaderKey(Shader::Type type, const ShaderSource &source);
+
+	ShaderPreprocessor &mPreprocessor;
+	std::unordered_map<std::uint64_t, Shader> mShaders;
+	std::unordered_map<std::uint64_t, Program> mPrograms;
+	Stats mStats;
+
+};
+
+
+inline ShaderVariantCache::ShaderVariantCache(ShaderPreprocessor &preprocessor) :
+	mPreprocessor(preprocessor),
+	mStats()
+{
+}
+
+inline const Shader &ShaderVariantCache::getShader(Shader::Type type, const ShaderSource &source)
+{
+	std::uint64_t key = getShaderKey(type, source);
+	auto it = mShaders.find(key);
+	if (it != mShaders.end()) {
+		++mStats.shaderHits;
+		return it->second;
+	}
+
+	Shader shader(type);
+	source.apply(shader);
+	shader.compile();
+	++mStats.shaderMisses;
+	return mShaders.emplace(key, std::move(shader)).first->second;
+}
+
+inline const Shader &ShaderVariantCache::getShader(Shader::Type type, const std::string &path, const DefineSet &defines)
+{
+	ShaderSource source = mPreprocessor.process(path, defines);
+	return getShader(type, source);
+}
+
+inline const Program &ShaderVariantCache::getProgram(const std::vector<Stage> &stages, bool reflect)
+{
+	Hasher hasher;
+	for (const Stage &stage : stages) {
+		hasher.addValue(getShaderKey(stage.first, *stage.second));
+	}
+	hasher.addValue(reflect);
+	std::uint64_t key = hasher.getValue();
+
+	auto it = mPrograms.find(key);
+	if (it != mPrograms.end()) {
+		++mStats.programHits;
+		return it->second;
+	}
+
+	std::vector<const Shader*> shaders;
+	shaders.reserve(stages.size());
+	for (const Stage &stage : stages) {
+		shaders.push_back(&getShader(stage.first, *stage.second));
+	}
+
+	Program program(true);
+	for (const Shader *shader : shaders) {
+		program.attachShader(*shader);
+	}
+	program.link(reflect);
+	for (const Shader *shader : shaders) {
+		program.detachShader(*shader);
+	}
+	++mStats.programMisses;
+	return mPrograms.emplace(key, std::move(program)).first->second;
+}
+
+inline void ShaderVariantCache::clear() noexcept
+{
+	mPrograms.clear();
+	mShaders.clear();
+}
+
+inline std::size_t ShaderVariantCache::getShaderCount() const noexcept
+{
+	return mShaders.size();
+}
+
+inline std::size_t ShaderVariantCache::getProgramCount() const noexcept
+{
+	return mPrograms.size();
+}
+
+inline const ShaderVariantCache::Stats &ShaderVariantCache::getStats() const noexcept
+{
+	return mStats;
+}
+
+inline void ShaderVariantCache::resetStats() noexcept
+{
+	mStats = Stats();
+}
+
+inline std::uint64_t ShaderVariantCache::getShaderKey(Shader::Type type, const ShaderSource &source)
+{
+	Hasher hasher;
+	hasher.addValue(static_cast<GLenum>(type));
+	hasher.addValue(source.getHash());
+	return hasher.getValue();
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_SHADERVARIANTCACHE_H
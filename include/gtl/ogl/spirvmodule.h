@@ -0,0 +1,241 @@
+#ifndef GTL_OGL_SPIRVMODULE_H
+#define GTL_OGL_SPIRVMODULE_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "gtl/ogl/mappedfile.h"
+#include "gtl/ogl/shader.h"
+#include "gtl/ogl/shaderexception.h"
+
+
+namespace gtl {
+namespace ogl {
+
+// Values for the specialization constants of a SPIR-V module, stored as
+// their 32-bit patterns as glSpecializeShader expects them.
+class SpecializationConstants final
+{
+public:
+	SpecializationConstants &set(GLuint index, GLuint value);
+	SpecializationConstants &set(GLuint index, GLint value);
+	SpecializationConstants &set(GLuint index, GLfloat value);
+	SpecializationConstants &set(GLuint index, bool value);
+	bool empty() const noexcept;
+
+	GLuint getCount() const noexcept;
+	const GLuint *getIndices() const noexcept;
+	const GLuint *getValues() const noexcept;
+
+private:
+	std::vector<GLuint> mIndices;
+	std::vector<GLuint> mValues;
+
+};
+
+// SPIR-V module mapped into memory. open() fails for files which are not
+// SPIR-V in host byte order.
+class SpirvModule final
+{
+public:
+	SpirvModule() noexcept = default;
+	explicit SpirvModule(const std::string &path);
+
+	SpirvModule(SpirvModule &&other) = default;
+	SpirvModule &operator = (SpirvModule &&other) = default;
+	explicit operator bool () const noexcept;
+
+	bool open(const std::string &path);
+	void close() noexcept;
+
+	void apply(Shader &shader, const std::string &entryPoint = "main", const SpecializationConstants &constants = SpecializationConstants()) const;
+
+	const void *getData() const noexcept;
+	std::size_t getSize() const noexcept;
+
+	static bool isValid(const void *data, std::size_t size) noexcept;
+
+private:
+	static const std::uint32_t MAGIC = 0x07230203u;
+
+	SpirvModule(const SpirvModule &) = delete;
+	SpirvModule &operator=(const SpirvModule &) = delete;
+
+	MappedFile mFile;
+
+};
+
+// Creates shaders either from GLSL sources or from the SPIR-V modules built
+// next to them by gtl_add_spirv_shaders() (cmake/GtlSpirv.cmake), so callers
+// switch between both paths with one flag. Specialization constants only
+// apply to SPIR-V; GLSL sources keep their default values.
+class ShaderLoader final
+{
+public:
+	explicit ShaderLoader(bool spirv = Shader::isSpirvSupported(), const std::string &spirvExtension = ".spv");
+
+	Shader load(Shader::Type type, const std::string &path, const SpecializationConstants &constants = SpecializationConstants()) const;
+
+	bool isSpirv() const noexcept;
+	void setSpirv(bool spirv) noexcept;
+
+private:
+	bool mSpirv;
+	std::string mSpirvExtension;
+
+};
+
+
+inline SpecializationConstants &SpecializationConstants::set(GLuint index, GLuint value)
+{
+	for (std::size_t i = 0; i < mIndices.size(); ++i) {
+		if (mIndices[i] == index) {
+			mValues[i] = value;
+			return *this;
+		}
+	}
+	mIndices.push_back(index);
+	mValues.push_back(value);
+	return *this;
+}
+
+inline SpecializationConstants &SpecializationConstants::set(GLuint index, GLint value)
+{
+	return set(index, static_cast<GLuint>(value));
+}
+
+inline SpecializationConstants &SpecializationConstants::set(GLuint index, GLfloat value)
+{
+	GLuint bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	return set(index, bits);
+}
+
+inline SpecializationConstants &SpecializationConstants::set(GLuint index, bool value)
+{
+	return set(index, static_cast<GLuint>(value ? 1 : 0));
+}
+
+inline bool SpecializationConstants::empty() const noexcept
+{
+	return mIndices.empty();
+}
+
+inline GLuint SpecializationConstants::getCount() const noexcept
+{
+	return static_cast<GLuint>(mIndices.size());
+}
+
+inline const GLuint *SpecializationConstants::getIndices() const noexcept
+{
+	return mIndices.data();
+}
+
+inline const GLuint *SpecializationConstants::getValues() const noexcept
+{
+	return mValues.data();
+}
+
+inline SpirvModule::SpirvModule(const std::string &path)
+{
+	open(path);
+}
+
+inline SpirvModule::operator bool() const noexcept
+{
+	return static_cast<bool>(mFile);
+}
+
+inline bool SpirvModule::open(const std::string &path)
+{
+	if (!mFile.open(path)) {
+		return false;
+	}
+	if (!isValid(mFile.getData(), mFile.getSize())) {
+		mFile.close();
+		return false;
+	}
+	return true;
+}
+
+inline void SpirvModule::close() noexcept
+{
+	mFile.close();
+}
+
+inline void SpirvModule::apply(Shader &shader, const std::string &entryPoint, const SpecializationConstants &constants) const
+{
+	if (!mFile) {
+		throw ShaderException("No SPIR-V module loaded.");
+	}
+	shader.setBinary(GL_SHADER_BINARY_FORMAT_SPIR_V, mFile.getData(), static_cast<GLsizei>(mFile.getSize()));
+	shader.specialize(entryPoint, constants.getCount(), constants.getIndices(), constants.getValues());
+}
+
+inline const void *SpirvModule::getData() const noexcept
+{
+	return mFile.getData();
+}
+
+inline std::size_t SpirvModule::getSize() const noexcept
+{
+	return mFile.getSize();
+}
+
+inline bool SpirvModule::isValid(const void *data, std::size_t size) noexcept
+{
+	// The header has five words and the module consists of whole words.
+	if (data == nullptr || size < 5 * sizeof(std::uint32_t) || size % sizeof(std::uint32_t) != 0) {
+		return false;
+	}
+	std::uint32_t magic;
+	std::memcpy(&magic, data, sizeof(magic));
+	return (magic == MAGIC);
+}
+
+inline ShaderLoader::ShaderLoader(bool spirv, const std::string &spirvExtension) :
+	mSpirv(spirv),
+	mSpirvExtension(spirvExtension)
+{
+}
+
+inline Shader ShaderLoader::load(Shader::Type type, const std::string &path, const SpecializationConstants &constants) const
+{
+	Shader shader(type);
+	if (mSpirv) {
+		SpirvModule module(path + mSpirvExtension);
+		if (!module) {
+			throw ShaderException("Cannot load SPIR-V module " + path + mSpirvExtension);
+		}
+		module.apply(shader, "main", constants);
+	} else {
+		std::ifstream in(path.c_str(), std::ios::binary);
+		if (!in) {
+			throw ShaderException("Cannot load shader " + path);
+		}
+		shader.setSource(std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>()));
+		shader.compile();
+	}
+	return shader;
+}
+
+inline bool ShaderLoader::isSpirv() const noexcept
+{
+	return mSpirv;
+}
+
+inline void ShaderLoader::setSpirv(bool spirv) noexcept
+{
+	mSpirv = spirv;
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_SPIRVMODULE_H
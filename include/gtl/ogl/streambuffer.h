@@ -0,0 +1,238 @@
+#ifndef GTL_OGL_STREAMBUFFER_H
+#define GTL_OGL_STREAMBUFFER_H
+
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "gtl/ogl/buffer.h"
+#include "gtl/ogl/openglexception.h"
+#include "gtl/ogl/sync.h"
+
+
+namespace gtl {
+namespace ogl {
+
+// Ring of regions in one persistently mapped buffer. Call begin() once per
+// frame before writing and end() after the last draw which reads the region.
+class StreamBuffer final
+{
+public:
+	struct Stats {
+		std::uint64_t frames;
+		std::uint64_t wraps;
+		std::uint64_t waits;
+		std::chrono::nanoseconds waitTime;
+	};
+
+	StreamBuffer() noexcept;
+	StreamBuffer(GLsizeiptr regionSize, GLuint regionCount = 3);
+	~StreamBuffer() noexcept = default;
+
+	StreamBuffer(StreamBuffer &&other) noexcept;
+	StreamBuffer &operator = (StreamBuffer &&other) noexcept;
+	explicit operator bool () const noexcept;
+
+	void create(GLsizeiptr regionSize, GLuint regionCount = 3);
+	void reset() noexcept;
+
+	const Buffer &getBuffer() const noexcept;
+	GLsizeiptr getRegionSize() const noexcept;
+	GLuint getRegionCount() const noexcept;
+
+	void *begin();
+	void end();
+
+	void *getData() const noexcept;
+	GLintptr getOffset() const noexcept;
+	GLintptr allocate(GLsizeiptr size, GLsizeiptr alignment = 1) noexcept;
+	void *getPointer(GLintptr offset) const noexcept;
+
+	const Stats &getStats() const noexcept;
+	void resetStats() noexcept;
+
+private:
+	StreamBuffer(const StreamBuffer &) = delete;
+	StreamBuffer &operator=(const StreamBuffer &) = delete;
+
+	Buffer mBuffer;
+	std::vector<Sync> mFences;
+	char *mData;
+	GLsizeiptr mRegionSize;
+	GLuint mRegion;
+	GLsizeiptr mCursor;
+	Stats mStats;
+
+};
+
+
+inline StreamBuffer::StreamBuffer() noexcept :
+	mData(nullptr),
+	mRegionSize(0),
+	mRegion(0),
+	mCursor(0),
+	mStats()
+{
+}
+
+inline StreamBuffer::StreamBuffer(GLsizeiptr regionSize, GLuint regionCount) :
+	StreamBuffer()
+{
+	create(regionSize, regionCount);
+}
+
+inline StreamBuffer::StreamBuffer(StreamBuffer &&other) noexcept :
+	mBuffer(std::move(other.mBuffer)),
+	mFences(std::move(other.mFences)),
+	mData(other.mData),
+	mRegionSize(other.mRegionSize),
+	mRegion(other.mRegion),
+	mCursor(other.mCursor),
+	mStats(other.mStats)
+{
+	other.reset();
+}
+
+inline StreamBuffer &StreamBuffer::operator =(StreamBuffer &&other) noexcept
+{
+	if (this != &other) {
+		mBuffer = std::move(other.mBuffer);
+		mFences.swap(other.mFences);
+		mData = other.mData;
+		mRegionSize = other.mRegionSize;
+		mRegion = other.mRegion;
+		mCursor = other.mCursor;
+		mStats = other.mStats;
+		other.reset();
+	}
+	return *this;
+}
+
+inline StreamBuffer::operator bool() const noexcept
+{
+	return (mData != nullptr);
+}
+
+inline void StreamBuffer::create(GLsizeiptr regionSize, GLuint regionCount)
+{
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	reset();
+	mBuffer.create();
+	mBuffer.storage(regionSize * regionCount, nullptr, flags);
+	mData = static_cast<char*>(mBuffer.map(0, regionSize * regionCount, flags));
+	if (mData == nullptr) {
+		mBuffer.reset();
+		throw OpenGLException("Cannot map stream buffer");
+	}
+	mFences.resize(regionCount);
+	mRegionSize = regionSize;
+	// begin() advances first, so the first frame ends up in region 0.
+	mRegion = regionCount - 1;
+}
+
+inline void StreamBuffer::reset() noexcept
+{
+	// Deleting the buffer unmaps it implicitly.
+	mBuffer.reset();
+	mFences.clear();
+	mData = nullptr;
+	mRegionSize = 0;
+	mRegion = 0;
+	mCursor = 0;
+	mStats = Stats();
+}
+
+inline const Buffer &StreamBuffer::getBuffer() const noexcept
+{
+	return mBuffer;
+}
+
+inline GLsizeiptr StreamBuffer::getRegionSize() const noexcept
+{
+	return mRegionSize;
+}
+
+inline GLuint StreamBuffer::getRegionCount() const noexcept
+{
+	return static_cast<GLuint>(mFences.size());
+}
+
+inline void *StreamBuffer::begin()
+{
+	if (++mRegion == mFences.size()) {
+		mRegion = 0;
+		if (mStats.frames != 0) {
+			++mStats.wraps;
+		}
+	}
+	++mStats.frames;
+	mCursor = 0;
+
+	Sync &fence = mFences[mRegion];
+	if (fence) {
+		GLenum result = fence.clientWait(0, 0);
+		if (result == GL_TIMEOUT_EXPIRED) {
+			auto start = std::chrono::steady_clock::now();
+			do {
+				result = fence.clientWait(GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+			} while (result == GL_TIMEOUT_EXPIRED);
+			++mStats.waits;
+			mStats.waitTime += std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - start);
+		}
+		fence.reset();
+		if (result == GL_WAIT_FAILED) {
+			throw OpenGLException("Waiting for stream buffer region failed");
+		}
+	}
+	return getData();
+}
+
+inline void StreamBuffer::end()
+{
+	mFences[mRegion].create();
+}
+
+inline void *StreamBuffer::getData() const noexcept
+{
+	return mData + getOffset();
+}
+
+inline GLintptr StreamBuffer::getOffset() const noexcept
+{
+	return static_cast<GLintptr>(mRegion) * mRegionSize;
+}
+
+inline GLintptr StreamBuffer::allocate(GLsizeiptr size, GLsizeiptr alignment) noexcept
+{
+	GLsizeiptr start = (mCursor + alignment - 1) / alignment * alignment;
+	if (start + size > mRegionSize) {
+		return -1;
+	}
+	mCursor = start + size;
+	return getOffset() + start;
+}
+
+inline void *StreamBuffer::getPointer(GLintptr offset) const noexcept
+{
+	return mData + offset;
+}
+
+inline const StreamBuffer::Stats &StreamBuffer::getStats() const noexcept
+{
+	return mStats;
+}
+
+inline void StreamBuffer::resetStats() noexcept
+{
+	mStats = Stats();
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_STREAMBUFFER_H
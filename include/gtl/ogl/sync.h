@@ -0,0 +1,119 @@
+#ifndef GTL_OGL_SYNC_H
+#define GTL_OGL_SYNC_H
+
+#include <GL/glew.h>
+
+
+namespace gtl {
+namespace ogl {
+
+class Sync final
+{
+public:
+	Sync(bool create);
+	explicit Sync(GLsync syncObject = nullptr) noexcept;
+	~Sync() noexcept;
+
+	Sync(Sync &&other) noexcept;
+	Sync &operator = (Sync &&other) noexcept;
+	explicit operator bool () const noexcept;
+
+	void create();
+	void reset(GLsync syncObject = nullptr) noexcept;
+	GLsync release() noexcept;
+
+	GLsync get() const noexcept;
+
+	GLenum clientWait(GLbitfield flags, GLuint64 timeout) const;
+	void wait() const;
+	bool isSignaled() const;
+
+private:
+	Sync(const Sync &) = delete;
+	Sync &operator=(const Sync &) = delete;
+
+	GLsync mId;
+
+};
+
+
+inline Sync::Sync(bool create) :
+	Sync()
+{
+	if (create) {
+		this->create();
+	}
+}
+
+inline Sync::Sync(GLsync syncObject) noexcept :
+	mId(syncObject)
+{
+}
+
+inline Sync::~Sync() noexcept
+{
+	reset();
+}
+
+inline Sync::Sync(Sync &&other) noexcept :
+	mId(other.release())
+{
+}
+
+inline Sync &Sync::operator =(Sync &&other) noexcept
+{
+	reset(other.release());
+	return *this;
+}
+
+inline Sync::operator bool() const noexcept
+{
+	return (mId != nullptr);
+}
+
+inline void Sync::create()
+{
+	reset(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+}
+
+inline void Sync::reset(GLsync syncObject) noexcept
+{
+	if (mId != nullptr) {
+		glDeleteSync(mId);
+	}
+	mId = syncObject;
+}
+
+inline GLsync Sync::release() noexcept
+{
+	GLsync tmp = mId;
+	mId = nullptr;
+	return tmp;
+}
+
+inline GLsync Sync::get() const noexcept
+{
+	return mId;
+}
+
+inline GLenum Sync::clientWait(GLbitfield flags, GLuint64 timeout) const
+{
+	return glClientWaitSync(mId, flags, timeout);
+}
+
+inline void Sync::wait() const
+{
+	glWaitSync(mId, 0, GL_TIMEOUT_IGNORED);
+}
+
+inline bool Sync::isSignaled() const
+{
+	GLint status;
+	glGetSynciv(mId, GL_SYNC_STATUS, 1, nullptr, &status);
+	return (status == GL_SIGNALED);
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_SYNC_H
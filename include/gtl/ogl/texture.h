@@ -35,11 +35,14 @@ public:
 	explicit operator bool () const noexcept;
 
 	void create(Target target);
+	void createView(Target target, const Texture &original, GLenum internalformat, GLuint minlevel, GLuint numlevels, GLuint minlayer, GLuint numlayers);
 	void reset(GLuint textureName = 0) noexcept;
 	GLuint release() noexcept;
 
 	GLuint get() const noexcept;
 	void bind(GLuint unit) const;
+	GLuint64 getHandle() const;
+	GLuint64 getHandle(GLuint samplerName) const;
 
 	// TODO glTextureBuffer and glTextureBufferRange
 	void storage(GLsizei levels, GLenum internalformat, GLsizei width);
@@ -57,6 +60,8 @@ public:
 
 	// TODO glCopyTextureSubImage
 
+	void pageCommitment(GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, bool commit);
+
 	void getImage(GLint level, GLenum format, GLenum type, GLsizei bufSize, GLvoid *pixels) const;
 	void getCompressedImage(GLint level, GLsizei bufSize, GLvoid *pixels) const;
 
@@ -67,8 +72,8 @@ public:
 	void setParameterI(GLenum pname, const GLint *params);
 	void setParameterI(GLenum pname, const GLuint *params);
 
-	// TODO getParameter
-	// TODO getLevelParameter
+	void getParameter(GLenum pname, GLint *params) const;
+	void getLevelParameter(GLint level, GLenum pname, GLint *params) const;
 
 	void generateMipmap();
 
@@ -117,6 +122,15 @@ inline void Texture::create(Target target)
 	glCreateTextures(static_cast<GLenum>(target), 1, &mId);
 }
 
+inline void Texture::createView(Target target, const Texture &original, GLenum internalformat, GLuint minlevel, GLuint numlevels, GLuint minlayer, GLuint numlayers)
+{
+	// glTextureView needs a name which was never bound, so it cannot come
+	// from glCreateTextures.
+	reset();
+	glGenTextures(1, &mId);
+	glTextureView(mId, static_cast<GLenum>(target), original.get(), internalformat, minlevel, numlevels, minlayer, numlayers);
+}
+
 inline void Texture::reset(GLuint textureName) noexcept
 {
 	if (mId != 0) {
@@ -142,6 +156,16 @@ inline void Texture::bind(GLuint unit) const
 	glBindTextureUnit(unit, mId);
 }
 
+inline GLuint64 Texture::getHandle() const
+{
+	return glGetTextureHandleARB(mId);
+}
+
+inline GLuint64 Texture::getHandle(GLuint samplerName) const
+{
+	return glGetTextureSamplerHandleARB(mId, samplerName);
+}
+
 inline void Texture::storage(GLsizei levels, GLenum internalformat, GLsizei width)
 {
 	glTextureStorage1D(mId, levels, internalformat, width);
@@ -197,6 +221,33 @@ inline void Texture::setCompressedSubImage(GLint level, GLint xoffset, GLint yof
 	glCompressedTextureSubImage3D(mId, level, xoffset, yoffset, zoffset, width, height, depth, format, imageSize, data);
 }
 
+inline void Texture::pageCommitment(GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, bool commit)
+{
+	if (GLEW_EXT_direct_state_access) {
+		glTexturePageCommitmentEXT(mId, level, xoffset, yoffset, zoffset, width, height, depth, commit ? GL_TRUE : GL_FALSE);
+		return;
+	}
+
+	// ARB_sparse_texture alone only has glTexPageCommitmentARB, which works
+	// on the texture bound to the active unit.
+	GLint target;
+	GLenum binding;
+	getParameter(GL_TEXTURE_TARGET, &target);
+	switch (target) {
+	case GL_TEXTURE_2D_ARRAY: binding = GL_TEXTURE_BINDING_2D_ARRAY; break;
+	case GL_TEXTURE_3D: binding = GL_TEXTURE_BINDING_3D; break;
+	case GL_TEXTURE_CUBE_MAP: binding = GL_TEXTURE_BINDING_CUBE_MAP; break;
+	case GL_TEXTURE_CUBE_MAP_ARRAY: binding = GL_TEXTURE_BINDING_CUBE_MAP_ARRAY; break;
+	case GL_TEXTURE_RECTANGLE: binding = GL_TEXTURE_BINDING_RECTANGLE; break;
+	default: binding = GL_TEXTURE_BINDING_2D; break;
+	}
+	GLint previous;
+	glGetIntegerv(binding, &previous);
+	glBindTexture(target, mId);
+	glTexPageCommitmentARB(target, level, xoffset, yoffset, zoffset, width, height, depth, commit ? GL_TRUE : GL_FALSE);
+	glBindTexture(target, previous);
+}
+
 inline void Texture::getImage(GLint level, GLenum format, GLenum type, GLsizei bufSize, GLvoid *pixels) const
 {
 	glGetTextureImage(mId, level, format, type, bufSize, pixels);
@@ -237,6 +288,16 @@ inline void Texture::setParameterI(GLenum pname, const GLuint *params)
 	glTextureParameterIuiv(mId, pname, params);
 }
 
+inline void Texture::getParameter(GLenum pname, GLint *params) const
+{
+	glGetTextureParameteriv(mId, pname, params);
+}
+
+inline void Texture::getLevelParameter(GLint level, GLenum pname, GLint *params) const
+{
+	glGetTextureLevelParameteriv(mId, level, pname, params);
+}
+
 inline void Texture::generateMipmap()
 {
 	glGenerateTextureMipmap(mId);
@@ -0,0 +1,325 @@
+#ifndef GTL_OGL_TEXTUREATLAS_H
+#define GTL_OGL_TEXTUREATLAS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "gtl/ogl/openglexception.h"
+#include "gtl/ogl/rectpacker.h"
+#include "gtl/ogl/texture.h"
+
+
+namespace gtl {
+namespace ogl {
+
+// Packs many small images into the layers of one T_2D_ARRAY texture, so they
+// can be drawn without switching textures. Every image gets a cell with
+// `padding` texels on each side, filled by repeating its border texels, so
+// bilinear filtering does not bleed between neighbours. With mipmaps, cells
+// are aligned to 2^(levels - 1) texels, so every cell covers whole texels on
+// all levels. When no layer has room left, the number of layers is doubled;
+// this replaces the texture object, so re-fetch getTexture() after add().
+// The pixels passed to add() are read tightly packed, without row padding.
+class TextureAtlas final
+{
+public:
+	typedef std::uint32_t Handle;
+	static const Handle INVALID = 0xFFFFFFFFu;
+
+	struct Region {
+		GLint x;
+		GLint y;
+		GLint layer;
+		GLsizei width;
+		GLsizei height;
+	};
+
+	struct Stats {
+		std::uint64_t images;
+		std::uint64_t growths;
+		std::uint64_t usedTexels;
+		std::uint64_t totalTexels;
+
+		double getOccupancy() const noexcept;
+	};
+
+	TextureAtlas(GLenum internalformat, GLsizei size, GLsizei levels = 1, GLsizei padding = 1, GLsizei layers = 1);
+
+	Handle add(GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels);
+	void remove(Handle handle);
+	void generateMipmap();
+
+	const Region &getRegion(Handle handle) const noexcept;
+	glm::vec4 getUvRect(Handle handle) const noexcept;
+
+	const Texture &getTexture() const noexcept;
+	GLsizei getSize() const noexcept;
+	GLsizei getLayerCount() const noexcept;
+	Stats getStats() const noexcept;
+
+	static std::size_t getPixelSize(GLenum format, GLenum type);
+
+private:
+	struct Entry {
+		Region region;
+		RectPacker::Rect cell;
+		bool used;
+	};
+
+	TextureAtlas(const TextureAtlas &) = delete;
+	TextureAtlas &operator=(const TextureAtlas &) = delete;
+
+	void grow();
+	void upload(const Entry &entry, GLenum format, GLenum type, std::size_t pixelSize, const void *pixels);
+
+	Texture mTexture;
+	std::vector<RectPacker> mLayers;
+	std::vector<Entry> mEntries;
+	std::vector<Handle> mUnusedHandles;
+	std::vector<char> mScratch;
+	GLenum mInternalformat;
+	GLsizei mSize;
+	GLsizei mLevels;
+	GLsizei mPadding;
+	GLsizei mAlignment;
+	std::uint64_t mImages;
+	std::uint64_t mGrowths;
+
+};
+
+
+inline double TextureAtlas::Stats::getOccupancy() const noexcept
+{
+	return (totalTexels == 0) ? 0.0 : static_cast<double>(usedTexels) / totalTexels;
+}
+
+inline TextureAtlas::TextureAtlas(GLenum internalformat, GLsizei size, GLsizei levels, GLsizei padding, GLsizei layers) :
+	mInternalformat(internalformat),
+	mSize(size),
+	mLevels(levels),
+	mPadding(padding),
+	mAlignment(1),
+	mImages(0),
+	mGrowths(0)
+{
+	if (levels < 1 || levels > 31) {
+		throw OpenGLException("Invalid number of mipmap levels for the texture atlas");
+	}
+	mAlignment = 1 << (levels - 1);
+	mTexture.create(Texture::Target::T_2D_ARRAY);
+	mTexture.storage(mLevels, mInternalformat, mSize, mSize, layers);
+	mLayers.resize(layers, RectPacker(mSize, mSize));
+}
+
+inline TextureAtlas::Handle TextureAtlas::add(GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels)
+{
+	if (width <= 0 || height <= 0) {
+		throw OpenGLException("Image for the texture atlas is empty");
+	}
+	GLsizei cellWidth = (width + 2 * mPadding + mAlignment - 1) / mAlignment * mAlignment;
+	GLsizei cellHeight = (height + 2 * mPadding + mAlignment - 1) / mAlignment * mAlignment;
+	if (cellWidth > mSize || cellHeight > mSize) {
+		throw OpenGLException("Image does not fit into the texture atlas");
+	}
+	std::size_t pixelSize = getPixelSize(format, type);
+
+	Entry entry;
+	entry.used = true;
+	for (std::size_t layer = 0; ; ++layer) {
+		if (layer == mLayers.size()) {
+			grow();
+		}
+		if (mLayers[layer].insert(cellWidth, cellHeight, entry.cell)) {
+			entry.region.layer = static_cast<GLint>(layer);
+			break;
+		}
+	}
+	entry.region.x = entry.cell.x + mPadding;
+	entry.region.y = entry.cell.y + mPadding;
+	entry.region.width = width;
+	entry.region.height = height;
+	upload(entry, format, type, pixelSize, pixels);
+
+	Handle handle;
+	if (mUnusedHandles.empty()) {
+		handle = static_cast<Handle>(mEntries.size());
+		mEntries.push_back(entry);
+	} else {
+		handle = mUnusedHandles.back();
+		mUnusedHandles.pop_back();
+		mEntries[handle] = entry;
+	}
+	++mImages;
+	return handle;
+}
+
+inline void TextureAtlas::remove(Handle handle)
+{
+	// Removing twice would free the cell and the handle twice.
+	if (handle >= mEntries.size() || !mEntries[handle].used) {
+		return;
+	}
+	Entry &entry = mEntries[handle];
+	mLayers[entry.region.layer].remove(entry.cell);
+	entry.used = false;
+	mUnusedHandles.push_back(handle);
+	--mImages;
+}
+
+inline void TextureAtlas::generateMipmap()
+{
+	mTexture.generateMipmap();
+}
+
+inline const TextureAtlas::Region &TextureAtlas::getRegion(Handle handle) const noexcept
+{
+	return mEntries[handle].region;
+}
+
+inline glm::vec4 TextureAtlas::getUvRect(Handle handle) const noexcept
+{
+	const Region &region = mEntries[handle].region;
+	float scale = 1.0f / mSize;
+	return glm::vec4(region.x * scale, region.y * scale, (region.x + region.width) * scale, (region.y + region.height) * scale);
+}
+
+inline const Texture &TextureAtlas::getTexture() const noexcept
+{
+	return mTexture;
+}
+
+inline GLsizei TextureAtlas::getSize() const noexcept
+{
+	return mSize;
+}
+
+inline GLsizei TextureAtlas::getLayerCount() const noexcept
+{
+	return static_cast<GLsizei>(mLayers.size());
+}
+
+inline TextureAtlas::Stats TextureAtlas::getStats() const noexcept
+{
+	Stats stats = { mImages, mGrowths, 0, 0 };
+	for (const RectPacker &layer : mLayers) {
+		stats.usedTexels += layer.getUsedArea();
+		stats.totalTexels += static_cast<std::uint64_t>(mSize) * mSize;
+	}
+	return stats;
+}
+
+inline std::size_t TextureAtlas::getPixelSize(GLenum format, GLenum type)
+{
+	switch (type) {
+	case GL_UNSIGNED_BYTE_3_3_2:
+	case GL_UNSIGNED_BYTE_2_3_3_REV:
+		return 1;
+	case GL_UNSIGNED_SHORT_5_6_5:
+	case GL_UNSIGNED_SHORT_5_6_5_REV:
+	case GL_UNSIGNED_SHORT_4_4_4_4:
+	case GL_UNSIGNED_SHORT_4_4_4_4_REV:
+	case GL_UNSIGNED_SHORT_5_5_5_1:
+	case GL_UNSIGNED_SHORT_1_5_5_5_REV:
+		return 2;
+	case GL_UNSIGNED_INT_8_8_8_8:
+	case GL_UNSIGNED_INT_8_8_8_8_REV:
+	case GL_UNSIGNED_INT_10_10_10_2:
+	case GL_UNSIGNED_INT_2_10_10_10_REV:
+	case GL_UNSIGNED_INT_10F_11F_11F_REV:
+	case GL_UNSIGNED_INT_5_9_9_9_REV:
+		return 4;
+	}
+
+	std::size_t components;
+	switch (format) {
+	case GL_RED: case GL_GREEN: case GL_BLUE:
+	case GL_RED_INTEGER: case GL_GREEN_INTEGER: case GL_BLUE_INTEGER:
+		components = 1;
+		break;
+	case GL_RG: case GL_RG_INTEGER:
+		components = 2;
+		break;
+	case GL_RGB: case GL_BGR: case GL_RGB_INTEGER: case GL_BGR_INTEGER:
+		components = 3;
+		break;
+	case GL_RGBA: case GL_BGRA: case GL_RGBA_INTEGER: case GL_BGRA_INTEGER:
+		components = 4;
+		break;
+	default:
+		throw OpenGLException("Unsupported pixel format for the texture atlas");
+	}
+	switch (type) {
+	case GL_UNSIGNED_BYTE: case GL_BYTE:
+		return components;
+	case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT:
+		return components * 2;
+	case GL_UNSIGNED_INT: case GL_INT: case GL_FLOAT:
+		return components * 4;
+	default:
+		throw OpenGLException("Unsupported pixel type for the texture atlas");
+	}
+}
+
+inline void TextureAtlas::grow()
+{
+	GLint maxLayers;
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+	GLsizei oldLayers = static_cast<GLsizei>(mLayers.size());
+	GLsizei newLayers = std::min<GLsizei>(oldLayers * 2, maxLayers);
+	if (newLayers <= oldLayers) {
+		throw OpenGLException("Texture atlas is full");
+	}
+
+	Texture texture(Texture::Target::T_2D_ARRAY);
+	texture.storage(mLevels, mInternalformat, mSize, mSize, newLayers);
+	for (GLint level = 0; level < mLevels; ++level) {
+		GLsizei size = std::max<GLsizei>(mSize >> level, 1);
+		glCopyImageSubData(mTexture.get(), GL_TEXTURE_2D_ARRAY, level, 0, 0, 0,
+			texture.get(), GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, size, size, oldLayers);
+	}
+	mTexture = std::move(texture);
+	mLayers.resize(newLayers, RectPacker(mSize, mSize));
+	++mGrowths;
+}
+
+inline void TextureAtlas::upload(const Entry &entry, GLenum format, GLenum type, std::size_t pixelSize, const void *pixels)
+{
+	// The image is copied into its cell with the border texels repeated, so
+	// the whole cell is written with one call.
+	const RectPacker::Rect &cell = entry.cell;
+	const Region &region = entry.region;
+	std::size_t rowSize = region.width * pixelSize;
+	mScratch.resize(cell.width * cell.height * pixelSize);
+
+	const char *source = static_cast<const char*>(pixels);
+	for (GLsizei y = 0; y < cell.height; ++y) {
+		GLsizei sourceY = std::min(std::max<GLsizei>(y - mPadding, 0), region.height - 1);
+		const char *sourceRow = source + sourceY * rowSize;
+		char *row = mScratch.data() + y * cell.width * pixelSize;
+		for (GLsizei x = 0; x < mPadding; ++x) {
+			std::memcpy(row + x * pixelSize, sourceRow, pixelSize);
+		}
+		std::memcpy(row + mPadding * pixelSize, sourceRow, rowSize);
+		for (GLsizei x = mPadding + region.width; x < cell.width; ++x) {
+			std::memcpy(row + x * pixelSize, sourceRow + rowSize - pixelSize, pixelSize);
+		}
+	}
+
+	GLint alignment;
+	glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	mTexture.setSubImage(0, cell.x, cell.y, region.layer, cell.width, cell.height, 1, format, type, mScratch.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_TEXTUREATLAS_H
@@ -0,0 +1,330 @@
+#ifndef GTL_OGL_TEXTUREHANDLE_H
+#define GTL_OGL_TEXTUREHANDLE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "gtl/ogl/buffer.h"
+#include "gtl/ogl/openglexception.h"
+#include "gtl/ogl/texture.h"
+
+
+namespace gtl {
+namespace ogl {
+
+// Resident bindless handle of a texture, optionally combined with a sampler
+// (ARB_bindless_texture). The handle is resident while this object lives.
+// Once a handle was taken, the state of the texture and sampler can no longer
+// change, and both have to outlive the handle. The same texture and sampler
+// always give the same handle, which must not be made resident twice, so
+// share handles through a TextureHandleTable.
+class TextureHandle final
+{
+public:
+	TextureHandle() noexcept;
+	explicit TextureHandle(const Texture &texture);
+	TextureHandle(const Texture &texture, GLuint samplerName);
+	~TextureHandle() noexcept;
+
+	TextureHandle(TextureHandle &&other) noexcept;
+	TextureHandle &operator = (TextureHandle &&other) noexcept;
+	explicit operator bool () const noexcept;
+
+	void create(const Texture &texture);
+	void create(const Texture &texture, GLuint samplerName);
+	void create(GLuint64 handle);
+	void reset() noexcept;
+
+	GLuint64 get() const noexcept;
+
+	static bool isSupported();
+
+private:
+	TextureHandle(const TextureHandle &) = delete;
+	TextureHandle &operator=(const TextureHandle &) = delete;
+
+	GLuint64 mHandle;
+
+};
+
+
+// Table of resident texture handles in a shader storage buffer, so shaders
+// can pick the textures of a material by index instead of binding them to
+// units per draw. Adding the same texture and sampler again returns the same
+// index and only counts a reference, so every add() needs exactly one
+// remove(). Changes are uploaded by update(); when the capacity is exceeded,
+// the buffer is replaced, so bind() after update().
+class TextureHandleTable final
+{
+public:
+	typedef std::uint32_t Index;
+
+	struct Stats {
+		std::uint64_t uploadedBytes;
+		std::uint64_t growths;
+	};
+
+	explicit TextureHandleTable(std::size_t capacity = 256);
+
+	Index add(const Texture &texture);
+	Index add(const Texture &texture, GLuint samplerName);
+	void remove(Index index);
+
+	void update();
+	void bind(GLuint binding) const;
+
+	const Buffer &getBuffer() const noexcept;
+	std::size_t getResidentCount() const noexcept;
+
+	const Stats &getStats() const noexcept;
+	void resetStats() noexcept;
+
+	static std::string getSource(GLuint binding);
+
+private:
+	TextureHandleTable(const TextureHandleTable &) = delete;
+	TextureHandleTable &operator=(const TextureHandleTable &) = delete;
+
+	Index add(GLuint64 handle);
+	void markDirty(Index index) noexcept;
+
+	Buffer mBuffer;
+	std::size_t mCapacity;
+	std::vector<GLuint64> mHandles;
+	std::vector<TextureHandle> mResident;
+	std::vector<std::uint32_t> mReferences;
+	std::vector<Index> mUnusedIndices;
+	std::unordered_map<GLuint64, Index> mIndices;
+	std::size_t mDirtyBegin;
+	std::size_t mDirtyEnd;
+	Stats mStats;
+
+};
+
+
+inline TextureHandle::TextureHandle() noexcept :
+	mHandle(0)
+{
+}
+
+inline TextureHandle::TextureHandle(const Texture &texture) :
+	TextureHandle()
+{
+	create(texture);
+}
+
+inline TextureHandle::TextureHandle(const Texture &texture, GLuint samplerName) :
+	TextureHandle()
+{
+	create(texture, samplerName);
+}
+
+inline TextureHandle::~TextureHandle() noexcept
+{
+	reset();
+}
+
+inline TextureHandle::TextureHandle(TextureHandle &&other) noexcept :
+	mHandle(other.mHandle)
+{
+	other.mHandle = 0;
+}
+
+inline TextureHandle &TextureHandle::operator =(TextureHandle &&other) noexcept
+{
+	if (this != &other) {
+		reset();
+		mHandle = other.mHandle;
+		other.mHandle = 0;
+	}
+	return *this;
+}
+
+inline TextureHandle::operator bool() const noexcept
+{
+	return (mHandle != 0);
+}
+
+inline void TextureHandle::create(const Texture &texture)
+{
+	create(texture.getHandle());
+}
+
+inline void TextureHandle::create(const Texture &texture, GLuint samplerName)
+{
+	create(texture.getHandle(samplerName));
+}
+
+inline void TextureHandle::create(GLuint64 handle)
+{
+	reset();
+	if (handle == 0) {
+		throw OpenGLException("Could not get a bindless texture handle");
+	}
+	glMakeTextureHandleResidentARB(handle);
+	mHandle = handle;
+}
+
+inline void TextureHandle::reset() noexcept
+{
+	if (mHandle != 0) {
+		glMakeTextureHandleNonResidentARB(mHandle);
+	}
+	mHandle = 0;
+}
+
+inline GLuint64 TextureHandle::get() const noexcept
+{
+	return mHandle;
+}
+
+inline bool TextureHandle::isSupported()
+{
+	return GLEW_ARB_bindless_texture;
+}
+
+
+inline TextureHandleTable::TextureHandleTable(std::size_t capacity) :
+	mCapacity(capacity),
+	mDirtyBegin(0),
+	mDirtyEnd(0),
+	mStats()
+{
+	mBuffer.create();
+	mBuffer.storage(mCapacity * sizeof(GLuint64), nullptr, GL_DYNAMIC_STORAGE_BIT);
+}
+
+inline TextureHandleTable::Index TextureHandleTable::add(const Texture &texture)
+{
+	return add(texture.getHandle());
+}
+
+inline TextureHandleTable::Index TextureHandleTable::add(const Texture &texture, GLuint samplerName)
+{
+	return add(texture.getHandle(samplerName));
+}
+
+inline void TextureHandleTable::remove(Index index)
+{
+	// Removing a free index would wrap its reference count.
+	if (index >= mReferences.size() || mReferences[index] == 0) {
+		return;
+	}
+	if (--mReferences[index] != 0) {
+		return;
+	}
+	mIndices.erase(mHandles[index]);
+	mResident[index].reset();
+	mHandles[index] = 0;
+	mUnusedIndices.push_back(index);
+	markDirty(index);
+}
+
+inline void TextureHandleTable::update()
+{
+	if (mHandles.size() > mCapacity) {
+		while (mCapacity < mHandles.size()) {
+			mCapacity *= 2;
+		}
+		mBuffer.create();
+		mBuffer.storage(mCapacity * sizeof(GLuint64), nullptr, GL_DYNAMIC_STORAGE_BIT);
+		mDirtyBegin = 0;
+		mDirtyEnd = mHandles.size();
+		++mStats.growths;
+	}
+	if (mDirtyBegin < mDirtyEnd) {
+		GLsizeiptr size = (mDirtyEnd - mDirtyBegin) * sizeof(GLuint64);
+		mBuffer.setSubData(mDirtyBegin * sizeof(GLuint64), size, &mHandles[mDirtyBegin]);
+		mStats.uploadedBytes += size;
+	}
+	mDirtyBegin = 0;
+	mDirtyEnd = 0;
+}
+
+inline void TextureHandleTable::bind(GLuint binding) const
+{
+	mBuffer.bindBase(Buffer::Target::SHADER_STORAGE, binding);
+}
+
+inline const Buffer &TextureHandleTable::getBuffer() const noexcept
+{
+	return mBuffer;
+}
+
+inline std::size_t TextureHandleTable::getResidentCount() const noexcept
+{
+	return mIndices.size();
+}
+
+inline const TextureHandleTable::Stats &TextureHandleTable::getStats() const noexcept
+{
+	return mStats;
+}
+
+inline void TextureHandleTable::resetStats() noexcept
+{
+	mStats = Stats();
+}
+
+inline std::string TextureHandleTable::getSource(GLuint binding)
+{
+	// The program has to enable GL_ARB_bindless_texture. The index has to be
+	// dynamically uniform, e.g. taken from gl_DrawIDARB or a flat input
+	// which is the same for the whole draw.
+	return "layout(std430, binding = " + std::to_string(binding) + ") readonly buffer GtlTextureHandles {\n"
+		"\tuvec2 gtlTextureHandles[];\n"
+		"};\n"
+		"\n"
+		"#define gtlTexture(type, index) type(gtlTextureHandles[index])\n";
+}
+
+inline TextureHandleTable::Index TextureHandleTable::add(GLuint64 handle)
+{
+	auto it = mIndices.find(handle);
+	if (it != mIndices.end()) {
+		++mReferences[it->second];
+		return it->second;
+	}
+
+	TextureHandle resident;
+	resident.create(handle);
+
+	Index index;
+	if (mUnusedIndices.empty()) {
+		index = static_cast<Index>(mHandles.size());
+		mHandles.push_back(handle);
+		mResident.push_back(std::move(resident));
+		mReferences.push_back(1);
+	} else {
+		index = mUnusedIndices.back();
+		mUnusedIndices.pop_back();
+		mHandles[index] = handle;
+		mResident[index] = std::move(resident);
+		mReferences[index] = 1;
+	}
+	mIndices.emplace(handle, index);
+	markDirty(index);
+	return index;
+}
+
+inline void TextureHandleTable::markDirty(Index index) noexcept
+{
+	if (mDirtyBegin == mDirtyEnd) {
+		mDirtyBegin = index;
+		mDirtyEnd = index + 1;
+	} else {
+		mDirtyBegin = std::min<std::size_t>(mDirtyBegin, index);
+		mDirtyEnd = std::max<std::size_t>(mDirtyEnd, index + 1);
+	}
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_TEXTUREHANDLE_H
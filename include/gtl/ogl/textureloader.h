@@ -0,0 +1,723 @@
+#ifndef GTL_OGL_TEXTURELOADER_H
+#define GTL_OGL_TEXTURELOADER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "gtl/ogl/buffer.h"
+#include "gtl/ogl/mappedfile.h"
+#include "gtl/ogl/openglexception.h"
+#include "gtl/ogl/texture.h"
+
+
+namespace gtl {
+namespace ogl {
+
+// KTX2 or DDS file mapped into memory. open() validates the header and the
+// size of every image against the file and fails with a reason from
+// getError(); the image data is never copied. Supercompressed KTX2 files
+// and formats without a GL equivalent are rejected.
+class TextureFile final
+{
+public:
+	// Subresource of one mip level. Cube faces count as layers, so `layer`
+	// and `layers` address layer-faces; for 3D textures `depth` slices follow
+	// each other instead.
+	struct Image {
+		GLint level;
+		GLint layer;
+		GLsizei layers;
+		GLsizei width;
+		GLsizei height;
+		GLsizei depth;
+		std::size_t offset;
+		std::size_t size;
+	};
+
+	TextureFile() noexcept;
+	explicit TextureFile(const std::string &path);
+
+	TextureFile(TextureFile &&other) = default;
+	TextureFile &operator = (TextureFile &&other) = default;
+	explicit operator bool () const noexcept;
+
+	bool open(const std::string &path);
+	void close() noexcept;
+
+	Texture::Target getTarget() const noexcept;
+	GLenum getInternalFormat() const noexcept;
+	// Pixel format and type; 0 for compressed formats.
+	GLenum getFormat() const noexcept;
+	GLenum getType() const noexcept;
+	bool isCompressed() const noexcept;
+
+	GLsizei getWidth() const noexcept;
+	GLsizei getHeight() const noexcept;
+	GLsizei getDepth() const noexcept;
+	GLsizei getLevelCount() const noexcept;
+	GLsizei getLayerCount() const noexcept;
+	GLsizei getFaceCount() const noexcept;
+
+	const std::vector<Image> &getImages() const noexcept;
+	const void *getData() const noexcept;
+	std::size_t getSize() const noexcept;
+	const std::string &getError() const noexcept;
+
+private:
+	struct FormatInfo {
+		std::uint32_t code;
+		GLenum internalformat;
+		GLenum format;
+		GLenum type;
+		// Bytes per pixel, or per 4x4 block of compressed formats.
+		std::uint32_t bytes;
+	};
+
+	TextureFile(const TextureFile &) = delete;
+	TextureFile &operator=(const TextureFile &) = delete;
+
+	bool parseKtx2();
+	bool parseDds();
+	bool setFormat(const FormatInfo *formats, std::size_t count, std::uint32_t code);
+	bool setTarget(GLsizei width, GLsizei height, GLsizei depth, GLsizei layers, GLsizei faces, GLsizei levels);
+	bool fail(const std::string &error);
+	std::size_t getImageSize(GLsizei width, GLsizei height, GLsizei depth) const noexcept;
+	std::uint32_t read32(std::size_t offset) const noexcept;
+	std::uint64_t read64(std::size_t offset) const noexcept;
+
+	static const FormatInfo *getVulkanFormats(std::size_t &count) noexcept;
+	static const FormatInfo *getDxgiFormats(std::size_t &count) noexcept;
+
+	MappedFile mFile;
+	const std::uint8_t *mData;
+	std::size_t mSize;
+	Texture::Target mTarget;
+	FormatInfo mFormat;
+	GLsizei mWidth;
+	GLsizei mHeight;
+	GLsizei mDepth;
+	GLsizei mLevels;
+	GLsizei mLayers;
+	GLsizei mFaces;
+	std::vector<Image> mImages;
+	std::string mError;
+
+};
+
+// Creates textures from KTX2 and DDS files. Every image is uploaded straight
+// from the mapped file; with staging, the whole file is first copied into a
+// buffer by the driver and the images are uploaded from PIXEL_UNPACK
+// offsets, which avoids the synchronous copy in the upload calls.
+class TextureLoader final
+{
+public:
+	struct Stats {
+		std::uint64_t files;
+		std::uint64_t images;
+		std::uint64_t uploadedBytes;
+		std::chrono::nanoseconds elapsed;
+	};
+
+	explicit TextureLoader(bool staging = false);
+
+	Texture load(const std::string &path);
+	void load(const TextureFile &file, Texture &texture);
+
+	bool isStaging() const noexcept;
+	void setStaging(bool staging) noexcept;
+
+	const Stats &getStats() const noexcept;
+	void resetStats() noexcept;
+
+private:
+	TextureLoader(const TextureLoader &) = delete;
+	TextureLoader &operator=(const TextureLoader &) = delete;
+
+	static void upload(const TextureFile &file, Texture &texture, const TextureFile::Image &image, const void *data);
+
+	bool mStaging;
+	Stats mStats;
+
+};
+
+
+inline TextureFile::TextureFile() noexcept :
+	mData(nullptr),
+	mSize(0),
+	mTarget(Texture::Target::T_2D),
+	mFormat(),
+	mWidth(0),
+	mHeight(0),
+	mDepth(0),
+	mLevels(0),
+	mLayers(0),
+	mFaces(0)
+{
+}
+
+inline TextureFile::TextureFile(const std::string &path) :
+	TextureFile()
+{
+	open(path);
+}
+
+inline TextureFile::operator bool() const noexcept
+{
+	return static_cast<bool>(mFile);
+}
+
+inline bool TextureFile::open(const std::string &path)
+{
+	close();
+	if (!mFile.open(path)) {
+		return fail("Cannot map " + path);
+	}
+	mData = static_cast<const std::uint8_t*>(mFile.getData());
+	mSize = mFile.getSize();
+
+	static const std::uint8_t ktx2[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+	if (mSize >= sizeof(ktx2) && std::memcmp(mData, ktx2, sizeof(ktx2)) == 0) {
+		return parseKtx2();
+	}
+	if (mSize >= 4 && std::memcmp(mData, "DDS ", 4) == 0) {
+		return parseDds();
+	}
+	return fail("Neither a KTX2 nor a DDS file");
+}
+
+inline void TextureFile::close() noexcept
+{
+	mFile.close();
+	mData = nullptr;
+	mSize = 0;
+	mImages.clear();
+	mError.clear();
+}
+
+inline Texture::Target TextureFile::getTarget() const noexcept
+{
+	return mTarget;
+}
+
+inline GLenum TextureFile::getInternalFormat() const noexcept
+{
+	return mFormat.internalformat;
+}
+
+inline GLenum TextureFile::getFormat() const noexcept
+{
+	return mFormat.format;
+}
+
+inline GLenum TextureFile::getType() const noexcept
+{
+	return mFormat.type;
+}
+
+inline bool TextureFile::isCompressed() const noexcept
+{
+	return (mFormat.type == 0);
+}
+
+inline GLsizei TextureFile::getWidth() const noexcept
+{
+	return mWidth;
+}
+
+inline GLsizei TextureFile::getHeight() const noexcept
+{
+	return mHeight;
+}
+
+inline GLsizei TextureFile::getDepth() const noexcept
+{
+	return mDepth;
+}
+
+inline GLsizei TextureFile::getLevelCount() const noexcept
+{
+	return mLevels;
+}
+
+inline GLsizei TextureFile::getLayerCount() const noexcept
+{
+	return mLayers;
+}
+
+inline GLsizei TextureFile::getFaceCount() const noexcept
+{
+	return mFaces;
+}
+
+inline const std::vector<TextureFile::Image> &TextureFile::getImages() const noexcept
+{
+	return mImages;
+}
+
+inline const void *TextureFile::getData() const noexcept
+{
+	return mData;
+}
+
+inline std::size_t TextureFile::getSize() const noexcept
+{
+	return mSize;
+}
+
+inline const std::string &TextureFile::getError() const noexcept
+{
+	return mError;
+}
+
+inline bool TextureFile::parseKtx2()
+{
+	// Identifier, nine header words, the index and one level index entry.
+	if (mSize < 12 + 9 * 4 + 32 + 24) {
+		return fail("Truncated KTX2 header");
+	}
+	std::uint32_t vkFormat = read32(12);
+	GLsizei width = static_cast<GLsizei>(read32(20));
+	GLsizei height = static_cast<GLsizei>(read32(24));
+	GLsizei depth = static_cast<GLsizei>(read32(28));
+	GLsizei layers = static_cast<GLsizei>(read32(32));
+	GLsizei faces = static_cast<GLsizei>(read32(36));
+	GLsizei levels = std::max<GLsizei>(static_cast<GLsizei>(read32(40)), 1);
+	if (read32(44) != 0) {
+		return fail("Supercompressed KTX2 files are not supported");
+	}
+	std::size_t count;
+	const FormatInfo *formats = getVulkanFormats(count);
+	if (!setFormat(formats, count, vkFormat)) {
+		return fail("Unsupported KTX2 format " + std::to_string(vkFormat));
+	}
+	if (!setTarget(width, height, depth, layers, faces, levels)) {
+		return false;
+	}
+
+	// The level index follows the header; the data of a level holds all
+	// layers, faces and slices in that order without padding.
+	const std::size_t levelIndex = 12 + 9 * 4 + 32;
+	if (mSize < levelIndex + levels * 24u) {
+		return fail("Truncated KTX2 level index");
+	}
+	for (GLint level = 0; level < levels; ++level) {
+		std::uint64_t offset = read64(levelIndex + level * 24);
+		std::uint64_t size = read64(levelIndex + level * 24 + 8);
+		Image image;
+		image.level = level;
+		image.layer = 0;
+		image.layers = mLayers * mFaces;
+		image.width = std::max(mWidth >> level, 1);
+		image.height = std::max(mHeight >> level, 1);
+		image.depth = std::max(mDepth >> level, 1);
+		image.offset = static_cast<std::size_t>(offset);
+		image.size = getImageSize(image.width, image.height, image.depth) * image.layers;
+		if (size != image.size) {
+			return fail("Wrong size of KTX2 level " + std::to_string(level));
+		}
+		if (offset > mSize || mSize - offset < size) {
+			return fail("KTX2 level " + std::to_string(level) + " exceeds the file");
+		}
+		mImages.push_back(image);
+	}
+	return true;
+}
+
+inline bool TextureFile::parseDds()
+{
+	// Magic and the 124 byte header.
+	if (mSize < 128 || read32(4) != 124) {
+		return fail("Truncated DDS header");
+	}
+	const std::uint32_t FOURCC = 0x4;
+	const std::uint32_t RGB = 0x40;
+	const std::uint32_t LUMINANCE = 0x20000;
+	const std::uint32_t CUBEMAP = 0x200;
+	const std::uint32_t VOLUME = 0x200000;
+	const std::uint32_t DX10_CUBE = 0x4;
+
+	GLsizei height = static_cast<GLsizei>(read32(12));
+	GLsizei width = static_cast<GLsizei>(read32(16));
+	GLsizei depth = static_cast<GLsizei>(read32(24));
+	GLsizei levels = std::max<GLsizei>(static_cast<GLsizei>(read32(28)), 1);
+	std::uint32_t flags = read32(80);
+	std::uint32_t fourCC = read32(84);
+	std::uint32_t caps2 = read32(112);
+	GLsizei layers = 0;
+	GLsizei faces = (caps2 & CUBEMAP) ? 6 : 1;
+	if ((caps2 & VOLUME) == 0) {
+		depth = 0;
+	}
+
+	std::size_t count;
+	const FormatInfo *formats = getDxgiFormats(count);
+	std::uint32_t dxgiFormat = 0;
+	std::size_t offset = 128;
+	if ((flags & FOURCC) && fourCC == 0x30315844u) {
+		// "DX10": an extended header with the DXGI format follows.
+		if (mSize < 148) {
+			return fail("Truncated DDS DX10 header");
+		}
+		dxgiFormat = read32(128);
+		faces = (read32(136) & DX10_CUBE) ? 6 : 1;
+		layers = static_cast<GLsizei>(read32(140));
+		layers = (layers > 1) ? layers : 0;
+		offset = 148;
+	} else if (flags & FOURCC) {
+		switch (fourCC) {
+		case 0x31545844u: dxgiFormat = 71; break; // DXT1
+		case 0x33545844u: dxgiFormat = 74; break; // DXT3
+		case 0x35545844u: dxgiFormat = 77; break; // DXT5
+		case 0x31495441u: dxgiFormat = 80; break; // ATI1
+		case 0x55344342u: dxgiFormat = 80; break; // BC4U
+		case 0x53344342u: dxgiFormat = 81; break; // BC4S
+		case 0x32495441u: dxgiFormat = 83; break; // ATI2
+		case 0x55354342u: dxgiFormat = 83; break; // BC5U
+		case 0x53354342u: dxgiFormat = 84; break; // BC5S
+		case 113: dxgiFormat = 10; break; // D3DFMT_A16B16G16R16F
+		case 116: dxgiFormat = 2; break; // D3DFMT_A32B32G32R32F
+		}
+	} else if ((flags & RGB) && read32(88) == 32) {
+		dxgiFormat = (read32(92) == 0xFFu) ? 28 : (read32(92) == 0xFF0000u) ? 87 : 0;
+	} else if ((flags & LUMINANCE) && read32(88) == 8) {
+		dxgiFormat = 61;
+	}
+	if (!setFormat(formats, count, dxgiFormat)) {
+		return fail("Unsupported DDS format");
+	}
+	if (!setTarget(width, height, depth, layers, faces, levels)) {
+		return false;
+	}
+
+	// Unlike KTX2, DDS stores the whole mip chain of a layer-face before the
+	// next one.
+	for (GLint layer = 0; layer < mLayers * mFaces; ++layer) {
+		for (GLint level = 0; level < mLevels; ++level) {
+			Image image;
+			image.level = level;
+			image.layer = layer;
+			image.layers = 1;
+			image.width = std::max(mWidth >> level, 1);
+			image.height = std::max(mHeight >> level, 1);
+			image.depth = std::max(mDepth >> level, 1);
+			image.offset = offset;
+			image.size = getImageSize(image.width, image.height, image.depth);
+			if (offset > mSize || mSize - offset < image.size) {
+				return fail("DDS image " + std::to_string(layer) + "/" + std::to_string(level) + " exceeds the file");
+			}
+			offset += image.size;
+			mImages.push_back(image);
+		}
+	}
+	return true;
+}
+
+inline bool TextureFile::setFormat(const FormatInfo *formats, std::size_t count, std::uint32_t code)
+{
+	for (std::size_t i = 0; i < count; ++i) {
+		if (formats[i].code == code) {
+			mFormat = formats[i];
+			return true;
+		}
+	}
+	return false;
+}
+
+inline bool TextureFile::setTarget(GLsizei width, GLsizei height, GLsizei depth, GLsizei layers, GLsizei faces, GLsizei levels)
+{
+	if (width <= 0 || height < 0 || depth < 0 || layers < 0) {
+		return fail("Invalid texture size");
+	}
+	if (faces != 1 && faces != 6) {
+		return fail("Invalid number of cube faces");
+	}
+	if (faces == 6 && (width != height || depth > 0)) {
+		return fail("Cube map faces have to be square and two-dimensional");
+	}
+	if (depth > 0 && (height == 0 || layers > 0)) {
+		return fail("3D textures cannot be one-dimensional or arrays");
+	}
+	if (isCompressed() && (height == 0 || depth > 0)) {
+		return fail("Compressed formats need two-dimensional images");
+	}
+	GLsizei extent = std::max(std::max(width, height), depth);
+	GLsizei maxLevels = 1;
+	while ((extent >> maxLevels) > 0) {
+		++maxLevels;
+	}
+	if (levels > maxLevels) {
+		return fail("Too many mip levels");
+	}
+
+	if (faces == 6) {
+		mTarget = (layers > 0) ? Texture::Target::T_CUBE_MAP_ARRAY : Texture::Target::T_CUBE_MAP;
+	} else if (depth > 0) {
+		mTarget = Texture::Target::T_3D;
+	} else if (height == 0) {
+		mTarget = (layers > 0) ? Texture::Target::T_1D_ARRAY : Texture::Target::T_1D;
+	} else {
+		mTarget = (layers > 0) ? Texture::Target::T_2D_ARRAY : Texture::Target::T_2D;
+	}
+	mWidth = width;
+	mHeight = std::max(height, 1);
+	mDepth = std::max(depth, 1);
+	mLayers = std::max(layers, 1);
+	mFaces = faces;
+	mLevels = levels;
+	return true;
+}
+
+inline bool TextureFile::fail(const std::string &error)
+{
+	mFile.close();
+	mData = nullptr;
+	mSize = 0;
+	mImages.clear();
+	mError = error;
+	return false;
+}
+
+inline std::size_t TextureFile::getImageSize(GLsizei width, GLsizei height, GLsizei depth) const noexcept
+{
+	if (isCompressed()) {
+		return static_cast<std::size_t>((width + 3) / 4) * ((height + 3) / 4) * depth * mFormat.bytes;
+	}
+	return static_cast<std::size_t>(width) * height * depth * mFormat.bytes;
+}
+
+inline std::uint32_t TextureFile::read32(std::size_t offset) const noexcept
+{
+	// Both containers are little endian, like the hosts GL runs on.
+	std::uint32_t value;
+	std::memcpy(&value, mData + offset, sizeof(value));
+	return value;
+}
+
+inline std::uint64_t TextureFile::read64(std::size_t offset) const noexcept
+{
+	std::uint64_t value;
+	std::memcpy(&value, mData + offset, sizeof(value));
+	return value;
+}
+
+inline const TextureFile::FormatInfo *TextureFile::getVulkanFormats(std::size_t &count) noexcept
+{
+	static const FormatInfo formats[] = {
+		{ 9, GL_R8, GL_RED, GL_UNSIGNED_BYTE, 1 },
+		{ 16, GL_RG8, GL_RG, GL_UNSIGNED_BYTE, 2 },
+		{ 37, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4 },
+		{ 43, GL_SRGB8_ALPHA8, GL_RGBA, GL_UNSIGNED_BYTE, 4 },
+		{ 44, GL_RGBA8, GL_BGRA, GL_UNSIGNED_BYTE, 4 },
+		{ 50, GL_SRGB8_ALPHA8, GL_BGRA, GL_UNSIGNED_BYTE, 4 },
+		{ 64, GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, 4 },
+		{ 70, GL_R16, GL_RED, GL_UNSIGNED_SHORT, 2 },
+		{ 76, GL_R16F, GL_RED, GL_HALF_FLOAT, 2 },
+		{ 77, GL_RG16, GL_RG, GL_UNSIGNED_SHORT, 4 },
+		{ 83, GL_RG16F, GL_RG, GL_HALF_FLOAT, 4 },
+		{ 91, GL_RGBA16, GL_RGBA, GL_UNSIGNED_SHORT, 8 },
+		{ 97, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, 8 },
+		{ 100, GL_R32F, GL_RED, GL_FLOAT, 4 },
+		{ 103, GL_RG32F, GL_RG, GL_FLOAT, 8 },
+		{ 109, GL_RGBA32F, GL_RGBA, GL_FLOAT, 16 },
+		{ 122, GL_R11F_G11F_B10F, GL_RGB, GL_UNSIGNED_INT_10F_11F_11F_REV, 4 },
+		{ 123, GL_RGB9_E5, GL_RGB, GL_UNSIGNED_INT_5_9_9_9_REV, 4 },
+		{ 131, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 0, 0, 8 },
+		{ 132, GL_COMPRESSED_SRGB_S3TC_DXT1_EXT, 0, 0, 8 },
+		{ 133, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 0, 0, 8 },
+		{ 134, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT, 0, 0, 8 },
+		{ 135, GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, 0, 0, 16 },
+		{ 136, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT, 0, 0, 16 },
+		{ 137, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 0, 0, 16 },
+		{ 138, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, 0, 0, 16 },
+		{ 139, GL_COMPRESSED_RED_RGTC1, 0, 0, 8 },
+		{ 140, GL_COMPRESSED_SIGNED_RED_RGTC1, 0, 0, 8 },
+		{ 141, GL_COMPRESSED_RG_RGTC2, 0, 0, 16 },
+		{ 142, GL_COMPRESSED_SIGNED_RG_RGTC2, 0, 0, 16 },
+		{ 143, GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT, 0, 0, 16 },
+		{ 144, GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT, 0, 0, 16 },
+		{ 145, GL_COMPRESSED_RGBA_BPTC_UNORM, 0, 0, 16 },
+		{ 146, GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM, 0, 0, 16 },
+		{ 147, GL_COMPRESSED_RGB8_ETC2, 0, 0, 8 },
+		{ 148, GL_COMPRESSED_SRGB8_ETC2, 0, 0, 8 },
+		{ 149, GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2, 0, 0, 8 },
+		{ 150, GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2, 0, 0, 8 },
+		{ 151, GL_COMPRESSED_RGBA8_ETC2_EAC, 0, 0, 16 },
+		{ 152, GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC, 0, 0, 16 }
+	};
+	count = sizeof(formats) / sizeof(formats[0]);
+	return formats;
+}
+
+inline const TextureFile::FormatInfo *TextureFile::getDxgiFormats(std::size_t &count) noexcept
+{
+	static const FormatInfo formats[] = {
+		{ 2, GL_RGBA32F, GL_RGBA, GL_FLOAT, 16 },
+		{ 10, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, 8 },
+		{ 11, GL_RGBA16, GL_RGBA, GL_UNSIGNED_SHORT, 8 },
+		{ 16, GL_RG32F, GL_RG, GL_FLOAT, 8 },
+		{ 24, GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, 4 },
+		{ 26, GL_R11F_G11F_B10F, GL_RGB, GL_UNSIGNED_INT_10F_11F_11F_REV, 4 },
+		{ 28, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4 },
+		{ 29, GL_SRGB8_ALPHA8, GL_RGBA, GL_UNSIGNED_BYTE, 4 },
+		{ 34, GL_RG16F, GL_RG, GL_HALF_FLOAT, 4 },
+		{ 35, GL_RG16, GL_RG, GL_UNSIGNED_SHORT, 4 },
+		{ 41, GL_R32F, GL_RED, GL_FLOAT, 4 },
+		{ 49, GL_RG8, GL_RG, GL_UNSIGNED_BYTE, 2 },
+		{ 54, GL_R16F, GL_RED, GL_HALF_FLOAT, 2 },
+		{ 56, GL_R16, GL_RED, GL_UNSIGNED_SHORT, 2 },
+		{ 61, GL_R8, GL_RED, GL_UNSIGNED_BYTE, 1 },
+		{ 67, GL_RGB9_E5, GL_RGB, GL_UNSIGNED_INT_5_9_9_9_REV, 4 },
+		{ 71, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 0, 0, 8 },
+		{ 72, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT, 0, 0, 8 },
+		{ 74, GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, 0, 0, 16 },
+		{ 75, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT, 0, 0, 16 },
+		{ 77, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 0, 0, 16 },
+		{ 78, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, 0, 0, 16 },
+		{ 80, GL_COMPRESSED_RED_RGTC1, 0, 0, 8 },
+		{ 81, GL_COMPRESSED_SIGNED_RED_RGTC1, 0, 0, 8 },
+		{ 83, GL_COMPRESSED_RG_RGTC2, 0, 0, 16 },
+		{ 84, GL_COMPRESSED_SIGNED_RG_RGTC2, 0, 0, 16 },
+		{ 87, GL_RGBA8, GL_BGRA, GL_UNSIGNED_BYTE, 4 },
+		{ 91, GL_SRGB8_ALPHA8, GL_BGRA, GL_UNSIGNED_BYTE, 4 },
+		{ 95, GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT, 0, 0, 16 },
+		{ 96, GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT, 0, 0, 16 },
+		{ 98, GL_COMPRESSED_RGBA_BPTC_UNORM, 0, 0, 16 },
+		{ 99, GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM, 0, 0, 16 }
+	};
+	count = sizeof(formats) / sizeof(formats[0]);
+	return formats;
+}
+
+
+inline TextureLoader::TextureLoader(bool staging) :
+	mStaging(staging),
+	mStats()
+{
+}
+
+inline Texture TextureLoader::load(const std::string &path)
+{
+	TextureFile file(path);
+	if (!file) {
+		throw OpenGLException("Cannot load texture " + path + ": " + file.getError());
+	}
+	Texture texture;
+	load(file, texture);
+	return texture;
+}
+
+inline void TextureLoader::load(const TextureFile &file, Texture &texture)
+{
+	auto start = std::chrono::steady_clock::now();
+	texture.create(file.getTarget());
+	GLsizei layers = file.getLayerCount() * file.getFaceCount();
+	switch (file.getTarget()) {
+	case Texture::Target::T_1D:
+		texture.storage(file.getLevelCount(), file.getInternalFormat(), file.getWidth());
+		break;
+	case Texture::Target::T_1D_ARRAY:
+		texture.storage(file.getLevelCount(), file.getInternalFormat(), file.getWidth(), layers);
+		break;
+	case Texture::Target::T_2D:
+	case Texture::Target::T_CUBE_MAP:
+		texture.storage(file.getLevelCount(), file.getInternalFormat(), file.getWidth(), file.getHeight());
+		break;
+	case Texture::Target::T_3D:
+		texture.storage(file.getLevelCount(), file.getInternalFormat(), file.getWidth(), file.getHeight(), file.getDepth());
+		break;
+	default:
+		texture.storage(file.getLevelCount(), file.getInternalFormat(), file.getWidth(), file.getHeight(), layers);
+		break;
+	}
+
+	// Rows of both containers are tightly packed.
+	GLint alignment;
+	glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	if (mStaging) {
+		Buffer staging(true);
+		staging.storage(file.getSize(), file.getData(), 0);
+		staging.bind(Buffer::Target::PIXEL_UNPACK);
+		for (const TextureFile::Image &image : file.getImages()) {
+			upload(file, texture, image, reinterpret_cast<const void*>(image.offset));
+		}
+		staging.unbind(Buffer::Target::PIXEL_UNPACK);
+	} else {
+		const std::uint8_t *data = static_cast<const std::uint8_t*>(file.getData());
+		for (const TextureFile::Image &image : file.getImages()) {
+			upload(file, texture, image, data + image.offset);
+		}
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+
+	++mStats.files;
+	for (const TextureFile::Image &image : file.getImages()) {
+		++mStats.images;
+		mStats.uploadedBytes += image.size;
+	}
+	mStats.elapsed += std::chrono::steady_clock::now() - start;
+}
+
+inline bool TextureLoader::isStaging() const noexcept
+{
+	return mStaging;
+}
+
+inline void TextureLoader::setStaging(bool staging) noexcept
+{
+	mStaging = staging;
+}
+
+inline const TextureLoader::Stats &TextureLoader::getStats() const noexcept
+{
+	return mStats;
+}
+
+inline void TextureLoader::resetStats() noexcept
+{
+	mStats = Stats();
+}
+
+inline void TextureLoader::upload(const TextureFile &file, Texture &texture, const TextureFile::Image &image, const void *data)
+{
+	GLenum format = file.getInternalFormat();
+	GLsizei size = static_cast<GLsizei>(image.size);
+	bool compressed = file.isCompressed();
+	switch (file.getTarget()) {
+	case Texture::Target::T_1D:
+		texture.setSubImage(image.level, 0, image.width, file.getFormat(), file.getType(), data);
+		break;
+	case Texture::Target::T_1D_ARRAY:
+		texture.setSubImage(image.level, 0, image.layer, image.width, image.layers, file.getFormat(), file.getType(), data);
+		break;
+	case Texture::Target::T_2D:
+		if (compressed) {
+			texture.setCompressedSubImage(image.level, 0, 0, image.width, image.height, format, size, data);
+		} else {
+			texture.setSubImage(image.level, 0, 0, image.width, image.height, file.getFormat(), file.getType(), data);
+		}
+		break;
+	case Texture::Target::T_3D:
+		texture.setSubImage(image.level, 0, 0, 0, image.width, image.height, image.depth, file.getFormat(), file.getType(), data);
+		break;
+	default:
+		// Array layers and cube faces are both addressed as the z offset.
+		if (compressed) {
+			texture.setCompressedSubImage(image.level, 0, 0, image.layer, image.width, image.height, image.layers, format, size, data);
+		} else {
+			texture.setSubImage(image.level, 0, 0, image.layer, image.width, image.height, image.layers, file.getFormat(), file.getType(), data);
+		}
+		break;
+	}
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_TEXTURELOADER_H
@@ -0,0 +1,504 @@
+#ifndef GTL_OGL_TEXTURESTREAMER_H
+#define GTL_OGL_TEXTURESTREAMER_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "gtl/ogl/buffer.h"
+#include "gtl/ogl/openglexception.h"
+#include "gtl/ogl/rangeallocator.h"
+#include "gtl/ogl/sync.h"
+#include "gtl/ogl/texture.h"
+
+
+namespace gtl {
+namespace ogl {
+
+// Streams texture data through a persistently mapped PIXEL_UNPACK buffer.
+// Worker threads decode requests straight into ranges of the staging buffer
+// and update() uploads finished requests in priority order from buffer
+// offsets until the per-frame byte budget is used up. Requests with the same
+// priority upload smaller mip levels first. Staging ranges are reused once
+// the fence of the frame which read them has signaled. All member functions
+// have to be called on the thread which owns the context; only the decode
+// functions run on the workers.
+class TextureStreamer final
+{
+public:
+	typedef std::function<bool(void *data, std::size_t size)> Decoder;
+	typedef std::function<bool(GLint level, void *data, std::size_t size)> LevelDecoder;
+
+	struct Request {
+		Texture *texture;
+		GLint level;
+		GLint xoffset;
+		GLint yoffset;
+		GLint zoffset;
+		GLsizei width;
+		GLsizei height;
+		GLsizei depth;
+		// Selects the setSubImage overload: 1, 2 or 3.
+		GLuint dimensions;
+		// Pixel format and type; for compressed data the internal format and 0.
+		GLenum format;
+		GLenum type;
+		std::size_t size;
+		float priority;
+		Decoder decode;
+		// Called on the context thread after the upload was issued.
+		std::function<void()> uploaded;
+	};
+
+	struct Stats {
+		std::uint64_t submitted;
+		std::uint64_t uploaded;
+		std::uint64_t failed;
+		std::uint64_t cancelled;
+		std::uint64_t uploadedBytes;
+		std::uint64_t queueDepth;
+		std::chrono::nanoseconds totalLatency;
+		std::chrono::nanoseconds maxLatency;
+		std::chrono::nanoseconds elapsed;
+
+		std::chrono::nanoseconds getAverageLatency() const noexcept;
+		double getThroughput() const noexcept;
+	};
+
+	TextureStreamer(GLsizeiptr stagingSize, unsigned workerCount = 2, std::size_t budget = 16 * 1024 * 1024);
+	~TextureStreamer() noexcept;
+
+	void submit(const Request &request);
+	void submitMipChain(Texture &texture, GLsizei levels, GLsizei width, GLsizei height, GLenum format, GLenum type, std::size_t bytesPerPixel, const LevelDecoder &decode, float priority = 0.0f);
+	void cancel(const Texture &texture);
+	void update();
+
+	std::size_t getBudget() const noexcept;
+	void setBudget(std::size_t budget) noexcept;
+	std::size_t getQueueDepth() const noexcept;
+
+	Stats getStats() const;
+	void resetStats() noexcept;
+
+private:
+	struct Job {
+		Request request;
+		std::uint64_t sequence;
+		RangeAllocator::Handle range;
+		std::uint64_t offset;
+		std::chrono::steady_clock::time_point submitTime;
+		bool decoded;
+	};
+
+	struct Order {
+		bool operator () (const std::unique_ptr<Job> &a, const std::unique_ptr<Job> &b) const noexcept;
+	};
+
+	struct Frame {
+		Sync fence;
+		std::vector<RangeAllocator::Handle> ranges;
+	};
+
+	static const GLsizeiptr ALIGNMENT = 16;
+
+	TextureStreamer(const TextureStreamer &) = delete;
+	TextureStreamer &operator=(const TextureStreamer &) = delete;
+
+	void work();
+	void retire();
+	void dispatch();
+	void upload();
+	static void removeJobs(std::vector<std::unique_ptr<Job>> &jobs, const Texture *texture, std::vector<std::unique_ptr<Job>> &removed);
+
+	Buffer mStaging;
+	char *mData;
+	RangeAllocator mAllocator;
+	std::deque<Frame> mFrames;
+
+	std::vector<std::unique_ptr<Job>> mPending;
+	std::vector<std::unique_ptr<Job>> mReady;
+	std::uint64_t mSequence;
+	std::size_t mBudget;
+	std::size_t mInFlight;
+
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	std::deque<std::unique_ptr<Job>> mDecodeQueue;
+	std::vector<Job*> mDecoding;
+	std::vector<std::unique_ptr<Job>> mDecoded;
+	std::vector<std::thread> mWorkers;
+	bool mStop;
+
+	Stats mStats;
+	std::chrono::steady_clock::time_point mStatsStart;
+
+};
+
+
+inline std::chrono::nanoseconds TextureStreamer::Stats::getAverageLatency() const noexcept
+{
+	return (uploaded == 0) ? std::chrono::nanoseconds(0) : totalLatency / static_cast<std::chrono::nanoseconds::rep>(uploaded);
+}
+
+inline double TextureStreamer::Stats::getThroughput() const noexcept
+{
+	// Bytes per second.
+	return (elapsed.count() == 0) ? 0.0 : uploadedBytes * 1e9 / elapsed.count();
+}
+
+inline bool TextureStreamer::Order::operator ()(const std::unique_ptr<Job> &a, const std::unique_ptr<Job> &b) const noexcept
+{
+	// std::push_heap keeps the greatest element on top, so "less" means later.
+	if (a->request.priority != b->request.priority) {
+		return a->request.priority < b->request.priority;
+	}
+	if (a->request.level != b->request.level) {
+		return a->request.level < b->request.level;
+	}
+	return a->sequence > b->sequence;
+}
+
+inline TextureStreamer::TextureStreamer(GLsizeiptr stagingSize, unsigned workerCount, std::size_t budget) :
+	mData(nullptr),
+	mSequence(0),
+	mBudget(budget),
+	mInFlight(0),
+	mStop(false),
+	mStats(),
+	mStatsStart(std::chrono::steady_clock::now())
+{
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	mStaging.create();
+	mStaging.storage(stagingSize, nullptr, flags);
+	mData = static_cast<char*>(mStaging.map(0, stagingSize, flags));
+	if (mData == nullptr) {
+		throw OpenGLException("Cannot map texture staging buffer");
+	}
+	mAllocator.reset(stagingSize, ALIGNMENT);
+
+	for (unsigned i = 0; i < std::max(workerCount, 1u); ++i) {
+		mWorkers.emplace_back(&TextureStreamer::work, this);
+	}
+}
+
+inline TextureStreamer::~TextureStreamer() noexcept
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStop = true;
+	}
+	mCondition.notify_all();
+	for (std::thread &worker : mWorkers) {
+		worker.join();
+	}
+}
+
+inline void TextureStreamer::submit(const Request &request)
+{
+	// Anything larger would wait at the head of the queue forever.
+	if (request.size > mAllocator.getMaxAllocation(ALIGNMENT)) {
+		throw OpenGLException("Texture upload larger than the staging buffer");
+	}
+
+	std::unique_ptr<Job> job(new Job());
+	job->request = request;
+	job->sequence = mSequence++;
+	job->range = RangeAllocator::INVALID;
+	job->offset = 0;
+	job->submitTime = std::chrono::steady_clock::now();
+	job->decoded = false;
+	mPending.push_back(std::move(job));
+	std::push_heap(mPending.begin(), mPending.end(), Order());
+	++mStats.submitted;
+}
+
+inline void TextureStreamer::submitMipChain(Texture &texture, GLsizei levels, GLsizei width, GLsizei height, GLenum format, GLenum type, std::size_t bytesPerPixel, const LevelDecoder &decode, float priority)
+{
+	// Sampling is restricted to the levels which are complete from the mip
+	// tail on, so the texture sharpens while the finer levels arrive.
+	std::shared_ptr<std::vector<bool>> loaded = std::make_shared<std::vector<bool>>(levels, false);
+	Texture *target = &texture;
+	texture.setParameter(GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(levels - 1));
+	texture.setParameter(GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels - 1));
+
+	for (GLint level = levels - 1; level >= 0; --level) {
+		Request request;
+		request.texture = &texture;
+		request.level = level;
+		request.xoffset = request.yoffset = request.zoffset = 0;
+		request.width = std::max<GLsizei>(width >> level, 1);
+		request.height = std::max<GLsizei>(height >> level, 1);
+		request.depth = 1;
+		request.dimensions = 2;
+		request.format = format;
+		request.type = type;
+		request.size = static_cast<std::size_t>(request.width) * request.height * bytesPerPixel;
+		request.priority = priority;
+		request.decode = [decode, level](void *data, std::size_t size) {
+			return decode(level, data, size);
+		};
+		request.uploaded = [loaded, target, level]() {
+			(*loaded)[level] = true;
+			GLint base = static_cast<GLint>(loaded->size());
+			while (base > 0 && (*loaded)[base - 1]) {
+				--base;
+			}
+			if (base < static_cast<GLint>(loaded->size())) {
+				target->setParameter(GL_TEXTURE_BASE_LEVEL, base);
+			}
+		};
+		submit(request);
+	}
+}
+
+inline void TextureStreamer::cancel(const Texture &texture)
+{
+	std::vector<std::unique_ptr<Job>> removed;
+	removeJobs(mPending, &texture, removed);
+	removeJobs(mReady, &texture, removed);
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (auto it = mDecodeQueue.begin(); it != mDecodeQueue.end(); ) {
+			if ((*it)->request.texture == &texture) {
+				removed.push_back(std::move(*it));
+				it = mDecodeQueue.erase(it);
+			} else {
+				++it;
+			}
+		}
+		removeJobs(mDecoded, &texture, removed);
+		// Jobs which are being decoded are dropped once they come back.
+		for (Job *job : mDecoding) {
+			if (job->request.texture == &texture) {
+				job->request.texture = nullptr;
+			}
+		}
+	}
+
+	for (const std::unique_ptr<Job> &job : removed) {
+		if (job->range != RangeAllocator::INVALID) {
+			// The range was never read by the GPU.
+			mAllocator.free(job->range);
+			--mInFlight;
+		}
+		++mStats.cancelled;
+	}
+}
+
+inline void TextureStreamer::update()
+{
+	retire();
+	upload();
+	dispatch();
+}
+
+inline std::size_t TextureStreamer::getBudget() const noexcept
+{
+	return mBudget;
+}
+
+inline void TextureStreamer::setBudget(std::size_t budget) noexcept
+{
+	mBudget = budget;
+}
+
+inline std::size_t TextureStreamer::getQueueDepth() const noexcept
+{
+	return mPending.size() + mInFlight;
+}
+
+inline TextureStreamer::Stats TextureStreamer::getStats() const
+{
+	Stats stats = mStats;
+	stats.queueDepth = getQueueDepth();
+	stats.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - mStatsStart);
+	return stats;
+}
+
+inline void TextureStreamer::resetStats() noexcept
+{
+	mStats = Stats();
+	mStatsStart = std::chrono::steady_clock::now();
+}
+
+inline void TextureStreamer::work()
+{
+	for (;;) {
+		std::unique_ptr<Job> job;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCondition.wait(lock, [this]() { return mStop || !mDecodeQueue.empty(); });
+			if (mStop) {
+				return;
+			}
+			job = std::move(mDecodeQueue.front());
+			mDecodeQueue.pop_front();
+			mDecoding.push_back(job.get());
+		}
+
+		void *data = mData + job->offset;
+		bool decoded;
+		try {
+			decoded = job->request.decode(data, job->request.size);
+		} catch (...) {
+			decoded = false;
+		}
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		job->decoded = decoded;
+		mDecoding.erase(std::find(mDecoding.begin(), mDecoding.end(), job.get()));
+		mDecoded.push_back(std::move(job));
+	}
+}
+
+inline void TextureStreamer::retire()
+{
+	while (!mFrames.empty() && mFrames.front().fence.isSignaled()) {
+		for (RangeAllocator::Handle range : mFrames.front().ranges) {
+			mAllocator.free(range);
+		}
+		mFrames.pop_front();
+	}
+}
+
+inline void TextureStreamer::dispatch()
+{
+	bool dispatched = false;
+	while (!mPending.empty()) {
+		// Waiting for space keeps the order; smaller requests do not overtake.
+		Job &job = *mPending.front();
+		job.range = mAllocator.allocate(job.request.size, ALIGNMENT);
+		if (job.range == RangeAllocator::INVALID) {
+			break;
+		}
+		// The workers must not touch the allocator.
+		job.offset = mAllocator.getOffset(job.range);
+
+		std::pop_heap(mPending.begin(), mPending.end(), Order());
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mDecodeQueue.push_back(std::move(mPending.back()));
+		}
+		mPending.pop_back();
+		++mInFlight;
+		dispatched = true;
+	}
+	if (dispatched) {
+		mCondition.notify_all();
+	}
+}
+
+inline void TextureStreamer::upload()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (std::unique_ptr<Job> &job : mDecoded) {
+			mReady.push_back(std::move(job));
+			std::push_heap(mReady.begin(), mReady.end(), Order());
+		}
+		mDecoded.clear();
+	}
+
+	Frame frame;
+	std::size_t bytes = 0;
+	GLint alignment = 4;
+	auto now = std::chrono::steady_clock::now();
+	while (!mReady.empty() && (bytes == 0 || bytes + mReady.front()->request.size <= mBudget)) {
+		std::pop_heap(mReady.begin(), mReady.end(), Order());
+		std::unique_ptr<Job> job = std::move(mReady.back());
+		mReady.pop_back();
+		--mInFlight;
+
+		const Request &request = job->request;
+		if (request.texture == nullptr || !job->decoded) {
+			// Cancelled while decoding or failed; the GPU never saw the range.
+			mAllocator.free(job->range);
+			if (request.texture == nullptr) {
+				++mStats.cancelled;
+			} else {
+				++mStats.failed;
+			}
+			continue;
+		}
+
+		if (frame.ranges.empty()) {
+			mStaging.bind(Buffer::Target::PIXEL_UNPACK);
+			glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		}
+		const GLvoid *offset = reinterpret_cast<const GLvoid*>(static_cast<std::uintptr_t>(job->offset));
+		Texture &texture = *request.texture;
+		if (request.type == 0) {
+			GLsizei imageSize = static_cast<GLsizei>(request.size);
+			switch (request.dimensions) {
+			case 1:
+				texture.setCompressedSubImage(request.level, request.xoffset, request.width, request.format, imageSize, offset);
+				break;
+			case 2:
+				texture.setCompressedSubImage(request.level, request.xoffset, request.yoffset, request.width, request.height, request.format, imageSize, offset);
+				break;
+			default:
+				texture.setCompressedSubImage(request.level, request.xoffset, request.yoffset, request.zoffset, request.width, request.height, request.depth, request.format, imageSize, offset);
+				break;
+			}
+		} else {
+			switch (request.dimensions) {
+			case 1:
+				texture.setSubImage(request.level, request.xoffset, request.width, request.format, request.type, offset);
+				break;
+			case 2:
+				texture.setSubImage(request.level, request.xoffset, request.yoffset, request.width, request.height, request.format, request.type, offset);
+				break;
+			default:
+				texture.setSubImage(request.level, request.xoffset, request.yoffset, request.zoffset, request.width, request.height, request.depth, request.format, request.type, offset);
+				break;
+			}
+		}
+		if (request.uploaded) {
+			request.uploaded();
+		}
+
+		frame.ranges.push_back(job->range);
+		bytes += request.size;
+		++mStats.uploaded;
+		mStats.uploadedBytes += request.size;
+		auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(now - job->submitTime);
+		mStats.totalLatency += latency;
+		mStats.maxLatency = std::max(mStats.maxLatency, latency);
+	}
+
+	if (!frame.ranges.empty()) {
+		glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+		mStaging.unbind(Buffer::Target::PIXEL_UNPACK);
+		frame.fence.create();
+		mFrames.push_back(std::move(frame));
+	}
+}
+
+inline void TextureStreamer::removeJobs(std::vector<std::unique_ptr<Job>> &jobs, const Texture *texture, std::vector<std::unique_ptr<Job>> &removed)
+{
+	auto last = std::partition(jobs.begin(), jobs.end(), [texture](const std::unique_ptr<Job> &job) {
+		return job->request.texture != texture;
+	});
+	std::move(last, jobs.end(), std::back_inserter(removed));
+	jobs.erase(last, jobs.end());
+	// Removing from the middle breaks the heap order of pending and ready jobs.
+	std::make_heap(jobs.begin(), jobs.end(), Order());
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_TEXTURESTREAMER_H
@@ -0,0 +1,139 @@
+#ifndef GTL_OGL_UNIFORMSHADOW_H
+#define GTL_OGL_UNIFORMSHADOW_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GTL_OGL_UNIFORMSHADOW_SSE2
+#include <emmintrin.h>
+#endif
+
+#include <GL/glew.h>
+
+
+namespace gtl {
+namespace ogl {
+
+// CPU copy of the uniform values of a program, indexed by location. Used by
+// Program to skip uploads of values which are already set.
+class UniformShadow final
+{
+public:
+	struct Stats {
+		std::uint64_t issued;
+		std::uint64_t skipped;
+	};
+
+	UniformShadow() noexcept;
+
+	bool isEnabled() const noexcept;
+	void setEnabled(bool enabled);
+
+	bool update(GLint location, const void *value, std::size_t size);
+	void invalidate() noexcept;
+
+	const Stats &getStats() const noexcept;
+	void resetStats() noexcept;
+
+	static bool equal(const void *a, const void *b, std::size_t size) noexcept;
+
+private:
+	struct Slot {
+		std::uint32_t offset;
+		std::uint32_t size;
+	};
+
+	std::vector<Slot> mSlots;
+	std::vector<unsigned char> mValues;
+	bool mEnabled;
+	Stats mStats;
+
+};
+
+
+inline UniformShadow::UniformShadow() noexcept :
+	mEnabled(false),
+	mStats()
+{
+}
+
+inline bool UniformShadow::isEnabled() const noexcept
+{
+	return mEnabled;
+}
+
+inline void UniformShadow::setEnabled(bool enabled)
+{
+	mEnabled = enabled;
+	invalidate();
+}
+
+inline bool UniformShadow::update(GLint location, const void *value, std::size_t size)
+{
+	if (!mEnabled || location < 0) {
+		++mStats.issued;
+		return true;
+	}
+
+	if (static_cast<std::size_t>(location) >= mSlots.size()) {
+		Slot empty = { 0, 0 };
+		mSlots.resize(location + 1, empty);
+	}
+	Slot &slot = mSlots[location];
+	if (slot.size == size) {
+		if (equal(&mValues[slot.offset], value, size)) {
+			++mStats.skipped;
+			return false;
+		}
+	} else {
+		// First write to this location, or the type has changed.
+		slot.offset = static_cast<std::uint32_t>(mValues.size());
+		slot.size = static_cast<std::uint32_t>(size);
+		mValues.resize(mValues.size() + ((size + 15) & ~std::size_t(15)));
+	}
+	std::memcpy(&mValues[slot.offset], value, size);
+	++mStats.issued;
+	return true;
+}
+
+inline void UniformShadow::invalidate() noexcept
+{
+	mSlots.clear();
+	mValues.clear();
+}
+
+inline const UniformShadow::Stats &UniformShadow::getStats() const noexcept
+{
+	return mStats;
+}
+
+inline void UniformShadow::resetStats() noexcept
+{
+	mStats = Stats();
+}
+
+inline bool UniformShadow::equal(const void *a, const void *b, std::size_t size) noexcept
+{
+	const char *pa = static_cast<const char*>(a);
+	const char *pb = static_cast<const char*>(b);
+#ifdef GTL_OGL_UNIFORMSHADOW_SSE2
+	// Matrices are compared 16 bytes at a time without early exits.
+	__m128i same = _mm_set1_epi8(-1);
+	for (; size >= 16; size -= 16, pa += 16, pb += 16) {
+		__m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pa));
+		__m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pb));
+		same = _mm_and_si128(same, _mm_cmpeq_epi8(va, vb));
+	}
+	if (_mm_movemask_epi8(same) != 0xFFFF) {
+		return false;
+	}
+#endif
+	return std::memcmp(pa, pb, size) == 0;
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_UNIFORMSHADOW_H
@@ -0,0 +1,204 @@
+#ifndef GTL_OGL_UPLOADQUEUE_H
+#define GTL_OGL_UPLOADQUEUE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "gtl/ogl/buffer.h"
+#include "gtl/ogl/streambuffer.h"
+
+
+namespace gtl {
+namespace ogl {
+
+// Collects writes to buffers and submits them with as few copies as
+// possible. Writes to adjacent ranges of the same buffer are merged into a
+// single copy and overlapping writes keep the data of the latest one.
+// Destination buffers have to stay alive until the next flush().
+class UploadQueue final
+{
+public:
+	struct FlushStats {
+		std::uint64_t writes;
+		std::uint64_t enqueuedBytes;
+		std::uint64_t bytes;
+		std::uint64_t calls;
+	};
+
+	UploadQueue() noexcept;
+	explicit UploadQueue(GLsizeiptr stagingSize, GLuint stagingRegions = 2);
+
+	void create(GLsizeiptr stagingSize, GLuint stagingRegions = 2);
+
+	void enqueue(Buffer &destination, GLintptr offset, GLsizeiptr size, const void *data);
+	bool empty() const noexcept;
+	FlushStats flush();
+
+	const FlushStats &getLastFlushStats() const noexcept;
+
+private:
+	struct Segment {
+		GLintptr end;
+		std::size_t source;
+	};
+	typedef std::map<GLintptr, Segment> SegmentMap;
+
+	struct Destination {
+		Buffer *buffer;
+		SegmentMap segments;
+	};
+
+	UploadQueue(const UploadQueue &) = delete;
+	UploadQueue &operator=(const UploadQueue &) = delete;
+
+	static void insert(SegmentMap &segments, GLintptr begin, GLintptr end, std::size_t source);
+
+	StreamBuffer mStaging;
+	std::vector<char> mData;
+	std::map<GLuint, Destination> mWrites;
+	std::uint64_t mWriteCount;
+	FlushStats mLastFlushStats;
+
+};
+
+
+inline UploadQueue::UploadQueue() noexcept :
+	mWriteCount(0),
+	mLastFlushStats()
+{
+}
+
+inline UploadQueue::UploadQueue(GLsizeiptr stagingSize, GLuint stagingRegions) :
+	UploadQueue()
+{
+	create(stagingSize, stagingRegions);
+}
+
+inline void UploadQueue::create(GLsizeiptr stagingSize, GLuint stagingRegions)
+{
+	mStaging.create(stagingSize, stagingRegions);
+}
+
+inline void UploadQueue::enqueue(Buffer &destination, GLintptr offset, GLsizeiptr size, const void *data)
+{
+	if (size <= 0) {
+		return;
+	}
+	std::size_t source = mData.size();
+	const char *bytes = static_cast<const char*>(data);
+	mData.insert(mData.end(), bytes, bytes + size);
+	Destination &entry = mWrites[destination.get()];
+	entry.buffer = &destination;
+	insert(entry.segments, offset, offset + size, source);
+	++mWriteCount;
+}
+
+inline bool UploadQueue::empty() const noexcept
+{
+	return mWrites.empty();
+}
+
+inline UploadQueue::FlushStats UploadQueue::flush()
+{
+	FlushStats stats = FlushStats();
+	stats.writes = mWriteCount;
+	stats.enqueuedBytes = mData.size();
+
+	const GLsizeiptr regionSize = mStaging.getRegionSize();
+	char *staging = nullptr;
+	GLsizeiptr used = regionSize;
+
+	for (auto &destination : mWrites) {
+		SegmentMap &segments = destination.second.segments;
+		auto it = segments.begin();
+		while (it != segments.end()) {
+			if (used == regionSize) {
+				if (staging != nullptr) {
+					mStaging.end();
+				}
+				staging = static_cast<char*>(mStaging.begin());
+				used = 0;
+			}
+
+			// Gather a run of adjacent segments into the staging region.
+			GLintptr writeOffset = it->first;
+			GLsizeiptr runSize = 0;
+			GLintptr position = it->first;
+			while (it != segments.end() && it->first == position && used + runSize < regionSize) {
+				GLsizeiptr length = it->second.end - it->first;
+				GLsizeiptr count = std::min(length, regionSize - used - runSize);
+				std::memcpy(staging + used + runSize, &mData[it->second.source], count);
+				runSize += count;
+				position += count;
+				if (count == length) {
+					++it;
+				} else {
+					// Continue the rest of this segment in the next region.
+					Segment rest = { it->second.end, it->second.source + static_cast<std::size_t>(count) };
+					auto next = std::next(it);
+					segments.erase(it);
+					it = segments.insert(next, std::make_pair(position, rest));
+				}
+			}
+
+			destination.second.buffer->copySubData(mStaging.getBuffer(), mStaging.getOffset() + used, writeOffset, runSize);
+			used += runSize;
+			stats.bytes += runSize;
+			++stats.calls;
+		}
+	}
+	if (staging != nullptr) {
+		mStaging.end();
+	}
+
+	mData.clear();
+	mWrites.clear();
+	mWriteCount = 0;
+	mLastFlushStats = stats;
+	return stats;
+}
+
+inline const UploadQueue::FlushStats &UploadQueue::getLastFlushStats() const noexcept
+{
+	return mLastFlushStats;
+}
+
+inline void UploadQueue::insert(SegmentMap &segments, GLintptr begin, GLintptr end, std::size_t source)
+{
+	auto it = segments.lower_bound(begin);
+	if (it != segments.begin()) {
+		auto prev = std::prev(it);
+		if (prev->second.end > begin) {
+			if (prev->second.end > end) {
+				Segment rest = { prev->second.end, prev->second.source + static_cast<std::size_t>(end - prev->first) };
+				segments.insert(it, std::make_pair(end, rest));
+			}
+			prev->second.end = begin;
+		}
+	}
+
+	it = segments.lower_bound(begin);
+	while (it != segments.end() && it->first < end) {
+		if (it->second.end > end) {
+			Segment rest = { it->second.end, it->second.source + static_cast<std::size_t>(end - it->first) };
+			it = segments.erase(it);
+			segments.insert(it, std::make_pair(end, rest));
+			break;
+		}
+		it = segments.erase(it);
+	}
+
+	Segment segment = { end, source };
+	segments.insert(std::make_pair(begin, segment));
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_UPLOADQUEUE_H
@@ -0,0 +1,506 @@
+#ifndef GTL_OGL_VERTEXFORMAT_H
+#define GTL_OGL_VERTEXFORMAT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "gtl/ogl/buffer.h"
+#include "gtl/ogl/hasher.h"
+#include "gtl/ogl/openglexception.h"
+#include "gtl/ogl/vertexarray.h"
+
+
+namespace gtl {
+namespace ogl {
+
+// Describes how a scalar C++ type maps to the type parameter of
+// glVertexAttribFormat().
+template <class C>
+struct VertexComponentType
+{
+	static_assert(sizeof(C) == 0, "Type is not supported as vertex attribute component");
+};
+
+template <GLenum Type, bool Integer>
+struct VertexComponentTypeBase
+{
+	static const GLenum type = Type;
+	static const bool isInteger = Integer;
+};
+
+template <> struct VertexComponentType<GLbyte> : VertexComponentTypeBase<GL_BYTE, true> {};
+template <> struct VertexComponentType<GLubyte> : VertexComponentTypeBase<GL_UNSIGNED_BYTE, true> {};
+template <> struct VertexComponentType<GLshort> : VertexComponentTypeBase<GL_SHORT, true> {};
+template <> struct VertexComponentType<GLushort> : VertexComponentTypeBase<GL_UNSIGNED_SHORT, true> {};
+template <> struct VertexComponentType<GLint> : VertexComponentTypeBase<GL_INT, true> {};
+template <> struct VertexComponentType<GLuint> : VertexComponentTypeBase<GL_UNSIGNED_INT, true> {};
+template <> struct VertexComponentType<GLfloat> : VertexComponentTypeBase<GL_FLOAT, false> {};
+template <> struct VertexComponentType<GLdouble> : VertexComponentTypeBase<GL_DOUBLE, false> {};
+
+// Describes how the type of a vertex struct member maps to an attribute.
+// Scalars, arrays of up to four scalars and the glm vectors are supported.
+template <class T>
+struct VertexMemberType
+{
+	typedef T Component;
+	static const GLint size = 1;
+};
+
+template <class C, GLint Size>
+struct VertexMemberTypeBase
+{
+	typedef C Component;
+	static const GLint size = Size;
+};
+
+template <class C, std::size_t N>
+struct VertexMemberType<C[N]> : VertexMemberTypeBase<C, static_cast<GLint>(N)>
+{
+	static_assert(N >= 1 && N <= 4, "Vertex attributes have one to four components");
+};
+
+template <> struct VertexMemberType<glm::vec2> : VertexMemberTypeBase<GLfloat, 2> {};
+template <> struct VertexMemberType<glm::vec3> : VertexMemberTypeBase<GLfloat, 3> {};
+template <> struct VertexMemberType<glm::vec4> : VertexMemberTypeBase<GLfloat, 4> {};
+template <> struct VertexMemberType<glm::ivec2> : VertexMemberTypeBase<GLint, 2> {};
+template <> struct VertexMemberType<glm::ivec3> : VertexMemberTypeBase<GLint, 3> {};
+template <> struct VertexMemberType<glm::ivec4> : VertexMemberTypeBase<GLint, 4> {};
+template <> struct VertexMemberType<glm::uvec2> : VertexMemberTypeBase<GLuint, 2> {};
+template <> struct VertexMemberType<glm::uvec3> : VertexMemberTypeBase<GLuint, 3> {};
+template <> struct VertexMemberType<glm::uvec4> : VertexMemberTypeBase<GLuint, 4> {};
+
+struct VertexAttrib {
+	// How the shader sees the values: converted to float as they are,
+	// normalized to [0, 1] or [-1, 1], as integers or as doubles.
+	enum class Kind {
+		FLOAT,
+		NORMALIZED,
+		INTEGER,
+		DOUBLE
+	};
+
+	GLuint location;
+	GLuint binding;
+	GLint size;
+	GLenum type;
+	Kind kind;
+	GLuint offset;
+};
+
+struct VertexBinding {
+	GLuint index;
+	GLsizei stride;
+	GLuint divisor;
+};
+
+// Vertex layout declared next to the vertex struct it describes. Types,
+// sizes, offsets and strides are derived from member pointers:
+//
+//     struct Vertex { glm::vec3 position; GLshort normal[4]; GLubyte color[4]; };
+//     const VertexFormat format = VertexFormat()
+//         .add(0, &Vertex::position)
+//         .addNormalized(1, &Vertex::normal)
+//         .addNormalized(2, &Vertex::color);
+//
+// Attributes are kept sorted by location, so the declaration order does not
+// change the hash or the comparison.
+class VertexFormat final
+{
+public:
+	VertexFormat() noexcept;
+
+	template <class V, class T>
+	VertexFormat &add(GLuint location, T V::*member, GLuint binding = 0);
+	template <class V, class T>
+	VertexFormat &addNormalized(GLuint location, T V::*member, GLuint binding = 0);
+	template <class V, class T>
+	VertexFormat &addInteger(GLuint location, T V::*member, GLuint binding = 0);
+	// For members whose type does not tell the format, e.g. half floats in a
+	// GLushort[2] or GL_INT_2_10_10_10_REV in a GLuint.
+	template <class V, class T>
+	VertexFormat &add(GLuint location, T V::*member, GLint size, GLenum type, VertexAttrib::Kind kind, GLuint binding = 0);
+	VertexFormat &setDivisor(GLuint binding, GLuint divisor);
+
+	const std::vector<VertexAttrib> &getAttribs() const noexcept;
+	const std::vector<VertexBinding> &getBindings() const noexcept;
+	GLsizei getStride(GLuint binding = 0) const noexcept;
+	std::uint64_t getHash() const noexcept;
+
+	void apply(VertexArray &vertexArray) const;
+
+	bool operator == (const VertexFormat &other) const noexcept;
+	bool operator != (const VertexFormat &other) const noexcept;
+
+private:
+	template <class V, class T>
+	static GLuint getOffset(T V::*member) noexcept;
+
+	void addAttrib(const VertexAttrib &attrib, GLsizei stride);
+	void updateHash() noexcept;
+
+	std::vector<VertexAttrib> mAttribs;
+	std::vector<VertexBinding> mBindings;
+	std::uint64_t mHash;
+
+};
+
+// Shares one vertex array per distinct VertexFormat, so that meshes with the
+// same layout only rebind their buffers instead of switching vertex arrays.
+// The cache remembers which vertex array and buffers are bound; call
+// invalidate() after binding vertex arrays or buffers of cached vertex arrays
+// without it.
+class VertexArrayCache final
+{
+public:
+	struct Stats {
+		std::uint64_t hits;
+		std::uint64_t misses;
+		std::uint64_t vertexArrayBinds;
+		std::uint64_t bufferBinds;
+	};
+
+	VertexArrayCache() noexcept;
+
+	const VertexArray &get(const VertexFormat &format);
+	// Binds the vertex array of the format with one buffer per binding of
+	// format.getBindings(), in that order. Offsets may be null.
+	void bind(const VertexFormat &format, const Buffer *buffers, const GLintptr *offsets = nullptr, const Buffer *elementArray = nullptr);
+	void bind(const VertexFormat &format, const Buffer &buffer, const Buffer *elementArray = nullptr);
+	void invalidate() noexcept;
+	void clear() noexcept;
+
+	std::size_t getSize() const noexcept;
+	const Stats &getStats() const noexcept;
+	void resetStats() noexcept;
+
+private:
+	struct Entry {
+		VertexArray vertexArray;
+		std::vector<GLuint> buffers;
+		std::vector<GLintptr> offsets;
+		GLuint elementArray;
+	};
+
+	struct Hash {
+		std::size_t operator () (const VertexFormat &format) const noexcept;
+	};
+
+	VertexArrayCache(const VertexArrayCache &) = delete;
+	VertexArrayCache &operator=(const VertexArrayCache &) = delete;
+
+	Entry &getEntry(const VertexFormat &format);
+
+	std::unordered_map<VertexFormat, Entry, Hash> mEntries;
+	GLuint mBound;
+	Stats mStats;
+
+};
+
+
+inline VertexFormat::VertexFormat() noexcept :
+	mHash(Hasher().getValue())
+{
+}
+
+template <class V, class T>
+inline VertexFormat &VertexFormat::add(GLuint location, T V::*member, GLuint binding)
+{
+	typedef VertexMemberType<T> Type;
+	typedef VertexComponentType<typename Type::Component> Component;
+
+	const VertexAttrib::Kind kind = (Component::type == GL_DOUBLE) ? VertexAttrib::Kind::DOUBLE : VertexAttrib::Kind::FLOAT;
+	return add(location, member, Type::size, Component::type, kind, binding);
+}
+
+template <class V, class T>
+inline VertexFormat &VertexFormat::addNormalized(GLuint location, T V::*member, GLuint binding)
+{
+	typedef VertexMemberType<T> Type;
+	typedef VertexComponentType<typename Type::Component> Component;
+	static_assert(Component::isInteger, "Only integer attributes can be normalized");
+
+	return add(location, member, Type::size, Component::type, VertexAttrib::Kind::NORMALIZED, binding);
+}
+
+template <class V, class T>
+inline VertexFormat &VertexFormat::addInteger(GLuint location, T V::*member, GLuint binding)
+{
+	typedef VertexMemberType<T> Type;
+	typedef VertexComponentType<typename Type::Component> Component;
+	static_assert(Component::isInteger, "Integer attributes need integer components");
+
+	return add(location, member, Type::size, Component::type, VertexAttrib::Kind::INTEGER, binding);
+}
+
+template <class V, class T>
+inline VertexFormat &VertexFormat::add(GLuint location, T V::*member, GLint size, GLenum type, VertexAttrib::Kind kind, GLuint binding)
+{
+	static_assert(std::is_standard_layout<V>::value, "Vertex structs must have standard layout");
+
+	VertexAttrib attrib;
+	attrib.location = location;
+	attrib.binding = binding;
+	attrib.size = size;
+	attrib.type = type;
+	attrib.kind = kind;
+	attrib.offset = getOffset(member);
+	addAttrib(attrib, static_cast<GLsizei>(sizeof(V)));
+	return *this;
+}
+
+inline VertexFormat &VertexFormat::setDivisor(GLuint binding, GLuint divisor)
+{
+	for (VertexBinding &b : mBindings) {
+		if (b.index == binding) {
+			b.divisor = divisor;
+			updateHash();
+			return *this;
+		}
+	}
+	throw OpenGLException("Vertex binding " + std::to_string(binding) + " has no attributes");
+}
+
+inline const std::vector<VertexAttrib> &VertexFormat::getAttribs() const noexcept
+{
+	return mAttribs;
+}
+
+inline const std::vector<VertexBinding> &VertexFormat::getBindings() const noexcept
+{
+	return mBindings;
+}
+
+inline GLsizei VertexFormat::getStride(GLuint binding) const noexcept
+{
+	for (const VertexBinding &b : mBindings) {
+		if (b.index == binding) {
+			return b.stride;
+		}
+	}
+	return 0;
+}
+
+inline std::uint64_t VertexFormat::getHash() const noexcept
+{
+	return mHash;
+}
+
+inline void VertexFormat::apply(VertexArray &vertexArray) const
+{
+	for (const VertexAttrib &attrib : mAttribs) {
+		vertexArray.enableAttrib(attrib.location);
+		switch (attrib.kind) {
+		case VertexAttrib::Kind::FLOAT:
+			vertexArray.setAttribFormat(attrib.location, attrib.size, attrib.type, GL_FALSE, attrib.offset);
+			break;
+		case VertexAttrib::Kind::NORMALIZED:
+			vertexArray.setAttribFormat(attrib.location, attrib.size, attrib.type, GL_TRUE, attrib.offset);
+			break;
+		case VertexAttrib::Kind::INTEGER:
+			vertexArray.setAttribIFormat(attrib.location, attrib.size, attrib.type, attrib.offset);
+			break;
+		case VertexAttrib::Kind::DOUBLE:
+			vertexArray.setAttribLFormat(attrib.location, attrib.size, attrib.type, attrib.offset);
+			break;
+		}
+		vertexArray.setAttribBinding(attrib.location, attrib.binding);
+	}
+	for (const VertexBinding &binding : mBindings) {
+		if (binding.divisor != 0) {
+			vertexArray.setBindingDivisor(binding.index, binding.divisor);
+		}
+	}
+}
+
+inline bool VertexFormat::operator ==(const VertexFormat &other) const noexcept
+{
+	if (mHash != other.mHash || mAttribs.size() != other.mAttribs.size() || mBindings.size() != other.mBindings.size()) {
+		return false;
+	}
+	for (std::size_t i = 0; i < mAttribs.size(); ++i) {
+		const VertexAttrib &a = mAttribs[i];
+		const VertexAttrib &b = other.mAttribs[i];
+		if (a.location != b.location || a.binding != b.binding || a.size != b.size
+			|| a.type != b.type || a.kind != b.kind || a.offset != b.offset) {
+			return false;
+		}
+	}
+	for (std::size_t i = 0; i < mBindings.size(); ++i) {
+		const VertexBinding &a = mBindings[i];
+		const VertexBinding &b = other.mBindings[i];
+		if (a.index != b.index || a.stride != b.stride || a.divisor != b.divisor) {
+			return false;
+		}
+	}
+	return true;
+}
+
+inline bool VertexFormat::operator !=(const VertexFormat &other) const noexcept
+{
+	return !(*this == other);
+}
+
+template <class V, class T>
+inline GLuint VertexFormat::getOffset(T V::*member) noexcept
+{
+	// Like offsetof(), but for member pointers. No V is constructed, only the
+	// address of the member within uninitialized storage is taken.
+	typename std::aligned_storage<sizeof(V), alignof(V)>::type storage;
+	const V *object = reinterpret_cast<const V*>(&storage);
+	const char *address = reinterpret_cast<const char*>(&(object->*member));
+	return static_cast<GLuint>(address - reinterpret_cast<const char*>(object));
+}
+
+inline void VertexFormat::addAttrib(const VertexAttrib &attrib, GLsizei stride)
+{
+	auto it = std::lower_bound(mAttribs.begin(), mAttribs.end(), attrib.location,
+		[](const VertexAttrib &a, GLuint location) { return a.location < location; });
+	if (it != mAttribs.end() && it->location == attrib.location) {
+		throw OpenGLException("Vertex attribute location " + std::to_string(attrib.location) + " is used twice");
+	}
+
+	auto b = std::lower_bound(mBindings.begin(), mBindings.end(), attrib.binding,
+		[](const VertexBinding &binding, GLuint index) { return binding.index < index; });
+	if (b == mBindings.end() || b->index != attrib.binding) {
+		VertexBinding binding;
+		binding.index = attrib.binding;
+		binding.stride = stride;
+		binding.divisor = 0;
+		mBindings.insert(b, binding);
+	} else if (b->stride != stride) {
+		throw OpenGLException("Vertex binding " + std::to_string(attrib.binding) + " is used by structs of different sizes");
+	}
+
+	mAttribs.insert(it, attrib);
+	updateHash();
+}
+
+inline void VertexFormat::updateHash() noexcept
+{
+	// Field by field, so that padding never takes part.
+	Hasher hasher;
+	for (const VertexAttrib &attrib : mAttribs) {
+		hasher.addValue(attrib.location).addValue(attrib.binding).addValue(attrib.size);
+		hasher.addValue(attrib.type).addValue(attrib.kind).addValue(attrib.offset);
+	}
+	for (const VertexBinding &binding : mBindings) {
+		hasher.addValue(binding.index).addValue(binding.stride).addValue(binding.divisor);
+	}
+	mHash = hasher.getValue();
+}
+
+inline VertexArrayCache::VertexArrayCache() noexcept :
+	mBound(0),
+	mStats()
+{
+}
+
+inline const VertexArray &VertexArrayCache::get(const VertexFormat &format)
+{
+	return getEntry(format).vertexArray;
+}
+
+inline void VertexArrayCache::bind(const VertexFormat &format, const Buffer *buffers, const GLintptr *offsets, const Buffer *elementArray)
+{
+	Entry &entry = getEntry(format);
+	const std::vector<VertexBinding> &bindings = format.getBindings();
+	for (std::size_t i = 0; i < bindings.size(); ++i) {
+		const GLuint buffer = buffers[i].get();
+		const GLintptr offset = (offsets != nullptr) ? offsets[i] : 0;
+		if (entry.buffers[i] != buffer || entry.offsets[i] != offset) {
+			entry.vertexArray.setVertexBuffer(bindings[i].index, buffers[i], offset, bindings[i].stride);
+			entry.buffers[i] = buffer;
+			entry.offsets[i] = offset;
+			++mStats.bufferBinds;
+		}
+	}
+
+	const GLuint elementName = (elementArray != nullptr) ? elementArray->get() : 0;
+	if (entry.elementArray != elementName) {
+		glVertexArrayElementBuffer(entry.vertexArray.get(), elementName);
+		entry.elementArray = elementName;
+		++mStats.bufferBinds;
+	}
+
+	if (mBound != entry.vertexArray.get()) {
+		entry.vertexArray.bind();
+		mBound = entry.vertexArray.get();
+		++mStats.vertexArrayBinds;
+	}
+}
+
+inline void VertexArrayCache::bind(const VertexFormat &format, const Buffer &buffer, const Buffer *elementArray)
+{
+	bind(format, &buffer, nullptr, elementArray);
+}
+
+inline void VertexArrayCache::invalidate() noexcept
+{
+	mBound = 0;
+	for (auto &it : mEntries) {
+		Entry &entry = it.second;
+		std::fill(entry.buffers.begin(), entry.buffers.end(), 0);
+		std::fill(entry.offsets.begin(), entry.offsets.end(), -1);
+		entry.elementArray = ~0u;
+	}
+}
+
+inline void VertexArrayCache::clear() noexcept
+{
+	mEntries.clear();
+	mBound = 0;
+}
+
+inline std::size_t VertexArrayCache::getSize() const noexcept
+{
+	return mEntries.size();
+}
+
+inline const VertexArrayCache::Stats &VertexArrayCache::getStats() const noexcept
+{
+	return mStats;
+}
+
+inline void VertexArrayCache::resetStats() noexcept
+{
+	mStats = Stats();
+}
+
+inline VertexArrayCache::Entry &VertexArrayCache::getEntry(const VertexFormat &format)
+{
+	auto it = mEntries.find(format);
+	if (it != mEntries.end()) {
+		++mStats.hits;
+		return it->second;
+	}
+
+	++mStats.misses;
+	Entry entry;
+	entry.vertexArray.create();
+	format.apply(entry.vertexArray);
+	// A fresh vertex array has no buffers, -1 never matches a real offset.
+	entry.buffers.assign(format.getBindings().size(), 0);
+	entry.offsets.assign(format.getBindings().size(), -1);
+	entry.elementArray = 0;
+	return mEntries.emplace(format, std::move(entry)).first->second;
+}
+
+inline std::size_t VertexArrayCache::Hash::operator ()(const VertexFormat &format) const noexcept
+{
+	return static_cast<std::size_t>(format.getHash());
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_VERTEXFORMAT_H
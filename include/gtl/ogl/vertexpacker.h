@@ -0,0 +1,736 @@
+#ifndef GTL_OGL_VERTEXPACKER_H
+#define GTL_OGL_VERTEXPACKER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GTL_OGL_VERTEXPACKER_SSE2
+#include <emmintrin.h>
+#endif
+
+// MSVC has no switch for F16C alone, but every AVX2 processor supports it.
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define GTL_OGL_VERTEXPACKER_F16C
+#include <immintrin.h>
+#endif
+
+#include <GL/glew.h>
+
+#include "gtl/ogl/openglexception.h"
+#include "gtl/ogl/vertexarray.h"
+
+
+namespace gtl {
+namespace ogl {
+
+// Converts float vertex attribute streams to smaller encodings and
+// interleaves them into one vertex buffer. Every attribute starts at a
+// multiple of four bytes. The shader sees the same values through the
+// normalized flag and type of getFormat(), except for OCTAHEDRAL, which
+// has to be decoded with gtlDecodeOctahedral() from getSource().
+// SNORM_2_10_10_10 suits tangents with the handedness in w; inputs with
+// three components get w = 1.
+class VertexPacker final
+{
+public:
+	enum class Encoding {
+		FLOAT,
+		HALF,
+		SNORM16,
+		UNORM16,
+		SNORM8,
+		UNORM8,
+		OCTAHEDRAL,
+		SNORM_2_10_10_10,
+		UNORM_2_10_10_10
+	};
+
+	// Parameters for VertexArray::setAttribFormat().
+	struct Format {
+		GLint size;
+		GLenum type;
+		GLboolean normalized;
+		GLsizei bytes;
+	};
+
+	// Differences between the input and the decoded output. Components
+	// outside the range of the encoding are clamped; they are counted, but
+	// left out of the errors.
+	struct Report {
+		double maxError;
+		double rmsError;
+		std::size_t clamped;
+	};
+
+	struct Stats {
+		std::uint64_t vertices;
+		std::uint64_t inputBytes;
+		std::uint64_t outputBytes;
+		std::chrono::nanoseconds elapsed;
+
+		// In MB of input per second.
+		double getThroughput() const noexcept;
+	};
+
+	VertexPacker() noexcept;
+
+	// data holds components floats per vertex, stride bytes apart; 0 means
+	// tightly packed. It has to stay valid until pack().
+	std::size_t addStream(GLuint location, Encoding encoding, const float *data, int components, std::size_t stride = 0);
+	void clear() noexcept;
+
+	GLsizei getStride() const noexcept;
+	GLuint getOffset(std::size_t stream) const noexcept;
+	const Format &getFormat(std::size_t stream) const noexcept;
+	const Report &getReport(std::size_t stream) const noexcept;
+
+	// Interleaves count vertices of all streams and fills the reports.
+	void pack(std::size_t count, std::vector<std::uint8_t> &vertices);
+	void apply(VertexArray &vertexArray, GLuint binding = 0) const;
+
+	const Stats &getStats() const noexcept;
+	void resetStats() noexcept;
+
+	static Format getFormat(Encoding encoding, int components);
+	static void encode(Encoding encoding, int components, const float *src, std::size_t srcStride, std::size_t count, void *dst, std::size_t dstStride);
+	static void decode(Encoding encoding, int components, const void *src, std::size_t srcStride, std::size_t count, float *dst, std::size_t dstStride);
+	static Report getReport(Encoding encoding, int components, const float *src, std::size_t srcStride, const void *packed, std::size_t packedStride, std::size_t count);
+	static std::string getSource();
+
+private:
+	struct Stream {
+		GLuint location;
+		Encoding encoding;
+		const float *data;
+		int components;
+		std::size_t stride;
+		GLuint offset;
+		Format format;
+		Report report;
+	};
+
+	// Range and scale of each lane for the normalized integer encodings.
+	struct Range {
+		float low[4];
+		float high[4];
+		float scale[4];
+	};
+
+	VertexPacker(const VertexPacker &) = delete;
+	VertexPacker &operator=(const VertexPacker &) = delete;
+
+	static Range getRange(Encoding encoding) noexcept;
+	static void load(const float *src, int components, float fill, float *v) noexcept;
+	static void quantize(const float *v, const Range &range, std::int32_t *q) noexcept;
+	static void encodeVertex(Encoding encoding, int components, const float *v, std::uint8_t *dst) noexcept;
+	static void decodeVertex(Encoding encoding, int components, const std::uint8_t *src, float *v) noexcept;
+	static void encodeOctahedral(const float *src, std::size_t srcStride, std::size_t count, std::uint8_t *dst, std::size_t dstStride) noexcept;
+	static void encodeOctahedral(float x, float y, float z, std::int32_t *q) noexcept;
+	static std::uint16_t toHalf(float value) noexcept;
+	static float fromHalf(std::uint16_t value) noexcept;
+
+	std::vector<Stream> mStreams;
+	GLsizei mStride;
+	Stats mStats;
+
+};
+
+
+inline double VertexPacker::Stats::getThroughput() const noexcept
+{
+	return (elapsed.count() == 0) ? 0.0 : inputBytes / 1.0e6 / std::chrono::duration<double>(elapsed).count();
+}
+
+inline VertexPacker::VertexPacker() noexcept :
+	mStride(0),
+	mStats()
+{
+}
+
+inline std::size_t VertexPacker::addStream(GLuint location, Encoding encoding, const float *data, int components, std::size_t stride)
+{
+	Stream stream;
+	stream.location = location;
+	stream.encoding = encoding;
+	stream.data = data;
+	stream.components = components;
+	stream.stride = (stride == 0) ? components * sizeof(float) : stride;
+	stream.format = getFormat(encoding, components);
+	stream.offset = static_cast<GLuint>(mStride);
+	stream.report = Report();
+	mStreams.push_back(stream);
+	mStride += stream.format.bytes;
+	return mStreams.size() - 1;
+}
+
+inline void VertexPacker::clear() noexcept
+{
+	mStreams.clear();
+	mStride = 0;
+}
+
+inline GLsizei VertexPacker::getStride() const noexcept
+{
+	return mStride;
+}
+
+inline GLuint VertexPacker::getOffset(std::size_t stream) const noexcept
+{
+	return mStreams[stream].offset;
+}
+
+inline const VertexPacker::Format &VertexPacker::getFormat(std::size_t stream) const noexcept
+{
+	return mStreams[stream].format;
+}
+
+inline const VertexPacker::Report &VertexPacker::getReport(std::size_t stream) const noexcept
+{
+	return mStreams[stream].report;
+}
+
+inline void VertexPacker::pack(std::size_t count, std::vector<std::uint8_t> &vertices)
+{
+	vertices.assign(count * mStride, 0);
+
+	auto start = std::chrono::steady_clock::now();
+	for (const Stream &stream : mStreams) {
+		encode(stream.encoding, stream.components, stream.data, stream.stride, count, vertices.data() + stream.offset, mStride);
+	}
+	mStats.elapsed += std::chrono::steady_clock::now() - start;
+
+	// Not part of the timing, the report decodes everything again.
+	for (Stream &stream : mStreams) {
+		stream.report = getReport(stream.encoding, stream.components, stream.data, stream.stride, vertices.data() + stream.offset, mStride, count);
+		mStats.inputBytes += count * stream.components * sizeof(float);
+	}
+	mStats.vertices += count;
+	mStats.outputBytes += vertices.size();
+}
+
+inline void VertexPacker::apply(VertexArray &vertexArray, GLuint binding) const
+{
+	for (const Stream &stream : mStreams) {
+		vertexArray.enableAttrib(stream.location);
+		vertexArray.setAttribFormat(stream.location, stream.format.size, stream.format.type, stream.format.normalized, stream.offset);
+		vertexArray.setAttribBinding(stream.location, binding);
+	}
+}
+
+inline const VertexPacker::Stats &VertexPacker::getStats() const noexcept
+{
+	return mStats;
+}
+
+inline void VertexPacker::resetStats() noexcept
+{
+	mStats = Stats();
+}
+
+inline VertexPacker::Format VertexPacker::getFormat(Encoding encoding, int components)
+{
+	if (components < 1 || components > 4) {
+		throw OpenGLException("Vertex attributes have one to four components");
+	}
+
+	Format format;
+	format.size = components;
+	format.normalized = GL_TRUE;
+	switch (encoding) {
+	case Encoding::FLOAT:
+		format.type = GL_FLOAT;
+		format.normalized = GL_FALSE;
+		format.bytes = components * 4;
+		break;
+	case Encoding::HALF:
+		format.type = GL_HALF_FLOAT;
+		format.normalized = GL_FALSE;
+		format.bytes = (components + 1) / 2 * 4;
+		break;
+	case Encoding::SNORM16:
+	case Encoding::UNORM16:
+		format.type = (encoding == Encoding::SNORM16) ? GL_SHORT : GL_UNSIGNED_SHORT;
+		format.bytes = (components + 1) / 2 * 4;
+		break;
+	case Encoding::SNORM8:
+	case Encoding::UNORM8:
+		format.type = (encoding == Encoding::SNORM8) ? GL_BYTE : GL_UNSIGNED_BYTE;
+		format.bytes = 4;
+		break;
+	case Encoding::OCTAHEDRAL:
+		if (components != 3) {
+			throw OpenGLException("Octahedral encoding needs three components");
+		}
+		format.size = 2;
+		format.type = GL_SHORT;
+		format.bytes = 4;
+		break;
+	case Encoding::SNORM_2_10_10_10:
+	case Encoding::UNORM_2_10_10_10:
+		if (components < 3) {
+			throw OpenGLException("2_10_10_10 encodings need three or four components");
+		}
+		format.size = 4;
+		format.type = (encoding == Encoding::SNORM_2_10_10_10) ? GL_INT_2_10_10_10_REV : GL_UNSIGNED_INT_2_10_10_10_REV;
+		format.bytes = 4;
+		break;
+	}
+	return format;
+}
+
+inline void VertexPacker::encode(Encoding encoding, int components, const float *src, std::size_t srcStride, std::size_t count, void *dst, std::size_t dstStride)
+{
+	const Format format = getFormat(encoding, components);
+	const std::uint8_t *input = reinterpret_cast<const std::uint8_t*>(src);
+	std::uint8_t *output = static_cast<std::uint8_t*>(dst);
+	if (srcStride == 0) {
+		srcStride = components * sizeof(float);
+	}
+	if (dstStride == 0) {
+		dstStride = format.bytes;
+	}
+
+	if (encoding == Encoding::OCTAHEDRAL) {
+		encodeOctahedral(src, srcStride, count, output, dstStride);
+		return;
+	}
+
+	const bool packed = (encoding == Encoding::SNORM_2_10_10_10 || encoding == Encoding::UNORM_2_10_10_10);
+	const float fill = packed ? 1.0f : 0.0f;
+	alignas(16) float v[4];
+	for (std::size_t i = 0; i < count; ++i) {
+		load(reinterpret_cast<const float*>(input + i * srcStride), components, fill, v);
+		encodeVertex(encoding, components, v, output + i * dstStride);
+	}
+}
+
+inline void VertexPacker::decode(Encoding encoding, int components, const void *src, std::size_t srcStride, std::size_t count, float *dst, std::size_t dstStride)
+{
+	const Format format = getFormat(encoding, components);
+	const std::uint8_t *input = static_cast<const std::uint8_t*>(src);
+	std::uint8_t *output = reinterpret_cast<std::uint8_t*>(dst);
+	if (srcStride == 0) {
+		srcStride = format.bytes;
+	}
+	if (dstStride == 0) {
+		dstStride = components * sizeof(float);
+	}
+
+	float v[4];
+	for (std::size_t i = 0; i < count; ++i) {
+		decodeVertex(encoding, components, input + i * srcStride, v);
+		std::memcpy(output + i * dstStride, v, components * sizeof(float));
+	}
+}
+
+inline VertexPacker::Report VertexPacker::getReport(Encoding encoding, int components, const float *src, std::size_t srcStride, const void *packed, std::size_t packedStride, std::size_t count)
+{
+	const Format format = getFormat(encoding, components);
+	const std::uint8_t *input = reinterpret_cast<const std::uint8_t*>(src);
+	const std::uint8_t *output = static_cast<const std::uint8_t*>(packed);
+	if (srcStride == 0) {
+		srcStride = components * sizeof(float);
+	}
+	if (packedStride == 0) {
+		packedStride = format.bytes;
+	}
+
+	Report report = Report();
+	const Range range = getRange(encoding);
+	const bool normalized = (format.normalized == GL_TRUE && encoding != Encoding::OCTAHEDRAL);
+	double sum = 0.0;
+	std::size_t values = 0;
+	float original[4];
+	float decoded[4];
+	for (std::size_t i = 0; i < count; ++i) {
+		load(reinterpret_cast<const float*>(input + i * srcStride), components, 0.0f, original);
+		decodeVertex(encoding, components, output + i * packedStride, decoded);
+
+		if (encoding == Encoding::OCTAHEDRAL) {
+			// Compare directions, the length is not encoded.
+			float length = std::sqrt(original[0] * original[0] + original[1] * original[1] + original[2] * original[2]);
+			if (length == 0.0f) {
+				continue;
+			}
+			for (int c = 0; c < 3; ++c) {
+				original[c] /= length;
+			}
+		}
+
+		for (int c = 0; c < components; ++c) {
+			if ((normalized && !(original[c] >= range.low[c] && original[c] <= range.high[c]))
+				|| (encoding == Encoding::HALF && !(std::fabs(original[c]) <= 65504.0f))) {
+				++report.clamped;
+				continue;
+			}
+			double error = std::fabs(static_cast<double>(decoded[c]) - original[c]);
+			report.maxError = std::max(report.maxError, error);
+			sum += error * error;
+			++values;
+		}
+	}
+	report.rmsError = (values == 0) ? 0.0 : std::sqrt(sum / values);
+	return report;
+}
+
+inline std::string VertexPacker::getSource()
+{
+	// Inverse of the OCTAHEDRAL encoding; the attribute is a vec2.
+	return "vec3 gtlDecodeOctahedral(vec2 e)\n"
+		"{\n"
+		"\tvec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));\n"
+		"\tfloat t = max(-n.z, 0.0);\n"
+		"\tn.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));\n"
+		"\treturn normalize(n);\n"
+		"}\n";
+}
+
+inline VertexPacker::Range VertexPacker::getRange(Encoding encoding) noexcept
+{
+	float low = 0.0f;
+	float high = 1.0f;
+	float scale = 1.0f;
+	switch (encoding) {
+	case Encoding::SNORM16:
+	case Encoding::OCTAHEDRAL:
+		low = -1.0f;
+		scale = 32767.0f;
+		break;
+	case Encoding::UNORM16:
+		scale = 65535.0f;
+		break;
+	case Encoding::SNORM8:
+		low = -1.0f;
+		scale = 127.0f;
+		break;
+	case Encoding::UNORM8:
+		scale = 255.0f;
+		break;
+	case Encoding::SNORM_2_10_10_10:
+		low = -1.0f;
+		scale = 511.0f;
+		break;
+	case Encoding::UNORM_2_10_10_10:
+		scale = 1023.0f;
+		break;
+	default:
+		low = -std::numeric_limits<float>::max();
+		high = std::numeric_limits<float>::max();
+		break;
+	}
+
+	Range range;
+	for (int c = 0; c < 4; ++c) {
+		range.low[c] = low;
+		range.high[c] = high;
+		range.scale[c] = scale;
+	}
+	if (encoding == Encoding::SNORM_2_10_10_10) {
+		range.scale[3] = 1.0f;
+	} else if (encoding == Encoding::UNORM_2_10_10_10) {
+		range.scale[3] = 3.0f;
+	}
+	return range;
+}
+
+inline void VertexPacker::load(const float *src, int components, float fill, float *v) noexcept
+{
+	// Never reads past the last component, the source may end right there.
+	std::memcpy(v, src, components * sizeof(float));
+	for (int c = components; c < 4; ++c) {
+		v[c] = fill;
+	}
+}
+
+inline void VertexPacker::quantize(const float *v, const Range &range, std::int32_t *q) noexcept
+{
+#ifdef GTL_OGL_VERTEXPACKER_SSE2
+	// NaN ends up at the low end: maxps returns its second operand then.
+	__m128 x = _mm_loadu_ps(v);
+	x = _mm_max_ps(x, _mm_loadu_ps(range.low));
+	x = _mm_min_ps(x, _mm_loadu_ps(range.high));
+	x = _mm_mul_ps(x, _mm_loadu_ps(range.scale));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(q), _mm_cvtps_epi32(x));
+#else
+	for (int c = 0; c < 4; ++c) {
+		float x = (v[c] > range.low[c]) ? v[c] : range.low[c];
+		x = (x < range.high[c]) ? x : range.high[c];
+		q[c] = static_cast<std::int32_t>(std::nearbyint(x * range.scale[c]));
+	}
+#endif
+}
+
+inline void VertexPacker::encodeVertex(Encoding encoding, int components, const float *v, std::uint8_t *dst) noexcept
+{
+	std::int32_t q[4];
+	switch (encoding) {
+	case Encoding::FLOAT:
+		std::memcpy(dst, v, components * sizeof(float));
+		break;
+	case Encoding::HALF: {
+		alignas(16) std::uint16_t h[8];
+#ifdef GTL_OGL_VERTEXPACKER_F16C
+		_mm_store_si128(reinterpret_cast<__m128i*>(h), _mm_cvtps_ph(_mm_loadu_ps(v), _MM_FROUND_TO_NEAREST_INT));
+#else
+		for (int c = 0; c < 4; ++c) {
+			h[c] = toHalf(v[c]);
+		}
+#endif
+		std::memcpy(dst, h, (components + 1) / 2 * 4);
+		break;
+	}
+	case Encoding::SNORM16:
+	case Encoding::UNORM16: {
+		quantize(v, getRange(encoding), q);
+		std::uint16_t s[4];
+		for (int c = 0; c < 4; ++c) {
+			s[c] = static_cast<std::uint16_t>(q[c]);
+		}
+		std::memcpy(dst, s, (components + 1) / 2 * 4);
+		break;
+	}
+	case Encoding::SNORM8:
+	case Encoding::UNORM8:
+		quantize(v, getRange(encoding), q);
+		for (int c = 0; c < 4; ++c) {
+			dst[c] = static_cast<std::uint8_t>(q[c]);
+		}
+		break;
+	case Encoding::OCTAHEDRAL: {
+		encodeOctahedral(v[0], v[1], v[2], q);
+		std::uint16_t s[2] = { static_cast<std::uint16_t>(q[0]), static_cast<std::uint16_t>(q[1]) };
+		std::memcpy(dst, s, sizeof(s));
+		break;
+	}
+	case Encoding::SNORM_2_10_10_10:
+	case Encoding::UNORM_2_10_10_10: {
+		quantize(v, getRange(encoding), q);
+		std::uint32_t bits = (static_cast<std::uint32_t>(q[0]) & 0x3FF)
+			| ((static_cast<std::uint32_t>(q[1]) & 0x3FF) << 10)
+			| ((static_cast<std::uint32_t>(q[2]) & 0x3FF) << 20)
+			| ((static_cast<std::uint32_t>(q[3]) & 0x3) << 30);
+		std::memcpy(dst, &bits, sizeof(bits));
+		break;
+	}
+	}
+}
+
+inline void VertexPacker::decodeVertex(Encoding encoding, int components, const std::uint8_t *src, float *v) noexcept
+{
+	// Conversions of section 2.3.5.1 of the OpenGL 4.5 specification.
+	switch (encoding) {
+	case Encoding::FLOAT:
+		std::memcpy(v, src, components * sizeof(float));
+		break;
+	case Encoding::HALF:
+		for (int c = 0; c < components; ++c) {
+			std::uint16_t h;
+			std::memcpy(&h, src + c * 2, sizeof(h));
+			v[c] = fromHalf(h);
+		}
+		break;
+	case Encoding::SNORM16:
+		for (int c = 0; c < components; ++c) {
+			std::int16_t s;
+			std::memcpy(&s, src + c * 2, sizeof(s));
+			v[c] = std::max(s / 32767.0f, -1.0f);
+		}
+		break;
+	case Encoding::UNORM16:
+		for (int c = 0; c < components; ++c) {
+			std::uint16_t s;
+			std::memcpy(&s, src + c * 2, sizeof(s));
+			v[c] = s / 65535.0f;
+		}
+		break;
+	case Encoding::SNORM8:
+		for (int c = 0; c < components; ++c) {
+			v[c] = std::max(static_cast<std::int8_t>(src[c]) / 127.0f, -1.0f);
+		}
+		break;
+	case Encoding::UNORM8:
+		for (int c = 0; c < components; ++c) {
+			v[c] = src[c] / 255.0f;
+		}
+		break;
+	case Encoding::OCTAHEDRAL: {
+		std::int16_t s[2];
+		std::memcpy(s, src, sizeof(s));
+		float x = std::max(s[0] / 32767.0f, -1.0f);
+		float y = std::max(s[1] / 32767.0f, -1.0f);
+		float z = 1.0f - std::fabs(x) - std::fabs(y);
+		float t = std::max(-z, 0.0f);
+		x += (x >= 0.0f) ? -t : t;
+		y += (y >= 0.0f) ? -t : t;
+		float length = std::sqrt(x * x + y * y + z * z);
+		v[0] = x / length;
+		v[1] = y / length;
+		v[2] = z / length;
+		break;
+	}
+	case Encoding::SNORM_2_10_10_10:
+	case Encoding::UNORM_2_10_10_10: {
+		std::uint32_t bits;
+		std::memcpy(&bits, src, sizeof(bits));
+		const int widths[4] = { 10, 10, 10, 2 };
+		int shift = 0;
+		for (int c = 0; c < components; ++c) {
+			std::uint32_t mask = (1u << widths[c]) - 1;
+			std::uint32_t value = (bits >> shift) & mask;
+			if (encoding == Encoding::UNORM_2_10_10_10) {
+				v[c] = static_cast<float>(value) / mask;
+			} else {
+				// Sign extend, the largest value is mask >> 1.
+				std::int32_t s = static_cast<std::int32_t>(value << (32 - widths[c])) >> (32 - widths[c]);
+				v[c] = std::max(static_cast<float>(s) / (mask >> 1), -1.0f);
+			}
+			shift += widths[c];
+		}
+		break;
+	}
+	}
+}
+
+inline void VertexPacker::encodeOctahedral(const float *src, std::size_t srcStride, std::size_t count, std::uint8_t *dst, std::size_t dstStride) noexcept
+{
+	const std::uint8_t *input = reinterpret_cast<const std::uint8_t*>(src);
+	std::size_t i = 0;
+#ifdef GTL_OGL_VERTEXPACKER_SSE2
+	// Four normals at a time in structure of arrays layout, with the same
+	// operations in the same order as the scalar version.
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 minusOne = _mm_set1_ps(-1.0f);
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+	const __m128 minLength = _mm_set1_ps(std::numeric_limits<float>::min());
+	const __m128 scale = _mm_set1_ps(32767.0f);
+	for (; i + 4 <= count; i += 4) {
+		alignas(16) float x[4];
+		alignas(16) float y[4];
+		alignas(16) float z[4];
+		for (int k = 0; k < 4; ++k) {
+			const float *n = reinterpret_cast<const float*>(input + (i + k) * srcStride);
+			x[k] = n[0];
+			y[k] = n[1];
+			z[k] = n[2];
+		}
+		__m128 vx = _mm_load_ps(x);
+		__m128 vy = _mm_load_ps(y);
+		__m128 vz = _mm_load_ps(z);
+		__m128 l1 = _mm_add_ps(_mm_add_ps(_mm_and_ps(vx, absMask), _mm_and_ps(vy, absMask)), _mm_and_ps(vz, absMask));
+		l1 = _mm_max_ps(l1, minLength);
+		__m128 px = _mm_div_ps(vx, l1);
+		__m128 py = _mm_div_ps(vy, l1);
+		__m128 sx = _mm_cmpge_ps(px, zero);
+		__m128 sy = _mm_cmpge_ps(py, zero);
+		sx = _mm_or_ps(_mm_and_ps(sx, one), _mm_andnot_ps(sx, minusOne));
+		sy = _mm_or_ps(_mm_and_ps(sy, one), _mm_andnot_ps(sy, minusOne));
+		__m128 wx = _mm_mul_ps(_mm_sub_ps(one, _mm_and_ps(py, absMask)), sx);
+		__m128 wy = _mm_mul_ps(_mm_sub_ps(one, _mm_and_ps(px, absMask)), sy);
+		__m128 lower = _mm_cmplt_ps(vz, zero);
+		px = _mm_or_ps(_mm_and_ps(lower, wx), _mm_andnot_ps(lower, px));
+		py = _mm_or_ps(_mm_and_ps(lower, wy), _mm_andnot_ps(lower, py));
+		px = _mm_min_ps(_mm_max_ps(px, minusOne), one);
+		py = _mm_min_ps(_mm_max_ps(py, minusOne), one);
+		__m128i qx = _mm_cvtps_epi32(_mm_mul_ps(px, scale));
+		__m128i qy = _mm_cvtps_epi32(_mm_mul_ps(py, scale));
+		// Interleave to x0 y0 x1 y1 ..., the values fit into 16 bits.
+		alignas(16) std::uint16_t s[8];
+		_mm_store_si128(reinterpret_cast<__m128i*>(s), _mm_packs_epi32(_mm_unpacklo_epi32(qx, qy), _mm_unpackhi_epi32(qx, qy)));
+		for (int k = 0; k < 4; ++k) {
+			std::memcpy(dst + (i + k) * dstStride, s + k * 2, 4);
+		}
+	}
+#endif
+	for (; i < count; ++i) {
+		const float *n = reinterpret_cast<const float*>(input + i * srcStride);
+		std::int32_t q[2];
+		encodeOctahedral(n[0], n[1], n[2], q);
+		std::uint16_t s[2] = { static_cast<std::uint16_t>(q[0]), static_cast<std::uint16_t>(q[1]) };
+		std::memcpy(dst + i * dstStride, s, sizeof(s));
+	}
+}
+
+inline void VertexPacker::encodeOctahedral(float x, float y, float z, std::int32_t *q) noexcept
+{
+	// Project onto the octahedron |x| + |y| + |z| = 1 and fold the lower
+	// half over the diagonals.
+	float l1 = std::fabs(x) + std::fabs(y) + std::fabs(z);
+	l1 = (l1 > std::numeric_limits<float>::min()) ? l1 : std::numeric_limits<float>::min();
+	float px = x / l1;
+	float py = y / l1;
+	if (z < 0.0f) {
+		float wx = (1.0f - std::fabs(py)) * ((px >= 0.0f) ? 1.0f : -1.0f);
+		float wy = (1.0f - std::fabs(px)) * ((py >= 0.0f) ? 1.0f : -1.0f);
+		px = wx;
+		py = wy;
+	}
+	// NaN ends up at -1 like with maxps in the SSE2 version.
+	px = (px > -1.0f) ? px : -1.0f;
+	px = (px < 1.0f) ? px : 1.0f;
+	py = (py > -1.0f) ? py : -1.0f;
+	py = (py < 1.0f) ? py : 1.0f;
+	q[0] = static_cast<std::int32_t>(std::nearbyint(px * 32767.0f));
+	q[1] = static_cast<std::int32_t>(std::nearbyint(py * 32767.0f));
+}
+
+inline std::uint16_t VertexPacker::toHalf(float value) noexcept
+{
+	// Rounds to nearest even like _mm_cvtps_ph().
+	std::uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	const std::uint32_t sign = (bits >> 16) & 0x8000;
+	const std::uint32_t abs = bits & 0x7FFFFFFF;
+	if (abs > 0x7F800000) {
+		return static_cast<std::uint16_t>(sign | 0x7E00 | ((abs >> 13) & 0x3FF));
+	}
+	if (abs >= 0x477FF000) {
+		// Infinity, or at least 65520, which rounds to it.
+		return static_cast<std::uint16_t>(sign | 0x7C00);
+	}
+	if (abs < 0x38800000) {
+		// Subnormal half, or zero below half of the smallest subnormal.
+		if (abs <= 0x33000000) {
+			return static_cast<std::uint16_t>(sign);
+		}
+		const std::uint32_t exponent = abs >> 23;
+		const std::uint32_t mantissa = (abs & 0x7FFFFF) | 0x800000;
+		const std::uint32_t shift = 126 - exponent;
+		std::uint32_t result = mantissa >> shift;
+		const std::uint32_t rest = mantissa & ((1u << shift) - 1);
+		const std::uint32_t half = 1u << (shift - 1);
+		if (rest > half || (rest == half && (result & 1) != 0)) {
+			++result;
+		}
+		return static_cast<std::uint16_t>(sign | result);
+	}
+	return static_cast<std::uint16_t>(sign | ((abs - 0x38000000 + 0xFFF + ((abs >> 13) & 1)) >> 13));
+}
+
+inline float VertexPacker::fromHalf(std::uint16_t value) noexcept
+{
+	const std::uint32_t sign = static_cast<std::uint32_t>(value & 0x8000) << 16;
+	const std::uint32_t exponent = (value >> 10) & 0x1F;
+	const std::uint32_t mantissa = value & 0x3FF;
+	if (exponent == 0) {
+		float result = std::ldexp(static_cast<float>(mantissa), -24);
+		return (sign != 0) ? -result : result;
+	}
+	std::uint32_t bits = sign | (mantissa << 13);
+	bits |= (exponent == 31) ? 0x7F800000 : ((exponent + 112) << 23);
+	float result;
+	std::memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_VERTEXPACKER_H
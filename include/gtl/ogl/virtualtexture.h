@@ -0,0 +1,486 @@
+#ifndef GTL_OGL_VIRTUALTEXTURE_H
+#define GTL_OGL_VIRTUALTEXTURE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "gtl/ogl/buffer.h"
+#include "gtl/ogl/openglexception.h"
+#include "gtl/ogl/readbackqueue.h"
+#include "gtl/ogl/texture.h"
+
+
+namespace gtl {
+namespace ogl {
+
+// 2D sparse texture (ARB_sparse_texture) whose pages are committed on
+// demand. Shaders record the pages they sample in a feedback buffer with the
+// functions from getFeedbackSource(); update() reads the feedback back
+// without stalling, commits missing pages (coarser levels first) and evicts
+// the least recently requested pages once the memory budget is reached. The
+// mip tail is committed once and never evicted. The residency texture holds,
+// for every page of level 0, the finest level which is resident from there
+// down to the mip tail, so shaders can clamp their LOD to committed memory.
+class VirtualTexture final
+{
+public:
+	// Fills a freshly committed region, for example through a TextureStreamer.
+	typedef std::function<void(Texture &texture, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height)> Loader;
+
+	struct Stats {
+		std::uint64_t residentPages;
+		std::uint64_t budgetPages;
+		std::uint64_t requestedPages;
+		std::uint64_t commits;
+		std::uint64_t decommits;
+		std::uint64_t thrashedCommits;
+
+		double getThrashRate() const noexcept;
+	};
+
+	VirtualTexture(GLenum internalformat, GLsizei width, GLsizei height, GLsizei levels, std::size_t budget, GLuint feedbackLatency = 2);
+
+	void setLoader(const Loader &loader);
+	void update();
+
+	std::string getFeedbackSource(GLuint binding) const;
+	void bindFeedback(GLuint binding) const;
+
+	Texture &getTexture() noexcept;
+	const Texture &getTexture() const noexcept;
+	const Texture &getResidencyTexture() const noexcept;
+	GLsizei getPageWidth() const noexcept;
+	GLsizei getPageHeight() const noexcept;
+	bool isResident(GLint level, GLint x, GLint y) const noexcept;
+
+	std::size_t getBudget() const noexcept;
+	void setBudget(std::size_t budget) noexcept;
+	std::size_t getMaxCommitsPerFrame() const noexcept;
+	void setMaxCommitsPerFrame(std::size_t count) noexcept;
+	std::uint64_t getThrashWindow() const noexcept;
+	void setThrashWindow(std::uint64_t frames) noexcept;
+
+	const Stats &getStats() const noexcept;
+	void resetStats() noexcept;
+
+	static bool isSupported() noexcept;
+
+private:
+	// ARB_sparse_texture chooses virtual page sizes of 64 KiB.
+	static const std::size_t PAGE_BYTES = 65536;
+	static const std::uint64_t NEVER = ~static_cast<std::uint64_t>(0);
+
+	struct Level {
+		GLsizei width;
+		GLsizei height;
+		GLint pagesX;
+		GLint pagesY;
+		std::uint32_t offset;
+	};
+
+	struct Page {
+		GLint level;
+		GLint x;
+		GLint y;
+		std::uint64_t lastRequested;
+		std::uint64_t evicted;
+		std::list<std::uint32_t>::iterator lru;
+		bool resident;
+	};
+
+	VirtualTexture(const VirtualTexture &) = delete;
+	VirtualTexture &operator=(const VirtualTexture &) = delete;
+
+	void process(const std::uint32_t *feedback);
+	void request(std::uint32_t index, std::vector<std::uint32_t> &missing);
+	bool commit(std::uint32_t index);
+	void evict(std::uint32_t index);
+	void setCommitment(const Page &page, bool commit);
+	void updateResidency();
+
+	Texture mTexture;
+	Texture mResidency;
+	Buffer mFeedback;
+	ReadbackQueue mReadbackQueue;
+	std::deque<ReadbackQueue::Readback> mReadbacks;
+	Loader mLoader;
+
+	std::vector<Level> mLevels;
+	std::vector<Page> mPages;
+	std::list<std::uint32_t> mLru;
+	std::vector<GLuint> mResidencyData;
+	GLint mPageWidth;
+	GLint mPageHeight;
+	GLint mSparseLevels;
+	std::uint64_t mFrame;
+	std::size_t mBudgetPages;
+	std::size_t mMaxCommitsPerFrame;
+	std::uint64_t mThrashWindow;
+	bool mResidencyChanged;
+	Stats mStats;
+
+};
+
+
+inline double VirtualTexture::Stats::getThrashRate() const noexcept
+{
+	return (commits == 0) ? 0.0 : static_cast<double>(thrashedCommits) / commits;
+}
+
+inline VirtualTexture::VirtualTexture(GLenum internalformat, GLsizei width, GLsizei height, GLsizei levels, std::size_t budget, GLuint feedbackLatency) :
+	mReadbackQueue(feedbackLatency),
+	mPageWidth(0),
+	mPageHeight(0),
+	mSparseLevels(0),
+	mFrame(0),
+	mBudgetPages(budget / PAGE_BYTES),
+	mMaxCommitsPerFrame(64),
+	mThrashWindow(60),
+	mResidencyChanged(true),
+	mStats()
+{
+	if (!isSupported()) {
+		throw OpenGLException("Sparse textures are not supported");
+	}
+
+	glGetInternalformativ(GL_TEXTURE_2D, internalformat, GL_VIRTUAL_PAGE_SIZE_X_ARB, 1, &mPageWidth);
+	glGetInternalformativ(GL_TEXTURE_2D, internalformat, GL_VIRTUAL_PAGE_SIZE_Y_ARB, 1, &mPageHeight);
+	if (mPageWidth <= 0 || mPageHeight <= 0 || width % mPageWidth != 0 || height % mPageHeight != 0) {
+		throw OpenGLException("Virtual texture size is not a multiple of the page size");
+	}
+
+	mTexture.create(Texture::Target::T_2D);
+	mTexture.setParameter(GL_TEXTURE_SPARSE_ARB, GL_TRUE);
+	mTexture.setParameter(GL_VIRTUAL_PAGE_SIZE_INDEX_ARB, 0);
+	mTexture.storage(levels, internalformat, width, height);
+	mTexture.getParameter(GL_NUM_SPARSE_LEVELS_ARB, &mSparseLevels);
+	mSparseLevels = std::min<GLint>(mSparseLevels, levels);
+
+	std::uint32_t pageCount = 0;
+	for (GLint level = 0; level < levels; ++level) {
+		Level info;
+		info.width = std::max<GLsizei>(width >> level, 1);
+		info.height = std::max<GLsizei>(height >> level, 1);
+		info.pagesX = (info.width + mPageWidth - 1) / mPageWidth;
+		info.pagesY = (info.height + mPageHeight - 1) / mPageHeight;
+		info.offset = pageCount;
+		mLevels.push_back(info);
+		if (level >= mSparseLevels) {
+			continue;
+		}
+		for (GLint y = 0; y < info.pagesY; ++y) {
+			for (GLint x = 0; x < info.pagesX; ++x) {
+				Page page = { level, x, y, NEVER, NEVER, mLru.end(), false };
+				mPages.push_back(page);
+			}
+		}
+		pageCount += info.pagesX * info.pagesY;
+	}
+
+	if (mSparseLevels < levels) {
+		// Committing any part of the mip tail commits all of it.
+		const Level &tail = mLevels[mSparseLevels];
+		mTexture.pageCommitment(mSparseLevels, 0, 0, 0, tail.width, tail.height, 1, true);
+	}
+
+	// One bit per page, set with atomicOr by the shaders.
+	std::size_t words = std::max<std::size_t>((pageCount + 31) / 32, 1);
+	mFeedback.create();
+	mFeedback.storage(words * sizeof(std::uint32_t), nullptr, GL_DYNAMIC_STORAGE_BIT);
+	const GLuint zero = 0;
+	mFeedback.clearData(GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+
+	mResidency.create(Texture::Target::T_2D);
+	mResidency.storage(1, GL_R8UI, mLevels[0].pagesX, mLevels[0].pagesY);
+	mResidency.setParameter(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	mResidency.setParameter(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	mResidencyData.resize(mLevels[0].pagesX * mLevels[0].pagesY);
+	updateResidency();
+}
+
+inline void VirtualTexture::setLoader(const Loader &loader)
+{
+	mLoader = loader;
+}
+
+inline void VirtualTexture::update()
+{
+	// Make the shader writes of this frame visible to the copy and the clear.
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	std::size_t words = std::max<std::size_t>((mPages.size() + 31) / 32, 1);
+	mReadbacks.push_back(mReadbackQueue.read(mFeedback, 0, words * sizeof(std::uint32_t)));
+	const GLuint zero = 0;
+	mFeedback.clearData(GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+	mReadbackQueue.endFrame();
+
+	while (!mReadbacks.empty() && mReadbacks.front().isReady()) {
+		process(static_cast<const std::uint32_t*>(mReadbacks.front().getData()));
+		mReadbacks.pop_front();
+	}
+	if (mResidencyChanged) {
+		updateResidency();
+	}
+	++mFrame;
+}
+
+inline std::string VirtualTexture::getFeedbackSource(GLuint binding) const
+{
+	// Page tables of the sparse levels: pages in x and y, index of the first page.
+	std::string levels;
+	for (GLint level = 0; level < std::max<GLint>(mSparseLevels, 1); ++level) {
+		const Level &info = mLevels[level];
+		levels += (level == 0) ? "" : ", ";
+		levels += "uvec3(" + std::to_string(info.pagesX) + "u, " + std::to_string(info.pagesY) + "u, " + std::to_string(info.offset) + "u)";
+	}
+	std::string count = std::to_string(std::max<GLint>(mSparseLevels, 1));
+
+	return "layout(std430, binding = " + std::to_string(binding) + ") buffer GtlVirtualTextureFeedback {\n"
+		"\tuint gtlVirtualTextureFeedback[];\n"
+		"};\n"
+		"const uvec3 gtlVirtualTextureLevels[" + count + "] = uvec3[](" + levels + ");\n"
+		"\n"
+		"void gtlRequestPage(vec2 uv, float lod) {\n"
+		"\tif (" + std::to_string(mSparseLevels) + " == 0 || lod >= " + std::to_string(mSparseLevels) + ".0) {\n"
+		"\t\treturn;\n"
+		"\t}\n"
+		"\tuvec3 level = gtlVirtualTextureLevels[uint(max(lod, 0.0))];\n"
+		"\tuvec2 page = min(uvec2(fract(uv) * vec2(level.xy)), level.xy - 1u);\n"
+		"\tuint index = level.z + page.y * level.x + page.x;\n"
+		"\tatomicOr(gtlVirtualTextureFeedback[index >> 5], 1u << (index & 31u));\n"
+		"}\n"
+		"\n"
+		"float gtlClampLod(usampler2D residency, vec2 uv, float lod) {\n"
+		"\tivec2 page = ivec2(fract(uv) * vec2(textureSize(residency, 0)));\n"
+		"\treturn max(lod, float(texelFetch(residency, page, 0).r));\n"
+		"}\n";
+}
+
+inline void VirtualTexture::bindFeedback(GLuint binding) const
+{
+	mFeedback.bindBase(Buffer::Target::SHADER_STORAGE, binding);
+}
+
+inline Texture &VirtualTexture::getTexture() noexcept
+{
+	return mTexture;
+}
+
+inline const Texture &VirtualTexture::getTexture() const noexcept
+{
+	return mTexture;
+}
+
+inline const Texture &VirtualTexture::getResidencyTexture() const noexcept
+{
+	return mResidency;
+}
+
+inline GLsizei VirtualTexture::getPageWidth() const noexcept
+{
+	return mPageWidth;
+}
+
+inline GLsizei VirtualTexture::getPageHeight() const noexcept
+{
+	return mPageHeight;
+}
+
+inline bool VirtualTexture::isResident(GLint level, GLint x, GLint y) const noexcept
+{
+	if (level >= mSparseLevels) {
+		return true;
+	}
+	const Level &info = mLevels[level];
+	return mPages[info.offset + y * info.pagesX + x].resident;
+}
+
+inline std::size_t VirtualTexture::getBudget() const noexcept
+{
+	return mBudgetPages * PAGE_BYTES;
+}
+
+inline void VirtualTexture::setBudget(std::size_t budget) noexcept
+{
+	mBudgetPages = budget / PAGE_BYTES;
+}
+
+inline std::size_t VirtualTexture::getMaxCommitsPerFrame() const noexcept
+{
+	return mMaxCommitsPerFrame;
+}
+
+inline void VirtualTexture::setMaxCommitsPerFrame(std::size_t count) noexcept
+{
+	mMaxCommitsPerFrame = count;
+}
+
+inline std::uint64_t VirtualTexture::getThrashWindow() const noexcept
+{
+	return mThrashWindow;
+}
+
+inline void VirtualTexture::setThrashWindow(std::uint64_t frames) noexcept
+{
+	mThrashWindow = frames;
+}
+
+inline const VirtualTexture::Stats &VirtualTexture::getStats() const noexcept
+{
+	return mStats;
+}
+
+inline void VirtualTexture::resetStats() noexcept
+{
+	std::uint64_t resident = mStats.residentPages;
+	mStats = Stats();
+	mStats.residentPages = resident;
+}
+
+inline bool VirtualTexture::isSupported() noexcept
+{
+	return GLEW_ARB_sparse_texture;
+}
+
+inline void VirtualTexture::process(const std::uint32_t *feedback)
+{
+	std::vector<std::uint32_t> missing;
+	std::uint64_t requested = 0;
+	std::size_t words = (mPages.size() + 31) / 32;
+	for (std::size_t i = 0; i < words; ++i) {
+		for (std::uint32_t bits = feedback[i], bit = 0; bits != 0; bits >>= 1, ++bit) {
+			if ((bits & 1) != 0) {
+				request(static_cast<std::uint32_t>(i * 32 + bit), missing);
+				++requested;
+			}
+		}
+	}
+	mStats.requestedPages = requested;
+	mStats.budgetPages = mBudgetPages;
+
+	// Coarser pages first: they are the fallback for the finer ones.
+	std::sort(missing.begin(), missing.end(), [this](std::uint32_t a, std::uint32_t b) {
+		return mPages[a].level > mPages[b].level;
+	});
+	std::size_t commits = std::min(missing.size(), mMaxCommitsPerFrame);
+	for (std::size_t i = 0; i < commits; ++i) {
+		if (!commit(missing[i])) {
+			break;
+		}
+	}
+
+	// Shrink if the budget was lowered.
+	while (mLru.size() > mBudgetPages) {
+		evict(mLru.back());
+	}
+}
+
+inline void VirtualTexture::request(std::uint32_t index, std::vector<std::uint32_t> &missing)
+{
+	// A page needs its coarser ancestors as fallback.
+	for (;;) {
+		Page &page = mPages[index];
+		if (page.lastRequested == mFrame) {
+			return;
+		}
+		page.lastRequested = mFrame;
+		if (page.resident) {
+			mLru.splice(mLru.begin(), mLru, page.lru);
+		} else {
+			missing.push_back(index);
+		}
+
+		GLint level = page.level + 1;
+		if (level >= mSparseLevels) {
+			return;
+		}
+		const Level &parent = mLevels[level];
+		index = parent.offset + std::min(page.y / 2, parent.pagesY - 1) * parent.pagesX + std::min(page.x / 2, parent.pagesX - 1);
+	}
+}
+
+inline bool VirtualTexture::commit(std::uint32_t index)
+{
+	if (mLru.size() >= mBudgetPages) {
+		// Never evict what the current feedback asked for.
+		if (mLru.empty() || mPages[mLru.back()].lastRequested == mFrame) {
+			return false;
+		}
+		evict(mLru.back());
+	}
+
+	Page &page = mPages[index];
+	setCommitment(page, true);
+	page.resident = true;
+	mLru.push_front(index);
+	page.lru = mLru.begin();
+	if (page.evicted != NEVER && mFrame - page.evicted <= mThrashWindow) {
+		++mStats.thrashedCommits;
+	}
+	++mStats.commits;
+	mStats.residentPages = mLru.size();
+	mResidencyChanged = true;
+
+	if (mLoader) {
+		const Level &info = mLevels[page.level];
+		GLint x = page.x * mPageWidth;
+		GLint y = page.y * mPageHeight;
+		mLoader(mTexture, page.level, x, y, std::min<GLsizei>(mPageWidth, info.width - x), std::min<GLsizei>(mPageHeight, info.height - y));
+	}
+	return true;
+}
+
+inline void VirtualTexture::evict(std::uint32_t index)
+{
+	Page &page = mPages[index];
+	setCommitment(page, false);
+	page.resident = false;
+	page.evicted = mFrame;
+	mLru.erase(page.lru);
+	page.lru = mLru.end();
+	++mStats.decommits;
+	mStats.residentPages = mLru.size();
+	mResidencyChanged = true;
+}
+
+inline void VirtualTexture::setCommitment(const Page &page, bool commit)
+{
+	const Level &info = mLevels[page.level];
+	GLint x = page.x * mPageWidth;
+	GLint y = page.y * mPageHeight;
+	// Regions have to be whole pages or end at the border of the level.
+	mTexture.pageCommitment(page.level, x, y, 0, std::min<GLsizei>(mPageWidth, info.width - x), std::min<GLsizei>(mPageHeight, info.height - y), 1, commit);
+}
+
+inline void VirtualTexture::updateResidency()
+{
+	const Level &base = mLevels[0];
+	for (GLint y = 0; y < base.pagesY; ++y) {
+		for (GLint x = 0; x < base.pagesX; ++x) {
+			GLint finest = mSparseLevels;
+			while (finest > 0) {
+				const Level &info = mLevels[finest - 1];
+				GLint px = std::min(x >> (finest - 1), info.pagesX - 1);
+				GLint py = std::min(y >> (finest - 1), info.pagesY - 1);
+				if (!mPages[info.offset + py * info.pagesX + px].resident) {
+					break;
+				}
+				--finest;
+			}
+			mResidencyData[y * base.pagesX + x] = static_cast<GLuint>(finest);
+		}
+	}
+	mResidency.setSubImage(0, 0, 0, base.pagesX, base.pagesY, GL_RED_INTEGER, GL_UNSIGNED_INT, mResidencyData.data());
+	mResidencyChanged = false;
+}
+
+} // namespace ogl
+} // namespace gtl
+
+#endif // GTL_OGL_VIRTUALTEXTURE_H